@@ -1,4 +1,7 @@
+#if _MSC_VER
 #pragma warning(push, 1)
+#endif
+#if _WIN32
 #define COBJMACROS
 #define NOMINMAX
 #define WIN32_LEAN_AND_MEAN
@@ -6,16 +9,22 @@
 #include <d3d11.h>
 #include <dxgi1_3.h>
 #include <dxgidebug.h>
+#endif
 
-#include <intrin.h> // ceil, float, min, max
-#include <stdlib.h> // srand, rand
+#include <stdlib.h> // calloc, free
 #include <stdio.h> // snprintf
+#include <string.h> // strlen
 #include <time.h>
 
 #include "kdtf_font.h"
+#if _MSC_VER
 #pragma warning(pop)
+#endif
 
 #include "base.h"
+#include "profile.h"
+#include "simd_math.h"
+#include "parallel.h"
 
 
 // COMPLETE:
@@ -36,6 +45,7 @@
 // - On collision with bullet, split meteor into a random number of
 //   smaller meteors with random radius all in opposite directions
 // - On collision with ship, game over
+// - Draw bitmaps for the ship, bullet, and meteor
 
 // TODO:
 // - Add Pause menu with quit and restart buttons
@@ -43,7 +53,6 @@
 // - Generate outline for asteroid
 //     * Select 8 points on the unit circle and give them
 //       different lengths, making a jagged appearance.
-// - Draw bitmaps for the ship, bullet, and meteor
 
 #define DEFAULT_WINDOW_WIDTH 1280
 #define DEFAULT_WINDOW_HEIGHT 960
@@ -59,7 +68,10 @@ static i32 MouseY = 0;
 static b8 MouseLeftButtonDown = 0;
 static i32 gShouldCloseWindow = 0;
 static b8 gPaused = false;
+static b8 gShowProfileOverlay = false;
+static b8 gFillShip = false;
 static KDTF_Font gFont = {0};
+static JobSystem gJobs; // shared by everything that runs on more than one thread
 
 typedef struct {
 	f32 x, y;
@@ -80,7 +92,7 @@ f32 my_max(f32 a, f32 b) {
 	__m128 operand_1 = _mm_load1_ps(&a);
 	__m128 operand_2 = _mm_load1_ps(&b);
 	__m128 max = _mm_max_ps(operand_1, operand_2);
-	f32 result = *max.m128_f32;
+	f32 result = _mm_cvtss_f32(max);
 	return result;
 }
 
@@ -88,7 +100,7 @@ f32 my_min(f32 a, f32 b) {
 	__m128 operand_1 = _mm_load1_ps(&a);
 	__m128 operand_2 = _mm_load1_ps(&b);
 	__m128 min = _mm_min_ps(operand_1, operand_2);
-	f32 result = *min.m128_f32;
+	f32 result = _mm_cvtss_f32(min);
 	return result;
 }
 
@@ -104,7 +116,7 @@ i32 my_ceil(f32 value) {
 	__m128 operand = _mm_load1_ps(&value);
 	__m128 ceil_value = _mm_ceil_ps(operand);
 	__m128i ceil_int = _mm_cvtps_epi32(ceil_value);
-	i32 result = *ceil_int.m128i_i32;
+	i32 result = _mm_cvtsi128_si32(ceil_int);
 	return result;
 }
 
@@ -112,7 +124,7 @@ i32 my_floor(f32 value) {
 	__m128 operand = _mm_load1_ps(&value);
 	__m128 floor_value = _mm_floor_ps(operand);
 	__m128i floor_int = _mm_cvtps_epi32(floor_value);
-	i32 result = *floor_int.m128i_i32;
+	i32 result = _mm_cvtsi128_si32(floor_int);
 	return result;
 }
 
@@ -143,44 +155,33 @@ static int gShootMissile = 0;
 f32 my_sqrt(f32 value) {
 	__m128 operand = _mm_load1_ps(&value);
 	__m128 square_root = _mm_sqrt_ps(operand);
-	f32 result = *square_root.m128_f32;
+	f32 result = _mm_cvtss_f32(square_root);
 	return result;
 }
 
+// NOTE: Polynomial approximations from simd_math.h, the same on every
+//       compiler and bit for bit the same as the batched versions
 f32 my_acos(f32 value) {
-	__m128 operand = _mm_load1_ps(&value);
-	__m128 inverse_cosine = _mm_acos_ps(operand);
-	f32 result = *inverse_cosine.m128_f32;
-	return result;
+	return Math_Acos(value);
 }
 
 f32 my_cos(f32 value) {
-	__m128 operand = _mm_load1_ps(&value);
-	__m128 cosine = _mm_cos_ps(operand);
-	f32 result = *cosine.m128_f32;
-	return result;
+	return Math_Cos(value);
 }
 
 f32 my_sin(f32 value) {
-	__m128 operand = _mm_load1_ps(&value);
-	__m128 sine = _mm_sin_ps(operand);
-	f32 result = *sine.m128_f32;
-	return result;
+	return Math_Sin(value);
 }
 
 f32 my_atan2(f32 y, f32 x) {
-	__m128 operand_y = _mm_load1_ps(&y);
-	__m128 operand_x = _mm_load1_ps(&x);
-	__m128 arctan_2 = _mm_atan2_ps(operand_y, operand_x);
-	f32 result = *arctan_2.m128_f32;
-	return result;
+	return Math_Atan2(y, x);
 }
 
 i32 RoundNearest(f32 value) {
 	__m128 operand = _mm_load1_ps(&value);
 	__m128 round_ps = _mm_round_ps(operand, _MM_FROUND_TO_NEAREST_INT |_MM_FROUND_NO_EXC);
 	__m128i rounded = _mm_cvtps_epi32(round_ps);
-	i32 result = *rounded.m128i_i32;
+	i32 result = _mm_cvtsi128_si32(rounded);
 	return result;
 }
 
@@ -218,6 +219,10 @@ i32 Max2(i32 x, i32 y) {
 	return ((x > y) * x) + ((y > x) * y) + ((y == x) * x);
 }
 
+#if _WIN32
+// F5 asks the main loop to start or save an input recording
+static b8 gToggleInputRecording = false;
+
 LRESULT CALLBACK WindowCallback(
 	HWND window_handle,
 	UINT msg,
@@ -259,6 +264,27 @@ LRESULT CALLBACK WindowCallback(
 					}
 					return 0;
 				} break;
+
+				case VK_F3: {
+					if (pressed) {
+						gShowProfileOverlay = !gShowProfileOverlay;
+					}
+					return 0;
+				} break;
+
+				case VK_F4: {
+					if (pressed) {
+						gFillShip = !gFillShip;
+					}
+					return 0;
+				} break;
+
+				case VK_F5: {
+					if (pressed) {
+						gToggleInputRecording = 1;
+					}
+					return 0;
+				} break;
 			}
 			return DefWindowProcW(window_handle, msg, wParam, lParam);
 		} break;
@@ -279,6 +305,7 @@ LRESULT CALLBACK WindowCallback(
 
 	return DefWindowProcW(window_handle, msg, wParam, lParam);
 }
+#endif
 
 typedef struct {
 	i32 min_x, max_x;
@@ -311,46 +338,132 @@ Extents CalculateExtents(Point *points, i32 point_count) {
 	return result;
 }
 
-void RotatePoints(Point *points, i32 point_count, Point center_of_rotation, f32 rotation_amount) {
-	for (i32 i = 0; i < point_count; i++) {
-		Point *p = points + i;
+//////////////////////////////////////////////////////////////////////////////////////
+/// Transforms
+///
+/// One 2x3 matrix per entity takes its model points to where they are drawn:
+///   x' = (x * m00) + (y * m01) + tx
+///   y' = (x * m10) + (y * m11) + ty
+/// The sine and cosine are paid once per entity, every point after that is
+/// four multiplies and four adds, done 4 (SSE) or 8 (AVX2) points at a time.
 
-		// Orient the points so that they are relative to the point of rotation
-		Point reoriented = { p->x - center_of_rotation.x, p->y - center_of_rotation.y };
-		f32 radius = my_sqrt(((reoriented.x * reoriented.x) + (reoriented.y * reoriented.y)));
+typedef struct {
+	f32 m00, m01, tx;
+	f32 m10, m11, ty;
+} Transform2D;
+
+Transform2D MakeTranslation(f32 x, f32 y) {
+	Transform2D result = {0};
+	result.m00 = 1.0f;
+	result.m11 = 1.0f;
+	result.tx = x;
+	result.ty = y;
+	return result;
+}
 
-		// Calculate the angle that the points are currently at
-		//   NOTE: Using atan2 because it takes the sign of the coordinates into account
-		//         giving the actual angle. Other trignometric functions are only defined
-		//         for specific angle ranges, so some offset needs to be applied. atan2
-		//         takes does the offset for us so we don't have to worry about it.
-		f32 theta = my_atan2(reoriented.y, reoriented.x);
-		
-		// Calculate new x component using with x = r * cos(original_angle + additional_rotation)
-		p->x = radius * my_cos(theta + rotation_amount);
-		// // Calculate new y component using with y = r * sin(original_angle + additional_rotation)
-		p->y = radius * my_sin(theta + rotation_amount);
+// Rotates by rotation_radians around center, then moves by (x, y)
+Transform2D MakeTransform(f32 rotation_radians, Point center, f32 x, f32 y) {
+	f32 sine, cosine;
+	Math_SinCos(rotation_radians, &sine, &cosine);
+
+	Transform2D result = {0};
+	result.m00 = cosine;
+	result.m01 = -sine;
+	result.m10 = sine;
+	result.m11 = cosine;
+	// center goes to itself, then everything moves by (x, y)
+	result.tx = (center.x - ((center.x * cosine) - (center.y * sine))) + x;
+	result.ty = (center.y - ((center.x * sine) + (center.y * cosine))) + y;
+	return result;
+}
 
-		// Orient the resulting points so that they are relative to the original origin point
-		p->x += center_of_rotation.x;
-		p->y += center_of_rotation.y;
+// In place on separate x and y arrays
+void TransformVertices(Transform2D *transform, f32 *xs, f32 *ys, i32 count) {
+	i32 i = 0;
+#if __AVX2__
+	__m256 m00_8 = _mm256_set1_ps(transform->m00);
+	__m256 m01_8 = _mm256_set1_ps(transform->m01);
+	__m256 m10_8 = _mm256_set1_ps(transform->m10);
+	__m256 m11_8 = _mm256_set1_ps(transform->m11);
+	__m256 tx_8 = _mm256_set1_ps(transform->tx);
+	__m256 ty_8 = _mm256_set1_ps(transform->ty);
+	for (; (i + 8) <= count; i += 8) {
+		__m256 x = _mm256_loadu_ps(xs + i);
+		__m256 y = _mm256_loadu_ps(ys + i);
+		_mm256_storeu_ps(xs + i, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, m00_8), _mm256_mul_ps(y, m01_8)), tx_8));
+		_mm256_storeu_ps(ys + i, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, m10_8), _mm256_mul_ps(y, m11_8)), ty_8));
+	}
+#endif
+	__m128 m00 = _mm_set1_ps(transform->m00);
+	__m128 m01 = _mm_set1_ps(transform->m01);
+	__m128 m10 = _mm_set1_ps(transform->m10);
+	__m128 m11 = _mm_set1_ps(transform->m11);
+	__m128 tx = _mm_set1_ps(transform->tx);
+	__m128 ty = _mm_set1_ps(transform->ty);
+	for (; (i + 4) <= count; i += 4) {
+		__m128 x = _mm_loadu_ps(xs + i);
+		__m128 y = _mm_loadu_ps(ys + i);
+		_mm_storeu_ps(xs + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, m00), _mm_mul_ps(y, m01)), tx));
+		_mm_storeu_ps(ys + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, m10), _mm_mul_ps(y, m11)), ty));
+	}
+	for (; i < count; i++) {
+		f32 x = xs[i];
+		f32 y = ys[i];
+		xs[i] = ((x * transform->m00) + (y * transform->m01)) + transform->tx;
+		ys[i] = ((x * transform->m10) + (y * transform->m11)) + transform->ty;
 	}
 }
 
-void TranslatePoints(Point *points, i32 point_count, f32 translation_x, f32 translation_y) {
-	for (i32 i = 0; i < point_count; i++) {
+// In place on x, y pairs. The pairs are split into x and y registers, run
+// through the same math as TransformVertices and put back together, so both
+// give the same bits.
+void TransformPoints(Transform2D *transform, Point *points, i32 count) {
+	f32 *coordinates = (f32*)points;
+	i32 i = 0;
+#if __AVX2__
+	__m256 m00_8 = _mm256_set1_ps(transform->m00);
+	__m256 m01_8 = _mm256_set1_ps(transform->m01);
+	__m256 m10_8 = _mm256_set1_ps(transform->m10);
+	__m256 m11_8 = _mm256_set1_ps(transform->m11);
+	__m256 tx_8 = _mm256_set1_ps(transform->tx);
+	__m256 ty_8 = _mm256_set1_ps(transform->ty);
+	for (; (i + 8) <= count; i += 8) {
+		__m256 a = _mm256_loadu_ps(coordinates + (i * 2));
+		__m256 b = _mm256_loadu_ps(coordinates + (i * 2) + 8);
+		// points 0 1 4 5 | 2 3 6 7, unpacking puts them back in order
+		__m256 x = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+		__m256 y = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+		__m256 new_x = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, m00_8), _mm256_mul_ps(y, m01_8)), tx_8);
+		__m256 new_y = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, m10_8), _mm256_mul_ps(y, m11_8)), ty_8);
+		_mm256_storeu_ps(coordinates + (i * 2), _mm256_unpacklo_ps(new_x, new_y));
+		_mm256_storeu_ps(coordinates + (i * 2) + 8, _mm256_unpackhi_ps(new_x, new_y));
+	}
+#endif
+	__m128 m00 = _mm_set1_ps(transform->m00);
+	__m128 m01 = _mm_set1_ps(transform->m01);
+	__m128 m10 = _mm_set1_ps(transform->m10);
+	__m128 m11 = _mm_set1_ps(transform->m11);
+	__m128 tx = _mm_set1_ps(transform->tx);
+	__m128 ty = _mm_set1_ps(transform->ty);
+	for (; (i + 4) <= count; i += 4) {
+		__m128 a = _mm_loadu_ps(coordinates + (i * 2));
+		__m128 b = _mm_loadu_ps(coordinates + (i * 2) + 4);
+		__m128 x = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+		__m128 y = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+		__m128 new_x = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, m00), _mm_mul_ps(y, m01)), tx);
+		__m128 new_y = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, m10), _mm_mul_ps(y, m11)), ty);
+		_mm_storeu_ps(coordinates + (i * 2), _mm_unpacklo_ps(new_x, new_y));
+		_mm_storeu_ps(coordinates + (i * 2) + 4, _mm_unpackhi_ps(new_x, new_y));
+	}
+	for (; i < count; i++) {
 		Point *p = points + i;
-		p->x += translation_x;
-		p->y += translation_y;
+		f32 x = p->x;
+		f32 y = p->y;
+		p->x = ((x * transform->m00) + (y * transform->m01)) + transform->tx;
+		p->y = ((x * transform->m10) + (y * transform->m11)) + transform->ty;
 	}
 }
 
-typedef struct {
-	Point points[4];
-	Vec2 direction;
-	i32 live;
-} Missile;
-
 f32 DotProduct(Vec2 v1, Vec2 v2) {
 	return (v1.x * v2.x) + (v1.y * v2.y);
 }
@@ -359,417 +472,1953 @@ f32 VectorLength(Vec2 v) {
 	return DotProduct(v, v);
 }
 
+//////////////////////////////////////////////////////////////////////////////////////
+/// Entity Pools
+///
+/// Missiles and meteors live in pools of parallel arrays, one per field, so
+/// the per step kernels stream through only the fields they use, 4 (SSE) or
+/// 8 (AVX2) entities at a time. The live entities are always the first count
+/// of each array. Spawning writes the one at count, removing moves the last
+/// one into the hole, so both are O(1) and every loop, SIMD or not, only ever
+/// touches live entities. [count, capacity) is the free list.
+///
+/// An index is only good until the next removal: nothing holds on to one
+/// across steps.
+
+#define MISSILE_CORNER_COUNT 4
+
+// NOTE: The grid is a spatial hash of the meteor centers. Cell coordinates
+//       wrap around METEOR_GRID_SIZE, so meteors hanging off any edge of the
+//       screen and surfaces bigger than the grid still hash somewhere, and a
+//       query just sees a few more meteors to test.
+#define METEOR_GRID_CELL_SIZE 64 // pixels, a bit more than the biggest meteor radius
+#define METEOR_GRID_SIZE 32 // cells on a side, a power of 2
+#define METEOR_GRID_CELL_COUNT (METEOR_GRID_SIZE * METEOR_GRID_SIZE)
+
 typedef struct {
-	Vec2 pos;
-	Vec2 direction;
-	i32 speed;
+	i32 *cell_starts; // the meteors in cell c are meteors[cell_starts[c], cell_starts[c + 1])
+	i32 *meteors; // indices, grouped by cell
+	i32 *cells; // meteor -> its cell
+	i32 *candidates; // filled in by MeteorGrid_Gather
+	// scratch for MissilePool_FindHit, one per candidate
+	f32 *candidate_x;
+	f32 *candidate_y;
+	f32 *candidate_radius;
+	f32 *candidate_times;
+	u32 *candidate_hits; // a bit per candidate, for PointsInsideCircles
+	f32 max_radius; // of the meteors in the grid
+} MeteorGrid;
+
+// A missile reaching a meteor, see MissilePool_FindHit
+typedef struct {
+	f32 time; // how far along its last step the missile was, 0 to 1
+	i32 missile;
+	i32 meteor; // -1 once it turns out there's nothing left to hit
+	// the meteor, kept for splitting it after it's removed
+	Vec2 position;
 	i32 radius;
-	b8 active;
-} Meteor;
+	i32 speed;
+} MissileHit;
 
 typedef struct {
-	u32 *pixels;
-	i32 width;
-	i32 height;
-} DrawSurface;
+	i32 capacity;
+	i32 count; // live missiles are [0, count)
+	// corners, in the order they're drawn
+	f32 *x[MISSILE_CORNER_COUNT];
+	f32 *y[MISSILE_CORNER_COUNT];
+	f32 *previous_x[MISSILE_CORNER_COUNT];
+	f32 *previous_y[MISSILE_CORNER_COUNT];
+	f32 *dx; // unit direction
+	f32 *dy;
+	f32 *rotation; // of the ship when it was fired
+	u8 *off_screen; // written by MissilePool_Integrate
+	u8 *spent; // hit a meteor this step
+	MissileHit *hits; // scratch for the collision pass
+} MissilePool;
+
+// A meteor's extent on x, for the sweep in MeteorPool_Bounce, and enough to
+// rule out most pairs without going back to the pool
+typedef struct {
+	f32 min_x;
+	f32 max_x;
+	f32 y;
+	f32 radius;
+	i32 meteor; // -1 if it was removed since the last sweep
+} MeteorSweepEntry;
 
-void DrawCircle(DrawSurface *surface, i32 radius, f32 pos_x, f32 pos_y) {	
-	f32 angle_step = 0.01f;
-	for (f32 angle = 0; angle <= 2 * PI; angle += angle_step) {
-		i32 x = my_ceil(pos_x + (radius * my_cos(angle)));
-		i32 y = my_ceil(pos_y + (radius * my_sin(angle)));
-		if (x < 0 || x > surface->width || y < 0 || y >= surface->height) {
-			continue;
+typedef struct {
+	i32 capacity;
+	i32 count; // live meteors are [0, count)
+	f32 *x; // center
+	f32 *y;
+	f32 *previous_x;
+	f32 *previous_y;
+	f32 *dx; // unit direction
+	f32 *dy;
+	f32 *speed; // pixels per second, whole pixels until meteors bounce
+	f32 *radius; // whole pixels
+	u8 *struck; // hit by a missile this step, see UpdateGame
+	MeteorGrid grid; // rebuilt every step by MeteorGrid_Build
+	// Every meteor in x order as of the last sweep, kept from step to step
+	// because it barely changes. New meteors go on the end.
+	MeteorSweepEntry *sweep;
+	i32 *sweep_positions; // meteor -> its entry in sweep
+	i32 sweep_count; // entries, live or not
+	i32 sweep_added; // entries put on the end since the last sweep
+} MeteorPool;
+
+// RETURNS: the index of the new missile, for the caller to fill in, or -1
+//          if the pool is full
+i32 MissilePool_Add(MissilePool *pool) {
+	if (pool->count == pool->capacity) {
+		return -1;
+	}
+	return pool->count++;
+}
+
+// Moves the last missile into index
+void MissilePool_Remove(MissilePool *pool, i32 index) {
+	i32 last = --pool->count;
+	for (i32 k = 0; k < MISSILE_CORNER_COUNT; k++) {
+		pool->x[k][index] = pool->x[k][last];
+		pool->y[k][index] = pool->y[k][last];
+		pool->previous_x[k][index] = pool->previous_x[k][last];
+		pool->previous_y[k][index] = pool->previous_y[k][last];
+	}
+	pool->dx[index] = pool->dx[last];
+	pool->dy[index] = pool->dy[last];
+	pool->rotation[index] = pool->rotation[last];
+	pool->off_screen[index] = pool->off_screen[last];
+	pool->spent[index] = pool->spent[last];
+}
+
+// Drops the entries of removed meteors, keeping the order of the rest
+static void MeteorPool_CompactSweep(MeteorPool *pool) {
+	i32 kept = 0;
+	for (i32 i = 0; i < pool->sweep_count; i++) {
+		MeteorSweepEntry entry = pool->sweep[i];
+		if (entry.meteor >= 0) {
+			pool->sweep_positions[entry.meteor] = kept;
+			pool->sweep[kept++] = entry;
 		}
-		*(surface->pixels + x + (y * surface->width)) = 0xFFFFFFFF;
 	}
+	pool->sweep_count = kept;
 }
 
-void DrawRectangle(DrawSurface *surface, i32 offset_x, i32 offset_y, i32 rectangle_width, i32 rectangle_height, u32 color) {
-	for (i32 y = offset_y; y < offset_y + rectangle_height ; y++) {
-		// Chose this approach because setting each pixel
-		// sequentially was taking 1ms+ depending on the
-		// size of the screen.
-		__stosd(
-			(unsigned long*)(surface->pixels + offset_x + (y * surface->width)),
-			color,
-			rectangle_width
-		);
+// See MissilePool_Add
+i32 MeteorPool_Add(MeteorPool *pool) {
+	if (pool->count == pool->capacity) {
+		return -1;
 	}
+	if (pool->sweep_count == pool->capacity) {
+		// only removed meteors can be taking up the room
+		MeteorPool_CompactSweep(pool);
+	}
+	i32 meteor = pool->count++;
+	MeteorSweepEntry entry = { 0.0f, 0.0f, 0.0f, 0.0f, meteor };
+	pool->sweep_positions[meteor] = pool->sweep_count;
+	pool->sweep[pool->sweep_count++] = entry;
+	pool->sweep_added += 1;
+	return meteor;
+}
+
+void MeteorPool_Clear(MeteorPool *pool) {
+	pool->count = 0;
+	pool->sweep_count = 0;
+	pool->sweep_added = 0;
 }
 
-f32 Clamp(f32 value, f32 min, f32 max) {
-	if (value < min) {
-		return min;
-	} else if (value > max) {
-		return max;	
+// Moves the last meteor into index
+void MeteorPool_Remove(MeteorPool *pool, i32 index) {
+	i32 last = --pool->count;
+	pool->sweep[pool->sweep_positions[index]].meteor = -1;
+	if (index != last) {
+		pool->sweep_positions[index] = pool->sweep_positions[last];
+		pool->sweep[pool->sweep_positions[index]].meteor = index;
 	}
-	return value;
+	pool->x[index] = pool->x[last];
+	pool->y[index] = pool->y[last];
+	pool->previous_x[index] = pool->previous_x[last];
+	pool->previous_y[index] = pool->previous_y[last];
+	pool->dx[index] = pool->dx[last];
+	pool->dy[index] = pool->dy[last];
+	pool->speed[index] = pool->speed[last];
+	pool->radius[index] = pool->radius[last];
+	pool->struck[index] = pool->struck[last];
 }
 
-void DrawLine(DrawSurface *surface, Point p1, Point p2, u32 color) {
-	f32 min_x = my_min(p2.x, p1.x);
-	f32 max_x = my_max(p2.x, p1.x);
-	f32 min_y = my_min(p2.y, p1.y);
-	f32 max_y = my_max(p2.y, p1.y);
-	
-	if (p1.x == p2.x) {
-		// vertical line
-		i32 miny = my_floor(min_y);
-		i32 maxy = my_ceil(max_y);
-		i32 x = RoundNearest(p1.x);
-		for (i32 y = miny; y < maxy; y++) {
-			if (y <= 0 || y >= surface->height) {
-				continue;
-			}
-			u32 *p = surface->pixels + x + (y * surface->width);
-			*p = color;
+// Copies where every missile is to where it was, for interpolation
+void MissilePool_SavePrevious(MissilePool *pool) {
+	for (i32 k = 0; k < MISSILE_CORNER_COUNT; k++) {
+		memcpy(pool->previous_x[k], pool->x[k], pool->count * sizeof(f32));
+		memcpy(pool->previous_y[k], pool->y[k], pool->count * sizeof(f32));
+	}
+}
+
+void MeteorPool_SavePrevious(MeteorPool *pool) {
+	memcpy(pool->previous_x, pool->x, pool->count * sizeof(f32));
+	memcpy(pool->previous_y, pool->y, pool->count * sizeof(f32));
+}
+
+// Moves every missile delta_time * MISSILE_SPEED along its direction.
+// A missile that left the width x height surface (its corners' extents,
+// floored and ceiled, are all off one side, or past the far edge at all) is
+// marked in pool->off_screen, one byte per missile.
+void MissilePool_Integrate(MissilePool *pool, f32 delta_time, i32 width, i32 height) {
+	u8 *off_screen = pool->off_screen;
+	f32 speed = delta_time * MISSILE_SPEED;
+	i32 i = 0;
+#if __AVX2__
+	__m256 speed_8 = _mm256_set1_ps(speed);
+	__m256 zero_8 = _mm256_setzero_ps();
+	__m256 width_8 = _mm256_set1_ps((f32)width);
+	__m256 height_8 = _mm256_set1_ps((f32)height);
+	for (; (i + 8) <= pool->count; i += 8) {
+		__m256 delta_x = _mm256_mul_ps(speed_8, _mm256_loadu_ps(pool->dx + i));
+		__m256 delta_y = _mm256_mul_ps(speed_8, _mm256_loadu_ps(pool->dy + i));
+		__m256 min_x = _mm256_set1_ps(F32_MAX);
+		__m256 max_x = _mm256_set1_ps(-F32_MAX);
+		__m256 min_y = min_x;
+		__m256 max_y = max_x;
+		for (i32 k = 0; k < MISSILE_CORNER_COUNT; k++) {
+			__m256 x = _mm256_add_ps(_mm256_loadu_ps(pool->x[k] + i), delta_x);
+			__m256 y = _mm256_add_ps(_mm256_loadu_ps(pool->y[k] + i), delta_y);
+			_mm256_storeu_ps(pool->x[k] + i, x);
+			_mm256_storeu_ps(pool->y[k] + i, y);
+			min_x = _mm256_min_ps(min_x, x);
+			max_x = _mm256_max_ps(max_x, x);
+			min_y = _mm256_min_ps(min_y, y);
+			max_y = _mm256_max_ps(max_y, y);
 		}
-	} else if (p1.y == p2.y) {
-		// horizontal line
-		i32 int_min_x = RoundNearest(min_x);
-		i32 int_max_x = RoundNearest(max_x);
-		i32 y_value = RoundNearest(p2.y);
-		for (i32 x = int_min_x; x <= int_max_x; x++) {
-			*(surface->pixels + x + (y_value * surface->width)) = color;
+		min_x = _mm256_floor_ps(min_x);
+		max_x = _mm256_ceil_ps(max_x);
+		min_y = _mm256_floor_ps(min_y);
+		max_y = _mm256_ceil_ps(max_y);
+		__m256 left = _mm256_and_ps(_mm256_cmp_ps(min_x, zero_8, _CMP_LT_OQ), _mm256_cmp_ps(max_x, zero_8, _CMP_LT_OQ));
+		__m256 right = _mm256_or_ps(_mm256_cmp_ps(min_x, width_8, _CMP_GT_OQ), _mm256_cmp_ps(max_x, width_8, _CMP_GT_OQ));
+		__m256 top = _mm256_and_ps(_mm256_cmp_ps(min_y, zero_8, _CMP_LT_OQ), _mm256_cmp_ps(max_y, zero_8, _CMP_LT_OQ));
+		__m256 bottom = _mm256_or_ps(_mm256_cmp_ps(min_y, height_8, _CMP_GT_OQ), _mm256_cmp_ps(max_y, height_8, _CMP_GT_OQ));
+		i32 mask = _mm256_movemask_ps(_mm256_or_ps(_mm256_or_ps(left, right), _mm256_or_ps(top, bottom)));
+		for (i32 lane = 0; lane < 8; lane++) {
+			off_screen[i + lane] = (u8)((mask >> lane) & 1);
 		}
-	} else {
-		f32 m = (p1.y - p2.y)/(p1.x - p2.x);
-		f32 b = p2.y - m * p2.x;		
-
-		// NOTE: Calculate pixels for both x and y because if the slope
-		//       be is too small the generated points will be too spread
-		//       far a part which is not desirable.
-		
-		for (f32 y = min_y; y <= max_y; y += 1.0f) {
-			f32 x = ((f32)y - b) / m;
-			if (x < min_x || x > max_x) {
-				continue;
-			}
-			i32 actual_x = RoundNearest(x);
-			i32 actual_y = RoundNearest(Clamp(y, 0.0f, (f32)surface->height));
-			u32 *p = surface->pixels + actual_x + (actual_y * surface->width);
-			*p = color;			
+	}
+#endif
+	__m128 speed_4 = _mm_set1_ps(speed);
+	__m128 zero = _mm_setzero_ps();
+	__m128 width_4 = _mm_set1_ps((f32)width);
+	__m128 height_4 = _mm_set1_ps((f32)height);
+	for (; (i + 4) <= pool->count; i += 4) {
+		__m128 delta_x = _mm_mul_ps(speed_4, _mm_loadu_ps(pool->dx + i));
+		__m128 delta_y = _mm_mul_ps(speed_4, _mm_loadu_ps(pool->dy + i));
+		__m128 min_x = _mm_set1_ps(F32_MAX);
+		__m128 max_x = _mm_set1_ps(-F32_MAX);
+		__m128 min_y = min_x;
+		__m128 max_y = max_x;
+		for (i32 k = 0; k < MISSILE_CORNER_COUNT; k++) {
+			__m128 x = _mm_add_ps(_mm_loadu_ps(pool->x[k] + i), delta_x);
+			__m128 y = _mm_add_ps(_mm_loadu_ps(pool->y[k] + i), delta_y);
+			_mm_storeu_ps(pool->x[k] + i, x);
+			_mm_storeu_ps(pool->y[k] + i, y);
+			min_x = _mm_min_ps(min_x, x);
+			max_x = _mm_max_ps(max_x, x);
+			min_y = _mm_min_ps(min_y, y);
+			max_y = _mm_max_ps(max_y, y);
 		}
-		
-		for (f32 x = min_x; x <= max_x; x += 1.0f) {
-			f32 y = (m*x) + b;
-			if (y < min_y || y > max_y) {
-				continue;
-			}
-			i32 actual_x = RoundNearest(x);
-			i32 actual_y = RoundNearest(Clamp(y, 0.0f, (f32)surface->height));
-			u32 *p = surface->pixels + actual_x + (actual_y * surface->width);
-			*p = color;			
+		min_x = _mm_floor_ps(min_x);
+		max_x = _mm_ceil_ps(max_x);
+		min_y = _mm_floor_ps(min_y);
+		max_y = _mm_ceil_ps(max_y);
+		__m128 left = _mm_and_ps(_mm_cmplt_ps(min_x, zero), _mm_cmplt_ps(max_x, zero));
+		__m128 right = _mm_or_ps(_mm_cmpgt_ps(min_x, width_4), _mm_cmpgt_ps(max_x, width_4));
+		__m128 top = _mm_and_ps(_mm_cmplt_ps(min_y, zero), _mm_cmplt_ps(max_y, zero));
+		__m128 bottom = _mm_or_ps(_mm_cmpgt_ps(min_y, height_4), _mm_cmpgt_ps(max_y, height_4));
+		i32 mask = _mm_movemask_ps(_mm_or_ps(_mm_or_ps(left, right), _mm_or_ps(top, bottom)));
+		for (i32 lane = 0; lane < 4; lane++) {
+			off_screen[i + lane] = (u8)((mask >> lane) & 1);
+		}
+	}
+	for (; i < pool->count; i++) {
+		f32 delta_x = speed * pool->dx[i];
+		f32 delta_y = speed * pool->dy[i];
+		f32 min_x = F32_MAX;
+		f32 max_x = -F32_MAX;
+		f32 min_y = F32_MAX;
+		f32 max_y = -F32_MAX;
+		for (i32 k = 0; k < MISSILE_CORNER_COUNT; k++) {
+			f32 x = pool->x[k][i] + delta_x;
+			f32 y = pool->y[k][i] + delta_y;
+			pool->x[k][i] = x;
+			pool->y[k][i] = y;
+			min_x = my_min(min_x, x);
+			max_x = my_max(max_x, x);
+			min_y = my_min(min_y, y);
+			max_y = my_max(max_y, y);
 		}
+		i32 floor_min_x = my_floor(min_x);
+		i32 ceil_max_x = my_ceil(max_x);
+		i32 floor_min_y = my_floor(min_y);
+		i32 ceil_max_y = my_ceil(max_y);
+		off_screen[i] = (u8)((floor_min_x < 0 && ceil_max_x < 0) ||
+			(floor_min_x > width || ceil_max_x > width) ||
+			(floor_min_y < 0 && ceil_max_y < 0) ||
+			(floor_min_y > height || ceil_max_y > height));
 	}
 }
 
-Vec2i Subtracti(Vec2i a, Vec2i b) {
-	Vec2i result = {0};
-	result.x = a.x - b.x;
-	result.y = a.y - b.y;
-	return result;
+// Moves every meteor delta_time * speed along its direction. A meteor that
+// is all the way off one side of the width x height surface comes back all
+// the way off the other side.
+void MeteorPool_Integrate(MeteorPool *pool, f32 delta_time, i32 width, i32 height) {
+	i32 i = 0;
+#if __AVX2__
+	__m256 delta_time_8 = _mm256_set1_ps(delta_time);
+	__m256 zero_8 = _mm256_setzero_ps();
+	__m256 width_8 = _mm256_set1_ps((f32)width);
+	__m256 height_8 = _mm256_set1_ps((f32)height);
+	for (; (i + 8) <= pool->count; i += 8) {
+		__m256 distance = _mm256_mul_ps(delta_time_8, _mm256_loadu_ps(pool->speed + i));
+		__m256 radius = _mm256_loadu_ps(pool->radius + i);
+		__m256 negative_radius = _mm256_sub_ps(zero_8, radius);
+		__m256 x = _mm256_add_ps(_mm256_loadu_ps(pool->x + i), _mm256_mul_ps(_mm256_loadu_ps(pool->dx + i), distance));
+		__m256 y = _mm256_add_ps(_mm256_loadu_ps(pool->y + i), _mm256_mul_ps(_mm256_loadu_ps(pool->dy + i), distance));
+		__m256 off_left = _mm256_cmp_ps(_mm256_add_ps(x, radius), zero_8, _CMP_LE_OQ);
+		__m256 off_right = _mm256_cmp_ps(_mm256_sub_ps(x, radius), width_8, _CMP_GE_OQ);
+		__m256 off_top = _mm256_cmp_ps(_mm256_add_ps(y, radius), zero_8, _CMP_LE_OQ);
+		__m256 off_bottom = _mm256_cmp_ps(_mm256_sub_ps(y, radius), height_8, _CMP_GE_OQ);
+		x = _mm256_blendv_ps(_mm256_blendv_ps(x, negative_radius, off_right), _mm256_add_ps(width_8, radius), off_left);
+		y = _mm256_blendv_ps(_mm256_blendv_ps(y, negative_radius, off_bottom), _mm256_add_ps(height_8, radius), off_top);
+		_mm256_storeu_ps(pool->x + i, x);
+		_mm256_storeu_ps(pool->y + i, y);
+	}
+#endif
+	__m128 delta_time_4 = _mm_set1_ps(delta_time);
+	__m128 zero = _mm_setzero_ps();
+	__m128 width_4 = _mm_set1_ps((f32)width);
+	__m128 height_4 = _mm_set1_ps((f32)height);
+	for (; (i + 4) <= pool->count; i += 4) {
+		__m128 distance = _mm_mul_ps(delta_time_4, _mm_loadu_ps(pool->speed + i));
+		__m128 radius = _mm_loadu_ps(pool->radius + i);
+		__m128 negative_radius = _mm_sub_ps(zero, radius);
+		__m128 x = _mm_add_ps(_mm_loadu_ps(pool->x + i), _mm_mul_ps(_mm_loadu_ps(pool->dx + i), distance));
+		__m128 y = _mm_add_ps(_mm_loadu_ps(pool->y + i), _mm_mul_ps(_mm_loadu_ps(pool->dy + i), distance));
+		__m128 off_left = _mm_cmple_ps(_mm_add_ps(x, radius), zero);
+		__m128 off_right = _mm_cmpge_ps(_mm_sub_ps(x, radius), width_4);
+		__m128 off_top = _mm_cmple_ps(_mm_add_ps(y, radius), zero);
+		__m128 off_bottom = _mm_cmpge_ps(_mm_sub_ps(y, radius), height_4);
+		x = _mm_blendv_ps(_mm_blendv_ps(x, negative_radius, off_right), _mm_add_ps(width_4, radius), off_left);
+		y = _mm_blendv_ps(_mm_blendv_ps(y, negative_radius, off_bottom), _mm_add_ps(height_4, radius), off_top);
+		_mm_storeu_ps(pool->x + i, x);
+		_mm_storeu_ps(pool->y + i, y);
+	}
+	for (; i < pool->count; i++) {
+		f32 distance = delta_time * pool->speed[i];
+		f32 radius = pool->radius[i];
+		f32 x = pool->x[i] + (pool->dx[i] * distance);
+		f32 y = pool->y[i] + (pool->dy[i] * distance);
+		if ((x + radius) <= 0) {
+			x = (f32)width + radius;
+		} else if ((x - radius) >= width) {
+			x = 0.0f - radius;
+		}
+		if ((y + radius) <= 0) {
+			y = (f32)height + radius;
+		} else if ((y - radius) >= height) {
+			y = 0.0f - radius;
+		}
+		pool->x[i] = x;
+		pool->y[i] = y;
+	}
 }
 
-Vec2 Subtract(Vec2 a, Vec2 b) {
-	Vec2 result = {0};
-	result.x = a.x - b.x;
-	result.y = a.y - b.y;
-	return result;
+static i32 MeteorGrid_Cell(i32 cell_x, i32 cell_y) {
+	return (cell_x & (METEOR_GRID_SIZE - 1)) + ((cell_y & (METEOR_GRID_SIZE - 1)) * METEOR_GRID_SIZE);
 }
 
-f32 Length(Vec2i v) {
-	f32 result = my_sqrt((f32)(v.x*v.x)+(v.y*v.y));
-	return result;
+// Sorts the meteors into their cells, a counting sort so it's O(meteors + cells)
+void MeteorGrid_Build(MeteorGrid *grid, MeteorPool *pool) {
+	f32 inverse_cell_size = 1.0f / METEOR_GRID_CELL_SIZE;
+	i32 *cell_starts = grid->cell_starts;
+	memset(cell_starts, 0, (METEOR_GRID_CELL_COUNT + 1) * sizeof(i32));
+	f32 max_radius = 0.0f;
+	for (i32 i = 0; i < pool->count; i++) {
+		i32 cell = MeteorGrid_Cell(my_floor(pool->x[i] * inverse_cell_size), my_floor(pool->y[i] * inverse_cell_size));
+		grid->cells[i] = cell;
+		cell_starts[cell] += 1;
+		max_radius = my_max(max_radius, pool->radius[i]);
+	}
+	// where each cell ends, then fill the cells from the back so each one
+	// ends up where it starts and in meteor order
+	for (i32 cell = 1; cell <= METEOR_GRID_CELL_COUNT; cell++) {
+		cell_starts[cell] += cell_starts[cell - 1];
+	}
+	for (i32 i = pool->count - 1; i >= 0; i--) {
+		grid->meteors[--cell_starts[grid->cells[i]]] = i;
+	}
+	grid->max_radius = max_radius;
 }
 
-b8 AnyPointsInsideCircle(i32 circle_radius, Vec2 circle_position, Point *points, i32 point_count) {
-	for (i32 i = 0; i < point_count; i++) {
-		Point p = points[i];
-		
-		Vec2 testpoint = {0};
-		testpoint.x = p.x;
-		testpoint.y = p.y;
-		
-		Vec2 d = Subtract(circle_position, testpoint); // displacement from center
-		i32 distance_from_center = my_floor(my_sqrt((f32)(d.x*d.x)+(f32)(d.y*d.y)));
-		if (distance_from_center <= circle_radius) {
-			return 1;
+// Finds every meteor in the grid that could have a point of the
+// [min_x, max_x] x [min_y, max_y] box inside it, as PointsInsideCircles
+// sees it, plus some that can't. Each one is in the list once.
+// RETURNS: how many meteors it put in grid->candidates
+i32 MeteorGrid_Gather(MeteorGrid *grid, f32 min_x, f32 min_y, f32 max_x, f32 max_y) {
+	// anything closer than radius + 1 counts, see CircleReachSquared
+	f32 reach = grid->max_radius + 2.0f;
+	f32 inverse_cell_size = 1.0f / METEOR_GRID_CELL_SIZE;
+	i32 first_x = my_floor((min_x - reach) * inverse_cell_size);
+	i32 first_y = my_floor((min_y - reach) * inverse_cell_size);
+	i32 cells_x = my_floor((max_x + reach) * inverse_cell_size) - first_x + 1;
+	i32 cells_y = my_floor((max_y + reach) * inverse_cell_size) - first_y + 1;
+	// past the size of the grid the cells would come round again
+	cells_x = Min2(cells_x, METEOR_GRID_SIZE);
+	cells_y = Min2(cells_y, METEOR_GRID_SIZE);
+
+	i32 count = 0;
+	for (i32 y = 0; y < cells_y; y++) {
+		for (i32 x = 0; x < cells_x; x++) {
+			i32 cell = MeteorGrid_Cell(first_x + x, first_y + y);
+			for (i32 i = grid->cell_starts[cell]; i < grid->cell_starts[cell + 1]; i++) {
+				grid->candidates[count++] = grid->meteors[i];
+			}
 		}
 	}
-	
-	return 0;
+	return count;
 }
 
-typedef char Flag;
-#define FLAG_UNSET 0;
-#define FLAG_SET 1;
-
-#define MISSILE_POOL_SIZE 16
-#define MISSILE_WIDTH 4.0f
-#define MISSILE_HEIGHT 8.0f
-#define METEOR_POOL_SIZE 32
-
-Missile Missiles[MISSILE_POOL_SIZE];
-Meteor Meteors[METEOR_POOL_SIZE];	
+// Past this many new meteors since the last sweep, sorting from scratch
+// beats inserting each of them into place
+#define METEOR_SWEEP_MAX_INSERTS 32
 
-static Flag Flag_Initialized = FLAG_UNSET;
-static Flag Flag_DrawShip = FLAG_SET;
-static b8 PlayerDead = 0;
-static b8 GameOver = 0;
-static u32 PlayerLives = 3;
-static i32 Score = 0;
-static f32 TimeSincePlayerDied = 0.0f;
-static f32 TimeSinceLastDrawShipFlagFlipped = 0.0f;
-static Vec2 ShipPosition = {0};
-static Vec2 ShipVelocity = {0};
-static f32 ShipRotationRadians = 0.0f;
+static b8 MeteorSweepEntry_Less(MeteorSweepEntry *a, MeteorSweepEntry *b) {
+	// ties go by meteor, so the order only depends on the meteors
+	return (a->min_x < b->min_x) || ((a->min_x == b->min_x) && (a->meteor < b->meteor));
+}
 
-Flag RandomInitialized = FLAG_UNSET;
+static int MeteorSweepEntry_Compare(const void *a, const void *b) {
+	MeteorSweepEntry *entry_a = (MeteorSweepEntry*)a;
+	MeteorSweepEntry *entry_b = (MeteorSweepEntry*)b;
+	return MeteorSweepEntry_Less(entry_a, entry_b) ? -1 : (MeteorSweepEntry_Less(entry_b, entry_a) ? 1 : 0);
+}
 
-i32 GenerateRandomNumber(i32 min, i32 max) {
-	if (!RandomInitialized) {
-		srand((u32)time(0));
-		RandomInitialized = FLAG_SET;
+// Bounces two overlapping meteors, b is (dx, dy) from a and they overlap
+// if that's shorter than reach. Momentum and energy are kept with a mass of
+// radius squared, then they're pushed apart so they don't stick.
+static void MeteorPool_BouncePair(MeteorPool *pool, i32 a, i32 b, f32 dx, f32 dy, f32 reach) {
+	f32 distance_squared = (dx * dx) + (dy * dy);
+	f32 normal_x = 1.0f;
+	f32 normal_y = 0.0f;
+	f32 distance = 0.0f;
+	// meteors split off the same one start on top of each other
+	if (distance_squared > 0.0f) {
+		distance = my_sqrt(distance_squared);
+		normal_x = dx / distance;
+		normal_y = dy / distance;
 	}
-	i32 random_number = (rand() % (max - min + 1)) + min;
-	return random_number;
-}
 
-#include "stdarg.h"
-#include "stdio.h"
+	f32 mass_a = pool->radius[a] * pool->radius[a];
+	f32 mass_b = pool->radius[b] * pool->radius[b];
+	f32 total_mass = mass_a + mass_b;
+	f32 velocity_a_x = pool->dx[a] * pool->speed[a];
+	f32 velocity_a_y = pool->dy[a] * pool->speed[a];
+	f32 velocity_b_x = pool->dx[b] * pool->speed[b];
+	f32 velocity_b_y = pool->dy[b] * pool->speed[b];
+
+	// how fast a is closing on b, they may already be moving apart
+	f32 closing = ((velocity_a_x - velocity_b_x) * normal_x) + ((velocity_a_y - velocity_b_y) * normal_y);
+	if (closing > 0.0f) {
+		f32 impulse_a = (2.0f * mass_b / total_mass) * closing;
+		f32 impulse_b = (2.0f * mass_a / total_mass) * closing;
+		velocity_a_x -= impulse_a * normal_x;
+		velocity_a_y -= impulse_a * normal_y;
+		velocity_b_x += impulse_b * normal_x;
+		velocity_b_y += impulse_b * normal_y;
+
+		f32 speed_a = my_sqrt((velocity_a_x * velocity_a_x) + (velocity_a_y * velocity_a_y));
+		f32 speed_b = my_sqrt((velocity_b_x * velocity_b_x) + (velocity_b_y * velocity_b_y));
+		if (speed_a > 0.0f) {
+			pool->dx[a] = velocity_a_x / speed_a;
+			pool->dy[a] = velocity_a_y / speed_a;
+		}
+		if (speed_b > 0.0f) {
+			pool->dx[b] = velocity_b_x / speed_b;
+			pool->dy[b] = velocity_b_y / speed_b;
+		}
+		pool->speed[a] = speed_a;
+		pool->speed[b] = speed_b;
+	}
 
-static void Platform_WriteConsole(char *format, ...) {
-	va_list args;
-	va_start(args, format);
-	char msg[1024] = {0};
-	vsprintf_s(msg, 1024, format, args);
-	OutputDebugString(msg);
-	va_end(args);
+	// the lighter one moves further
+	f32 overlap = reach - distance;
+	pool->x[a] -= normal_x * overlap * (mass_b / total_mass);
+	pool->y[a] -= normal_y * overlap * (mass_b / total_mass);
+	pool->x[b] += normal_x * overlap * (mass_a / total_mass);
+	pool->y[b] += normal_y * overlap * (mass_a / total_mass);
 }
 
-void SpawnMeteor(Vec2 position, i32 radius, i32 speed) {
-	// find inactive meteor
-	// configure the meteor
-	// set the meteor to active
-	for (i32 i = 0; i < METEOR_POOL_SIZE; i++) {
-		Meteor *m = Meteors + i;
-		if (m->active) continue;
-		
-		m->pos = position;
-		m->radius = radius;
-		m->speed = speed;
-		
-		
-		
-		f32 rand_x = (f32)GenerateRandomNumber(0, 1000);
-		if (GenerateRandomNumber(0, 10) >= 5) {
-			rand_x *= -1.0f;
+// Bounces every pair of overlapping meteors off each other. Sort and sweep:
+// the meteors are kept sorted by their left edge, and only pairs whose x
+// extents overlap are tested. Meteors move a few pixels a step, so last
+// step's order is nearly sorted and an insertion sort puts it right in
+// about one pass. Pairs are found from where the meteors were before any of
+// this step's bounces moved them, a pair that pushing apart makes is bounced
+// the next step. Meteors aren't wrapped around the screen, the same as the
+// other collisions.
+void MeteorPool_Bounce(MeteorPool *pool) {
+	MeteorPool_CompactSweep(pool);
+	MeteorSweepEntry *sweep = pool->sweep;
+	i32 count = pool->sweep_count;
+	for (i32 i = 0; i < count; i++) {
+		i32 meteor = sweep[i].meteor;
+		sweep[i].min_x = pool->x[meteor] - pool->radius[meteor];
+		sweep[i].max_x = pool->x[meteor] + pool->radius[meteor];
+		sweep[i].y = pool->y[meteor];
+		sweep[i].radius = pool->radius[meteor];
+	}
+
+	if (pool->sweep_added > METEOR_SWEEP_MAX_INSERTS) {
+		qsort(sweep, (size_t)count, sizeof(MeteorSweepEntry), MeteorSweepEntry_Compare);
+	} else {
+		for (i32 i = 1; i < count; i++) {
+			MeteorSweepEntry entry = sweep[i];
+			i32 j = i;
+			for (; (j > 0) && MeteorSweepEntry_Less(&entry, sweep + j - 1); j--) {
+				sweep[j] = sweep[j - 1];
+			}
+			sweep[j] = entry;
 		}
-		
-		f32 rand_y = (f32)GenerateRandomNumber(0, 1000);
-		if (GenerateRandomNumber(0, 10) >= 5) {
-			rand_y *= -1.0f;
+	}
+	for (i32 i = 0; i < count; i++) {
+		pool->sweep_positions[sweep[i].meteor] = i;
+	}
+	pool->sweep_added = 0;
+
+	for (i32 i = 0; i < count; i++) {
+		i32 a = sweep[i].meteor;
+		f32 max_x = sweep[i].max_x;
+		for (i32 j = i + 1; (j < count) && (sweep[j].min_x <= max_x); j++) {
+			f32 gap_y = sweep[j].y - sweep[i].y;
+			f32 reach_y = sweep[i].radius + sweep[j].radius;
+			// one compare, the sign of the gap is a coin flip for the branch predictor
+			if ((gap_y * gap_y) > (reach_y * reach_y)) {
+				continue;
+			}
+			i32 b = sweep[j].meteor;
+			f32 dx = pool->x[b] - pool->x[a];
+			f32 dy = pool->y[b] - pool->y[a];
+			f32 reach = pool->radius[a] + pool->radius[b];
+			if (((dx * dx) + (dy * dy)) < (reach * reach)) {
+				MeteorPool_BouncePair(pool, a, b, dx, dy, reach);
+			}
 		}
-		
-		f32 length = my_sqrt((rand_x * rand_x) + (rand_y * rand_y));
-		rand_x /= length;
-		rand_y /= length;
-		
-		m->direction.x = rand_x;
-		m->direction.y = rand_y;
-		
-		Platform_WriteConsole("SpawnMeteor() Dir: x=%f y=%f\n", m->direction.x,
-			m->direction.y);
-		
-		m->active = 1;
-		return;
 	}
-	OutputDebugString("Unable to spawn a Meteor, the pool is full!\n");
 }
 
-void DrawString(DrawSurface *surface, char *text, i32 x, i32 y) {
-	i32 text_length = (i32)strlen(text);
-	KDTF_DrawText(&gFont, text, text_length, 0xFFFFFFFF, &x, &y, surface->pixels, surface->width, surface->height);
-}
-
-i32 RoundNearestFloat(f32 value) {
-	i32 floored = Floor(value);
-	if ((value - (f32)floored) < 0.5f) {
-		return floored;
-	} else {
-		return floored + 1;
+// The largest squared distance from a circle's center that counts as inside,
+// where inside means the distance, floored, is at most the radius. That is
+// just under (radius + 1)^2, but the square root of the float right under it
+// can round up to radius + 1, in which case it's the one under that.
+// Radii are whole pixels below 4096.
+f32 CircleReachSquared(f32 radius) {
+	f32 reach = (f32)my_floor(radius) + 1.0f;
+	f32 reach_squared = reach * reach;
+	i32 bits;
+	memcpy(&bits, &reach_squared, sizeof(bits));
+	bits -= 1;
+	f32 limit;
+	memcpy(&limit, &bits, sizeof(limit));
+	if (my_sqrt(limit) >= reach) {
+		bits -= 1;
+		memcpy(&limit, &bits, sizeof(limit));
 	}
+	return limit;
 }
 
-void NewLine(i32 *y_coordinate) {
-	i32 new_coordinate = *y_coordinate + gFont.line_height;
-	*y_coordinate = new_coordinate;
+// CircleReachSquared for 4 circles
+__m128 CircleReachSquared4(__m128 radius) {
+	__m128 reach = _mm_add_ps(_mm_floor_ps(radius), _mm_set1_ps(1.0f));
+	__m128i one_bit = _mm_set1_epi32(1);
+	__m128 limit = _mm_castsi128_ps(_mm_sub_epi32(_mm_castps_si128(_mm_mul_ps(reach, reach)), one_bit));
+	__m128 rounds_up = _mm_cmpge_ps(_mm_sqrt_ps(limit), reach);
+	return _mm_blendv_ps(limit, _mm_castsi128_ps(_mm_sub_epi32(_mm_castps_si128(limit), one_bit)), rounds_up);
 }
 
-b8 MenuButton(DrawSurface *surface, char *text, i32 at_x, i32 at_y) {
-	i32 text_length = (i32)strlen(text);
-	
-	b8 MouseHoveringOverButton = 0;
-	
-	i32 text_width = gFont.atlas.glyph_width * text_length;
-	if (MouseX >= at_x && MouseX <= (at_x + text_width)) {
-		if (MouseY >= at_y && MouseY <= (at_y + gFont.atlas.glyph_height)) {
-			MouseHoveringOverButton = 1;
+#if __AVX2__
+// CircleReachSquared for 8 circles
+__m256 CircleReachSquared8(__m256 radius) {
+	__m256 reach = _mm256_add_ps(_mm256_floor_ps(radius), _mm256_set1_ps(1.0f));
+	__m256i one_bit = _mm256_set1_epi32(1);
+	__m256 limit = _mm256_castsi256_ps(_mm256_sub_epi32(_mm256_castps_si256(_mm256_mul_ps(reach, reach)), one_bit));
+	__m256 rounds_up = _mm256_cmp_ps(_mm256_sqrt_ps(limit), reach, _CMP_GE_OQ);
+	return _mm256_blendv_ps(limit, _mm256_castsi256_ps(_mm256_sub_epi32(_mm256_castps_si256(limit), one_bit)),
+		rounds_up);
+}
+#endif
+
+// Sets bit i % 32 of hit_masks[i / 32] for every circle i with any of the
+// points inside it, and clears it for the rest. Each point is a squared
+// distance compared against CircleReachSquared, which only takes a square
+// root per circle. 4 (SSE) or 8 (AVX2) circles at a time, the same bits as
+// one at a time.
+// RETURNS: 1 if any circle has a point inside
+b8 PointsInsideCircles(Point *points, i32 point_count, f32 *circle_x, f32 *circle_y, f32 *circle_radius,
+	i32 circle_count, u32 *hit_masks) {
+	memset(hit_masks, 0, ((circle_count + 31) / 32) * sizeof(u32));
+	u32 any = 0;
+	i32 i = 0;
+#if __AVX2__
+	for (; (i + 8) <= circle_count; i += 8) {
+		__m256 center_x = _mm256_loadu_ps(circle_x + i);
+		__m256 center_y = _mm256_loadu_ps(circle_y + i);
+		__m256 limit = CircleReachSquared8(_mm256_loadu_ps(circle_radius + i));
+		__m256 inside = _mm256_setzero_ps();
+		for (i32 k = 0; k < point_count; k++) {
+			__m256 dx = _mm256_sub_ps(center_x, _mm256_set1_ps(points[k].x));
+			__m256 dy = _mm256_sub_ps(center_y, _mm256_set1_ps(points[k].y));
+			__m256 distance_squared = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+			inside = _mm256_or_ps(inside, _mm256_cmp_ps(distance_squared, limit, _CMP_LE_OQ));
 		}
+		u32 mask = (u32)_mm256_movemask_ps(inside);
+		hit_masks[i / 32] |= mask << (i % 32);
+		any |= mask;
 	}
-	
-	u32 TextColor = 0xFFFFFFFF;
-	if (MouseHoveringOverButton) {
-		TextColor = 0xFF3D3D3D;
+#endif
+	for (; (i + 4) <= circle_count; i += 4) {
+		__m128 center_x = _mm_loadu_ps(circle_x + i);
+		__m128 center_y = _mm_loadu_ps(circle_y + i);
+		__m128 limit = CircleReachSquared4(_mm_loadu_ps(circle_radius + i));
+		__m128 inside = _mm_setzero_ps();
+		for (i32 k = 0; k < point_count; k++) {
+			__m128 dx = _mm_sub_ps(center_x, _mm_set1_ps(points[k].x));
+			__m128 dy = _mm_sub_ps(center_y, _mm_set1_ps(points[k].y));
+			__m128 distance_squared = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+			inside = _mm_or_ps(inside, _mm_cmple_ps(distance_squared, limit));
+		}
+		u32 mask = (u32)_mm_movemask_ps(inside);
+		hit_masks[i / 32] |= mask << (i % 32);
+		any |= mask;
 	}
-	
-	KDTF_DrawText(&gFont, text, text_length, TextColor, &at_x, &at_y, surface->pixels, surface->width, surface->height);
-	
-	return MouseHoveringOverButton && MouseLeftButtonDown;
-}
-
-static void UpdateAndRender(f32 delta_time, DrawSurface *surface) {
-	/*
-		What could have been done better:
-			* Writing the usage code first
-				- Drawing text on the screen
-				- Clearing the background color			
-			* Use integers for position data instead of floats
-			* Do more calculations on data when looping over an array.
-			  I loop over the missile pool several times, performing
-			  different operations each time. Memory is the slowest thing
-			  you're going to be working with, so take advantage of the 
-			  data when it's already in memory
-			* Instead of using a boolean when there is a list of items,
-			  keep the list of items separate from that boolean value.
-			* Keep instruction level parallelism in mind
-		
-		What should I continue to do:
-			* Using pools when you have several entities of the same type,
-			  marking the entity as either alive/dead.
-			* Don't insert a split between updating and rendering the game
-			  artificially. In this case, the logic was much easier to understand.
-		
-		What I should stop doing:
-			* Don't put things into a global state struct until you need it for
-			  some reason.
-			* Rushing through fixing something
-	*/
+	for (; i < circle_count; i++) {
+		f32 limit = CircleReachSquared(circle_radius[i]);
+		for (i32 k = 0; k < point_count; k++) {
+			f32 dx = circle_x[i] - points[k].x;
+			f32 dy = circle_y[i] - points[k].y;
+			if (((dx * dx) + (dy * dy)) <= limit) {
+				hit_masks[i / 32] |= 1u << (i % 32);
+				any = 1;
+				break;
+			}
+		}
+	}
+	return any != 0;
+}
 
-	if (!Flag_Initialized) {
-		Flag_DrawShip = FLAG_SET;
-		PlayerDead = 0;
-		PlayerLives = 3;
-		Score = 0;
-		TimeSincePlayerDied = 0.0f;
-		TimeSinceLastDrawShipFlagFlipped = 0.0f;
-	
-		ShipPosition.x = (WindowWidth / 2.0f);
-		ShipPosition.y = (WindowHeight / 2.0f);
-		
-		ShipVelocity.x = 0.0f;
-		ShipVelocity.y = 0.0f;
-		
-		ShipRotationRadians = 0.0f;
-		
-		for (i32 i = 0; i < METEOR_POOL_SIZE; i++) {
-			Meteor *m = Meteors + i;
-			m->pos.x = 0.0f;
-			m->pos.y = 0.0f;
-			m->direction.x = 0.0f;
-			m->direction.y = 0.0f;
-			m->speed = 0;
-			m->radius = 0;
-			m->active = 0;
+// Sets bit i % 32 of hit_masks[i / 32] for every circle i that touches the
+// triangle, and clears it for the rest. Touching is having the center inside
+// the triangle, or closer to one of its edges than the circle's reach (see
+// CircleReachSquared), so a circle crossing an edge between two corners
+// counts. A corner in a circle counts just as in PointsInsideCircles. 4 (SSE)
+// or 8 (AVX2) circles at a time, with no branches, the same bits as one at a
+// time.
+// RETURNS: 1 if any circle touches the triangle
+b8 TriangleTouchesCircles(Triangle *triangle, f32 *circle_x, f32 *circle_y, f32 *circle_radius,
+	i32 circle_count, u32 *hit_masks) {
+	memset(hit_masks, 0, ((circle_count + 31) / 32) * sizeof(u32));
+	Point *corners = (Point*)triangle;
+	Point edges[3];
+	f32 inverse_lengths_squared[3];
+	for (i32 k = 0; k < 3; k++) {
+		Point next = corners[(k + 1) % 3];
+		edges[k].x = next.x - corners[k].x;
+		edges[k].y = next.y - corners[k].y;
+		f32 length_squared = (edges[k].x * edges[k].x) + (edges[k].y * edges[k].y);
+		inverse_lengths_squared[k] = (length_squared > 0.0f) ? (1.0f / length_squared) : 0.0f;
+	}
+
+	u32 any = 0;
+	i32 i = 0;
+#if __AVX2__
+	__m256 zero_8 = _mm256_setzero_ps();
+	__m256 one_8 = _mm256_set1_ps(1.0f);
+	for (; (i + 8) <= circle_count; i += 8) {
+		__m256 center_x = _mm256_loadu_ps(circle_x + i);
+		__m256 center_y = _mm256_loadu_ps(circle_y + i);
+		__m256 limit = CircleReachSquared8(_mm256_loadu_ps(circle_radius + i));
+		__m256 closest = _mm256_set1_ps(F32_MAX);
+		__m256 min_cross = _mm256_set1_ps(F32_MAX);
+		__m256 max_cross = _mm256_set1_ps(-F32_MAX);
+		for (i32 k = 0; k < 3; k++) {
+			__m256 edge_x = _mm256_set1_ps(edges[k].x);
+			__m256 edge_y = _mm256_set1_ps(edges[k].y);
+			// from the corner the edge starts at to the center
+			__m256 dx = _mm256_sub_ps(center_x, _mm256_set1_ps(corners[k].x));
+			__m256 dy = _mm256_sub_ps(center_y, _mm256_set1_ps(corners[k].y));
+			__m256 along = _mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(dx, edge_x), _mm256_mul_ps(dy, edge_y)),
+				_mm256_set1_ps(inverse_lengths_squared[k]));
+			along = _mm256_min_ps(_mm256_max_ps(along, zero_8), one_8);
+			__m256 off_x = _mm256_sub_ps(dx, _mm256_mul_ps(along, edge_x));
+			__m256 off_y = _mm256_sub_ps(dy, _mm256_mul_ps(along, edge_y));
+			closest = _mm256_min_ps(closest, _mm256_add_ps(_mm256_mul_ps(off_x, off_x), _mm256_mul_ps(off_y, off_y)));
+			closest = _mm256_min_ps(closest, _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)));
+			// which side of the edge the center is on
+			__m256 cross = _mm256_sub_ps(_mm256_mul_ps(edge_x, dy), _mm256_mul_ps(edge_y, dx));
+			min_cross = _mm256_min_ps(min_cross, cross);
+			max_cross = _mm256_max_ps(max_cross, cross);
 		}
-		
-		i32 NumberOfMeteorsToIntialize = 24;// rand() % METEOR_POOL_SIZE;
-		for (i32 i = 0; i < NumberOfMeteorsToIntialize; i++) {
-			Vec2 position = {0};
-			position.x = (f32)(rand() % surface->width);
-			position.y = (f32)(rand() % surface->height);
-			i32 radius = 20 + (rand() % 30);
-			i32 speed = 150 + (rand() % 100);
-			SpawnMeteor(position, radius, speed);
+		__m256 inside = _mm256_or_ps(_mm256_cmp_ps(min_cross, zero_8, _CMP_GE_OQ),
+			_mm256_cmp_ps(max_cross, zero_8, _CMP_LE_OQ));
+		__m256 touches = _mm256_or_ps(inside, _mm256_cmp_ps(closest, limit, _CMP_LE_OQ));
+		u32 mask = (u32)_mm256_movemask_ps(touches);
+		hit_masks[i / 32] |= mask << (i % 32);
+		any |= mask;
+	}
+#endif
+	__m128 zero_4 = _mm_setzero_ps();
+	__m128 one_4 = _mm_set1_ps(1.0f);
+	for (; (i + 4) <= circle_count; i += 4) {
+		__m128 center_x = _mm_loadu_ps(circle_x + i);
+		__m128 center_y = _mm_loadu_ps(circle_y + i);
+		__m128 limit = CircleReachSquared4(_mm_loadu_ps(circle_radius + i));
+		__m128 closest = _mm_set1_ps(F32_MAX);
+		__m128 min_cross = _mm_set1_ps(F32_MAX);
+		__m128 max_cross = _mm_set1_ps(-F32_MAX);
+		for (i32 k = 0; k < 3; k++) {
+			__m128 edge_x = _mm_set1_ps(edges[k].x);
+			__m128 edge_y = _mm_set1_ps(edges[k].y);
+			__m128 dx = _mm_sub_ps(center_x, _mm_set1_ps(corners[k].x));
+			__m128 dy = _mm_sub_ps(center_y, _mm_set1_ps(corners[k].y));
+			__m128 along = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(dx, edge_x), _mm_mul_ps(dy, edge_y)),
+				_mm_set1_ps(inverse_lengths_squared[k]));
+			along = _mm_min_ps(_mm_max_ps(along, zero_4), one_4);
+			__m128 off_x = _mm_sub_ps(dx, _mm_mul_ps(along, edge_x));
+			__m128 off_y = _mm_sub_ps(dy, _mm_mul_ps(along, edge_y));
+			closest = _mm_min_ps(closest, _mm_add_ps(_mm_mul_ps(off_x, off_x), _mm_mul_ps(off_y, off_y)));
+			closest = _mm_min_ps(closest, _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)));
+			__m128 cross = _mm_sub_ps(_mm_mul_ps(edge_x, dy), _mm_mul_ps(edge_y, dx));
+			min_cross = _mm_min_ps(min_cross, cross);
+			max_cross = _mm_max_ps(max_cross, cross);
 		}
-		
-		/*
-			Point points[4];
-			Vec2 direction;
-			i32 live;
-		*/
-		for (i32 i = 0; i < MISSILE_POOL_SIZE; i++) {
-			Missile *m = Missiles + i;
-			for (i32 k = 0; k < 4; k++) {
-				m->points[k].x = 0.0f;
-				m->points[k].y = 0.0f;
-			}
-			m->direction.x = 0.0f;
-			m->direction.y = 0.0f;
-			m->live = 0;
+		__m128 inside = _mm_or_ps(_mm_cmpge_ps(min_cross, zero_4), _mm_cmple_ps(max_cross, zero_4));
+		__m128 touches = _mm_or_ps(inside, _mm_cmple_ps(closest, limit));
+		u32 mask = (u32)_mm_movemask_ps(touches);
+		hit_masks[i / 32] |= mask << (i % 32);
+		any |= mask;
+	}
+	for (; i < circle_count; i++) {
+		f32 limit = CircleReachSquared(circle_radius[i]);
+		f32 closest = F32_MAX;
+		f32 min_cross = F32_MAX;
+		f32 max_cross = -F32_MAX;
+		for (i32 k = 0; k < 3; k++) {
+			f32 dx = circle_x[i] - corners[k].x;
+			f32 dy = circle_y[i] - corners[k].y;
+			f32 along = ((dx * edges[k].x) + (dy * edges[k].y)) * inverse_lengths_squared[k];
+			along = my_min(my_max(along, 0.0f), 1.0f);
+			f32 off_x = dx - (along * edges[k].x);
+			f32 off_y = dy - (along * edges[k].y);
+			closest = my_min(closest, (off_x * off_x) + (off_y * off_y));
+			closest = my_min(closest, (dx * dx) + (dy * dy));
+			f32 cross = (edges[k].x * dy) - (edges[k].y * dx);
+			min_cross = my_min(min_cross, cross);
+			max_cross = my_max(max_cross, cross);
+		}
+		if ((min_cross >= 0.0f) || (max_cross <= 0.0f) || (closest <= limit)) {
+			hit_masks[i / 32] |= 1u << (i % 32);
+			any = 1;
 		}
-		
-		Flag_Initialized = FLAG_SET;
 	}
+	return any != 0;
+}
 
-//	if (!Playing) {
-//		
-//	}
-	
-	if (gPaused) {
-		DrawRectangle(surface, 0, 0, surface->width, surface->height, BACKGROUND_COLOR);
-		
-//		DrawRectangle(surface, MouseX, MouseY, 5, 5, 0xFFFFFFFF);
-		
-		f32 relative_x = 0.6f;
-		i32 x = my_floor((f32)surface->width * relative_x);
-		f32 relative_y = 0.4f;
-		i32 y = my_floor((f32)surface->height * relative_y);
-		
-		DrawString(surface, "ASTEROIDS!", x, y);
-		
-		NewLine(&y);
-		NewLine(&y);
-		b8 restart_pressed = MenuButton(surface, "Restart", x, y);
-		if (restart_pressed) {
-			Flag_Initialized = FLAG_UNSET;
-			gPaused = 0;
+// Moves points in a straight line from from[k] to to[k] and finds when each
+// circle is first touched. Touching means closer than radius + 1, as in
+// PointsInsideCircles. The circles are held still: the meteors they
+// stand for move a fraction of what a missile does in a step.
+// times[i] is how far along the way (0 to 1) a point first touches circle i,
+// 0 if one starts inside it, F32_MAX if none touch it. Solves
+// |from + t * (to - from) - center|^2 = reach^2 for the smaller root, 4 (SSE)
+// or 8 (AVX2) circles at a time. Every path gives the same bits.
+void SweepPointsAgainstCircles(Point *from, Point *to, i32 point_count, f32 *circle_x, f32 *circle_y,
+	f32 *circle_radius, i32 circle_count, f32 *times) {
+	i32 i = 0;
+	// NOTE: Almost every circle is missed by every point, which b and the
+	//       discriminant show without a square root or a division, so those
+	//       are only done for the blocks where a lane might be touched.
+#if __AVX2__
+	__m256 zero_8 = _mm256_setzero_ps();
+	__m256 one_8 = _mm256_set1_ps(1.0f);
+	__m256 never_8 = _mm256_set1_ps(F32_MAX);
+	for (; (i + 8) <= circle_count; i += 8) {
+		__m256 center_x = _mm256_loadu_ps(circle_x + i);
+		__m256 center_y = _mm256_loadu_ps(circle_y + i);
+		__m256 reach = _mm256_add_ps(_mm256_loadu_ps(circle_radius + i), one_8);
+		__m256 reach_squared = _mm256_mul_ps(reach, reach);
+		__m256 time = never_8;
+		for (i32 k = 0; k < point_count; k++) {
+			f32 move_x = to[k].x - from[k].x;
+			f32 move_y = to[k].y - from[k].y;
+			f32 a = (move_x * move_x) + (move_y * move_y);
+			__m256 a_8 = _mm256_set1_ps(a);
+			__m256 offset_x = _mm256_sub_ps(_mm256_set1_ps(from[k].x), center_x);
+			__m256 offset_y = _mm256_sub_ps(_mm256_set1_ps(from[k].y), center_y);
+			__m256 c = _mm256_sub_ps(_mm256_add_ps(_mm256_mul_ps(offset_x, offset_x), _mm256_mul_ps(offset_y, offset_y)),
+				reach_squared);
+			__m256 b = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(move_x), offset_x),
+				_mm256_mul_ps(_mm256_set1_ps(move_y), offset_y));
+			__m256 discriminant = _mm256_sub_ps(_mm256_mul_ps(b, b), _mm256_mul_ps(a_8, c));
+			__m256 inside = _mm256_cmp_ps(c, zero_8, _CMP_LE_OQ);
+			__m256 crosses = _mm256_and_ps(_mm256_cmp_ps(b, zero_8, _CMP_LT_OQ),
+				_mm256_cmp_ps(discriminant, zero_8, _CMP_GE_OQ));
+			if (_mm256_movemask_ps(_mm256_or_ps(inside, crosses))) {
+				__m256 root = _mm256_sqrt_ps(_mm256_max_ps(discriminant, zero_8));
+				__m256 numerator = _mm256_sub_ps(_mm256_sub_ps(zero_8, b), root);
+				crosses = _mm256_and_ps(crosses, _mm256_cmp_ps(numerator, a_8, _CMP_LE_OQ));
+				// a is more than 0 in every lane that crosses
+				__m256 point_time = _mm256_blendv_ps(never_8,
+					_mm256_mul_ps(numerator, _mm256_set1_ps((a > 0.0f) ? (1.0f / a) : 0.0f)), crosses);
+				point_time = _mm256_blendv_ps(point_time, zero_8, inside);
+				time = _mm256_min_ps(time, point_time);
+			}
 		}
-		
-		NewLine(&y);
-		NewLine(&y);
-		b8 quit_pressed = MenuButton(surface, "Quit", x, y);
-		if (quit_pressed) ExitProcess(0);
-				
-		return;
+		_mm256_storeu_ps(times + i, time);
 	}
-	
-	Triangle ship_triangle = {
-		.a = { 0, 0 },
-		.b = { 15, 45 },
-		.c = { 30, 0 }
-	};
-	Point *ship_points = (Point*)&ship_triangle;
-	i32 ship_point_count = 3;
-	
-	//////////////////////////////////////////////
-	/// Apply Rotation
-	///
-	if (!PlayerDead) {
-		if (gRotateShipLeft && !gRotateShipRight) {
-			ShipRotationRadians -= delta_time * SHIP_ROTATION_STEP;
-		} else if (gRotateShipRight) {
-			ShipRotationRadians += delta_time * SHIP_ROTATION_STEP;
+#endif
+	__m128 zero_4 = _mm_setzero_ps();
+	__m128 one_4 = _mm_set1_ps(1.0f);
+	__m128 never_4 = _mm_set1_ps(F32_MAX);
+	for (; (i + 4) <= circle_count; i += 4) {
+		__m128 center_x = _mm_loadu_ps(circle_x + i);
+		__m128 center_y = _mm_loadu_ps(circle_y + i);
+		__m128 reach = _mm_add_ps(_mm_loadu_ps(circle_radius + i), one_4);
+		__m128 reach_squared = _mm_mul_ps(reach, reach);
+		__m128 time = never_4;
+		for (i32 k = 0; k < point_count; k++) {
+			f32 move_x = to[k].x - from[k].x;
+			f32 move_y = to[k].y - from[k].y;
+			f32 a = (move_x * move_x) + (move_y * move_y);
+			__m128 a_4 = _mm_set1_ps(a);
+			__m128 offset_x = _mm_sub_ps(_mm_set1_ps(from[k].x), center_x);
+			__m128 offset_y = _mm_sub_ps(_mm_set1_ps(from[k].y), center_y);
+			__m128 c = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(offset_x, offset_x), _mm_mul_ps(offset_y, offset_y)),
+				reach_squared);
+			__m128 b = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(move_x), offset_x), _mm_mul_ps(_mm_set1_ps(move_y), offset_y));
+			__m128 discriminant = _mm_sub_ps(_mm_mul_ps(b, b), _mm_mul_ps(a_4, c));
+			__m128 inside = _mm_cmple_ps(c, zero_4);
+			__m128 crosses = _mm_and_ps(_mm_cmplt_ps(b, zero_4), _mm_cmpge_ps(discriminant, zero_4));
+			if (_mm_movemask_ps(_mm_or_ps(inside, crosses))) {
+				__m128 root = _mm_sqrt_ps(_mm_max_ps(discriminant, zero_4));
+				__m128 numerator = _mm_sub_ps(_mm_sub_ps(zero_4, b), root);
+				crosses = _mm_and_ps(crosses, _mm_cmple_ps(numerator, a_4));
+				__m128 point_time = _mm_blendv_ps(never_4,
+					_mm_mul_ps(numerator, _mm_set1_ps((a > 0.0f) ? (1.0f / a) : 0.0f)), crosses);
+				point_time = _mm_blendv_ps(point_time, zero_4, inside);
+				time = _mm_min_ps(time, point_time);
+			}
 		}
+		_mm_storeu_ps(times + i, time);
 	}
-
-	// Use triangle centroid as the center of rotation
-	Point rotation_origin = Centroid(ship_triangle);
-	RotatePoints((Point*)&ship_triangle, 3, rotation_origin, ShipRotationRadians);
-	
-	Point ship_center = Centroid(ship_triangle);
+	for (; i < circle_count; i++) {
+		f32 reach = circle_radius[i] + 1.0f;
+		f32 time = F32_MAX;
+		for (i32 k = 0; k < point_count; k++) {
+			f32 move_x = to[k].x - from[k].x;
+			f32 move_y = to[k].y - from[k].y;
+			f32 a = (move_x * move_x) + (move_y * move_y);
+			f32 offset_x = from[k].x - circle_x[i];
+			f32 offset_y = from[k].y - circle_y[i];
+			f32 c = ((offset_x * offset_x) + (offset_y * offset_y)) - (reach * reach);
+			f32 b = (move_x * offset_x) + (move_y * offset_y);
+			f32 discriminant = (b * b) - (a * c);
+			f32 point_time = F32_MAX;
+			if (c <= 0.0f) {
+				point_time = 0.0f;
+			} else if ((b < 0.0f) && (discriminant >= 0.0f)) {
+				f32 numerator = (0.0f - b) - my_sqrt(discriminant);
+				if (numerator <= a) {
+					point_time = numerator * (1.0f / a);
+				}
+			}
+			time = my_min(time, point_time);
+		}
+		times[i] = time;
+	}
+}
+
+// Finds the meteor the missile's corners reach first on their way from
+// where they were last step, leaving out struck meteors. Only the meteors
+// the grid has near the way are tested.
+// RETURNS: 1 with hit->time, hit->missile and hit->meteor filled in, 0 if
+//          it reaches none
+b8 MissilePool_FindHit(MissilePool *missiles, i32 missile, MeteorPool *meteors, MissileHit *hit) {
+	Point from[MISSILE_CORNER_COUNT];
+	Point to[MISSILE_CORNER_COUNT];
+	f32 min_x = F32_MAX;
+	f32 min_y = F32_MAX;
+	f32 max_x = -F32_MAX;
+	f32 max_y = -F32_MAX;
+	for (i32 k = 0; k < MISSILE_CORNER_COUNT; k++) {
+		from[k].x = missiles->previous_x[k][missile];
+		from[k].y = missiles->previous_y[k][missile];
+		to[k].x = missiles->x[k][missile];
+		to[k].y = missiles->y[k][missile];
+		min_x = my_min(min_x, my_min(from[k].x, to[k].x));
+		min_y = my_min(min_y, my_min(from[k].y, to[k].y));
+		max_x = my_max(max_x, my_max(from[k].x, to[k].x));
+		max_y = my_max(max_y, my_max(from[k].y, to[k].y));
+	}
+
+	MeteorGrid *grid = &meteors->grid;
+	i32 candidate_count = MeteorGrid_Gather(grid, min_x, min_y, max_x, max_y);
+	i32 count = 0;
+	for (i32 c = 0; c < candidate_count; c++) {
+		i32 meteor = grid->candidates[c];
+		if (!meteors->struck[meteor]) {
+			grid->candidates[count] = meteor;
+			grid->candidate_x[count] = meteors->x[meteor];
+			grid->candidate_y[count] = meteors->y[meteor];
+			grid->candidate_radius[count] = meteors->radius[meteor];
+			count += 1;
+		}
+	}
+	SweepPointsAgainstCircles(from, to, MISSILE_CORNER_COUNT, grid->candidate_x, grid->candidate_y,
+		grid->candidate_radius, count, grid->candidate_times);
+
+	i32 best = -1;
+	for (i32 c = 0; c < count; c++) {
+		f32 time = grid->candidate_times[c];
+		// ties go to the lower meteor, the grid's order depends on the cells
+		if ((time < F32_MAX) && ((best < 0) || (time < grid->candidate_times[best]) ||
+			((time == grid->candidate_times[best]) && (grid->candidates[c] < grid->candidates[best])))) {
+			best = c;
+		}
+	}
+	if (best < 0) {
+		return 0;
+	}
+	hit->time = grid->candidate_times[best];
+	hit->missile = missile;
+	hit->meteor = grid->candidates[best];
+	return 1;
+}
+
+static b8 MissileHit_Less(MissileHit *a, MissileHit *b) {
+	return (a->time < b->time) || ((a->time == b->time) && (a->missile < b->missile));
+}
+
+static int MissileHit_Compare(const void *a, const void *b) {
+	MissileHit *hit_a = (MissileHit*)a;
+	MissileHit *hit_b = (MissileHit*)b;
+	return MissileHit_Less(hit_a, hit_b) ? -1 : (MissileHit_Less(hit_b, hit_a) ? 1 : 0);
+}
+
+typedef struct {
+	u32 *pixels;
+	i32 width;
+	i32 height;
+
+	// Nothing outside [clip_min_x, clip_max_x) x [clip_min_y, clip_max_y) is
+	// written. The tiled renderer draws the same frame once per tile with the
+	// clip rectangle set to the tile.
+	i32 clip_min_x;
+	i32 clip_min_y;
+	i32 clip_max_x;
+	i32 clip_max_y;
+} DrawSurface;
+
+DrawSurface MakeDrawSurface(u32 *pixels, i32 width, i32 height) {
+	DrawSurface result = {0};
+	result.pixels = pixels;
+	result.width = width;
+	result.height = height;
+	result.clip_max_x = width;
+	result.clip_max_y = height;
+	return result;
+}
+
+// RETURNS: 1 if any of the pixels in [min_x, max_x] x [min_y, max_y] can be written
+b8 OverlapsClip(DrawSurface *surface, i32 min_x, i32 min_y, i32 max_x, i32 max_y) {
+	return max_x >= surface->clip_min_x && min_x < surface->clip_max_x &&
+		max_y >= surface->clip_min_y && min_y < surface->clip_max_y;
+}
+
+// Fills pixels [min_x, max_x] of row y, clipped
+static void DrawSpan(DrawSurface *surface, i32 y, i32 min_x, i32 max_x, u32 color) {
+	if (y < surface->clip_min_y || y >= surface->clip_max_y) {
+		return;
+	}
+	min_x = max_i32(min_x, surface->clip_min_x);
+	max_x = min_i32(max_x, surface->clip_max_x - 1);
+	i32 span_width = max_x - min_x + 1;
+	if (span_width <= 0) {
+		return;
+	}
+
+	// NOTE: 4 pixels per store, the few pixels left over one at a time
+	u32 *row = surface->pixels + min_x + ((i64)y * surface->width);
+	__m128i colors = _mm_set1_epi32((i32)color);
+	i32 x = 0;
+	for (; x + 4 <= span_width; x += 4) {
+		_mm_storeu_si128((__m128i*)(row + x), colors);
+	}
+	for (; x < span_width; x++) {
+		row[x] = color;
+	}
+}
+
+static void DrawClippedPixel(DrawSurface *surface, i32 x, i32 y, u32 color) {
+	if (x >= surface->clip_min_x && x < surface->clip_max_x && y >= surface->clip_min_y && y < surface->clip_max_y) {
+		surface->pixels[x + ((i64)y * surface->width)] = color;
+	}
+}
+
+// Midpoint circle around the pixel nearest to (pos_x, pos_y). Only the
+// first octant is stepped through, the other seven are its reflections.
+void DrawCircle(DrawSurface *surface, i32 radius, f32 pos_x, f32 pos_y, u32 color) {
+	i32 center_x = RoundNearest(pos_x);
+	i32 center_y = RoundNearest(pos_y);
+	if (radius < 0 || !OverlapsClip(surface, center_x - radius, center_y - radius, center_x + radius, center_y + radius)) {
+		return;
+	}
+
+	// NOTE: Skip the clip test per pixel when the whole circle is inside,
+	//       which is every meteor that isn't on a tile or screen edge.
+	b8 inside = center_x - radius >= surface->clip_min_x && center_x + radius < surface->clip_max_x &&
+		center_y - radius >= surface->clip_min_y && center_y + radius < surface->clip_max_y;
+
+	i32 x = radius;
+	i32 y = 0;
+	i32 decision = 1 - radius;
+	while (x >= y) {
+		// the points on the axes and the diagonals are their own reflections
+		i32 point_count = 8;
+		i32 points[8][2] = {
+			{ x, y }, { -x, -y }, { -y, x }, { y, -x },
+			{ y, x }, { -y, -x }, { -x, y }, { x, -y },
+		};
+		if (y == 0 || x == y) {
+			point_count = 4;
+		}
+		for (i32 i = 0; i < point_count; i++) {
+			i32 pixel_x = center_x + points[i][0];
+			i32 pixel_y = center_y + points[i][1];
+			if (inside) {
+				surface->pixels[pixel_x + ((i64)pixel_y * surface->width)] = color;
+			} else {
+				DrawClippedPixel(surface, pixel_x, pixel_y, color);
+			}
+		}
+
+		y += 1;
+		if (decision < 0) {
+			decision += (2 * y) + 1;
+		} else {
+			x -= 1;
+			decision += (2 * (y - x)) + 1;
+		}
+	}
+}
+
+// Filled midpoint circle, the same pixels as DrawCircle and everything
+// inside them, as one horizontal span per row
+void DrawDisc(DrawSurface *surface, i32 radius, f32 pos_x, f32 pos_y, u32 color) {
+	i32 center_x = RoundNearest(pos_x);
+	i32 center_y = RoundNearest(pos_y);
+	if (radius < 0 || !OverlapsClip(surface, center_x - radius, center_y - radius, center_x + radius, center_y + radius)) {
+		return;
+	}
+
+	i32 x = radius;
+	i32 y = 0;
+	i32 decision = 1 - radius;
+	while (x >= y) {
+		// rows center_y +- y are as wide as x
+		DrawSpan(surface, center_y + y, center_x - x, center_x + x, color);
+		if (y != 0) {
+			DrawSpan(surface, center_y - y, center_x - x, center_x + x, color);
+		}
+
+		i32 previous_x = x;
+		i32 previous_y = y;
+		y += 1;
+		if (decision < 0) {
+			decision += (2 * y) + 1;
+		} else {
+			x -= 1;
+			decision += (2 * (y - x)) + 1;
+		}
+
+		// rows center_y +- previous_x are as wide as the last y before x
+		// moves on, and were drawn above already once x gets down to y
+		if (x != previous_x && previous_x > previous_y) {
+			DrawSpan(surface, center_y + previous_x, center_x - previous_y, center_x + previous_y, color);
+			DrawSpan(surface, center_y - previous_x, center_x - previous_y, center_x + previous_y, color);
+		}
+	}
+}
+
+void DrawRectangle(DrawSurface *surface, i32 offset_x, i32 offset_y, i32 rectangle_width, i32 rectangle_height, u32 color) {
+	i32 min_x = max_i32(offset_x, surface->clip_min_x);
+	i32 max_x = min_i32(offset_x + rectangle_width, surface->clip_max_x);
+	i32 min_y = max_i32(offset_y, surface->clip_min_y);
+	i32 max_y = min_i32(offset_y + rectangle_height, surface->clip_max_y);
+	i32 clipped_width = max_x - min_x;
+	if (clipped_width <= 0) {
+		return;
+	}
+
+	for (i32 y = min_y; y < max_y; y++) {
+		// Chose this approach because setting each pixel
+		// sequentially was taking 1ms+ depending on the
+		// size of the screen.
+		u32 *row = surface->pixels + min_x + (y * surface->width);
+#if _MSC_VER
+		__stosd((unsigned long*)row, color, clipped_width);
+#else
+		for (i32 x = 0; x < clipped_width; x++) {
+			row[x] = color;
+		}
+#endif
+	}
+}
+
+// Cohen-Sutherland outcode of the pixel against the clip rectangle
+enum {
+	LineOutCode_Left = 1,
+	LineOutCode_Right = 2,
+	LineOutCode_Top = 4,
+	LineOutCode_Bottom = 8,
+};
+
+static u32 LineOutCode(DrawSurface *surface, i32 x, i32 y) {
+	u32 code = 0;
+	if (x < surface->clip_min_x) {
+		code |= LineOutCode_Left;
+	} else if (x >= surface->clip_max_x) {
+		code |= LineOutCode_Right;
+	}
+	if (y < surface->clip_min_y) {
+		code |= LineOutCode_Top;
+	} else if (y >= surface->clip_max_y) {
+		code |= LineOutCode_Bottom;
+	}
+	return code;
+}
+
+// Bresenham line from pixel (x0, y0) to pixel (x1, y1), both included.
+//
+// NOTE: Step k along the major axis moves the minor axis by
+//       floor((2 * k * minor + major) / (2 * major)), so the clipped part
+//       of a line starts on the same error term it would have had without
+//       clipping. The tiled renderer relies on this: a line crossing several
+//       tiles draws exactly the pixels it would have drawn on the whole
+//       surface, no matter where the tile edges cut it.
+void DrawLinePixels(DrawSurface *surface, i32 x0, i32 y0, i32 x1, i32 y1, u32 color) {
+	u32 code0 = LineOutCode(surface, x0, y0);
+	u32 code1 = LineOutCode(surface, x1, y1);
+	if (code0 & code1) {
+		// both ends are past the same edge
+		return;
+	}
+
+	i32 dx = x1 > x0 ? x1 - x0 : x0 - x1;
+	i32 dy = y1 > y0 ? y1 - y0 : y0 - y1;
+	i32 step_x = x1 > x0 ? 1 : -1;
+	i32 step_y = y1 > y0 ? 1 : -1;
+
+	b8 x_major = dx >= dy;
+	i64 major = x_major ? dx : dy;
+	i64 minor = x_major ? dy : dx;
+	i32 major_start = x_major ? x0 : y0;
+	i32 minor_start = x_major ? y0 : x0;
+	i32 major_sign = x_major ? step_x : step_y;
+	i32 minor_sign = x_major ? step_y : step_x;
+
+	i64 first = 0;
+	i64 last = major;
+	if (code0 | code1) {
+		// clip both ends to the steps that land inside the clip rectangle
+		i32 major_min = x_major ? surface->clip_min_x : surface->clip_min_y;
+		i32 major_max = (x_major ? surface->clip_max_x : surface->clip_max_y) - 1;
+		i32 minor_min = x_major ? surface->clip_min_y : surface->clip_min_x;
+		i32 minor_max = (x_major ? surface->clip_max_y : surface->clip_max_x) - 1;
+
+		i64 major_low = major_sign > 0 ? (i64)major_min - major_start : (i64)major_start - major_max;
+		i64 major_high = major_sign > 0 ? (i64)major_max - major_start : (i64)major_start - major_min;
+		first = major_low > first ? major_low : first;
+		last = major_high < last ? major_high : last;
+
+		// the minor axis is inside the clip after [low, high] minor steps
+		i64 low = minor_sign > 0 ? (i64)minor_min - minor_start : (i64)minor_start - minor_max;
+		i64 high = minor_sign > 0 ? (i64)minor_max - minor_start : (i64)minor_start - minor_min;
+		if (high < 0) {
+			return;
+		}
+		if (minor == 0) {
+			if (low > 0) {
+				return;
+			}
+		} else {
+			// first step with low minor steps, last step before high + 1
+			if (low > 0) {
+				i64 low_step = ((((2 * low) - 1) * major) + (2 * minor) - 1) / (2 * minor);
+				first = low_step > first ? low_step : first;
+			}
+			i64 high_step = (((((2 * high) + 1) * major) + (2 * minor) - 1) / (2 * minor)) - 1;
+			last = high_step < last ? high_step : last;
+		}
+		if (first > last) {
+			return;
+		}
+	}
+
+	i64 error = 0;
+	i64 minor_steps = 0;
+	if (major) {
+		i64 numerator = (2 * first * minor) + major;
+		minor_steps = numerator / (2 * major);
+		error = numerator % (2 * major);
+	}
+
+	i32 x = x0 + (i32)(x_major ? first * step_x : minor_steps * step_x);
+	i32 y = y0 + (i32)(x_major ? minor_steps * step_y : first * step_y);
+	u32 *pixel = surface->pixels + x + ((i64)y * surface->width);
+	i64 major_stride = x_major ? step_x : (i64)step_y * surface->width;
+	i64 minor_stride = x_major ? (i64)step_y * surface->width : step_x;
+	i64 error_step = 2 * minor;
+	i64 error_wrap = 2 * major;
+	for (i64 k = first; k <= last; k++) {
+		*pixel = color;
+		if (k == last) {
+			break;
+		}
+		pixel += major_stride;
+		error += error_step;
+		if (error >= error_wrap) {
+			error -= error_wrap;
+			pixel += minor_stride;
+		}
+	}
+}
+
+// Lines start and end on the pixels nearest to the points
+void DrawLine(DrawSurface *surface, Point p1, Point p2, u32 color) {
+	DrawLinePixels(surface, RoundNearest(p1.x), RoundNearest(p1.y), RoundNearest(p2.x), RoundNearest(p2.y), color);
+}
+
+// Lines between consecutive points, and from the last point back to the
+// first when closed
+void DrawPolyline(DrawSurface *surface, Point *points, i32 point_count, b8 closed, u32 color) {
+	if (point_count <= 0) {
+		return;
+	}
+	i32 previous_x = RoundNearest(points[0].x);
+	i32 previous_y = RoundNearest(points[0].y);
+	i32 first_x = previous_x;
+	i32 first_y = previous_y;
+	if (point_count == 1) {
+		DrawLinePixels(surface, first_x, first_y, first_x, first_y, color);
+		return;
+	}
+	for (i32 i = 1; i < point_count; i++) {
+		i32 x = RoundNearest(points[i].x);
+		i32 y = RoundNearest(points[i].y);
+		DrawLinePixels(surface, previous_x, previous_y, x, y, color);
+		previous_x = x;
+		previous_y = y;
+	}
+	if (closed && point_count > 2) {
+		DrawLinePixels(surface, previous_x, previous_y, first_x, first_y, color);
+	}
+}
+
+// Fills a convex polygon with its points in order around it, either way
+// round. A pixel is filled when its coordinates are inside or on an edge.
+//
+// NOTE: The edges down the two sides from the top point are walked row by
+//       row, and every row is filled as one span. Each row's edge x is
+//       worked out from the edge's top point rather than stepped from the
+//       row above, so the tiled renderer gets the same spans whichever row
+//       its tile starts on.
+void DrawConvexPolygon(DrawSurface *surface, Point *points, i32 point_count, u32 color) {
+	if (point_count < 3) {
+		return;
+	}
+	i32 top = 0;
+	i32 bottom = 0;
+	for (i32 i = 1; i < point_count; i++) {
+		if (points[i].y < points[top].y) {
+			top = i;
+		}
+		if (points[i].y > points[bottom].y) {
+			bottom = i;
+		}
+	}
+	i32 min_y = max_i32(my_ceil(points[top].y), surface->clip_min_y);
+	i32 max_y = min_i32(my_floor(points[bottom].y), surface->clip_max_y - 1);
+	if (min_y > max_y) {
+		return;
+	}
+
+	// one side goes forwards through the points from the top, the other backwards
+	i32 sides[2][2] = { { top, top }, { top, top } }; // start and end point of the current edge
+	i32 side_steps[2] = { 1, point_count - 1 };
+	f32 slopes[2] = {0};
+	for (i32 y = min_y; y <= max_y; y++) {
+		f32 row_y = (f32)y;
+		f32 edge_x[2];
+		for (i32 side = 0; side < 2; side++) {
+			i32 *edge = sides[side];
+			// move on to the edge that ends below the row, points on the row
+			// are the start of the next edge
+			while (edge[1] != bottom && (edge[1] == top || points[edge[1]].y <= row_y)) {
+				edge[0] = edge[1];
+				edge[1] = (edge[1] + side_steps[side]) % point_count;
+				Point start = points[edge[0]];
+				Point end = points[edge[1]];
+				slopes[side] = end.y != start.y ? (end.x - start.x) / (end.y - start.y) : 0.0f;
+			}
+			Point start = points[edge[0]];
+			edge_x[side] = start.x + ((row_y - start.y) * slopes[side]);
+		}
+
+		i32 left = my_ceil(my_min(edge_x[0], edge_x[1]));
+		i32 right = my_floor(my_max(edge_x[0], edge_x[1]));
+		DrawSpan(surface, y, left, right, color);
+	}
+}
+
+Vec2i Subtracti(Vec2i a, Vec2i b) {
+	Vec2i result = {0};
+	result.x = a.x - b.x;
+	result.y = a.y - b.y;
+	return result;
+}
+
+Vec2 Subtract(Vec2 a, Vec2 b) {
+	Vec2 result = {0};
+	result.x = a.x - b.x;
+	result.y = a.y - b.y;
+	return result;
+}
+
+f32 Length(Vec2i v) {
+	f32 result = my_sqrt((f32)(v.x*v.x)+(v.y*v.y));
+	return result;
+}
+
+typedef char Flag;
+#define FLAG_UNSET 0;
+#define FLAG_SET 1;
+
+#define MISSILE_POOL_SIZE 16
+#define MISSILE_WIDTH 4.0f
+#define MISSILE_HEIGHT 8.0f
+#define METEOR_POOL_SIZE 32
+#define INITIAL_METEOR_COUNT 24
+
+// NOTE: Platform layers can change these before the first frame, for stress
+//       runs. The pools and the render command buffers are made once, from
+//       the capacities, when the game first starts and never grow, so play
+//       never allocates. Changing gMeteorsBounce mid game would break input
+//       recordings.
+static i32 gMeteorCapacity = METEOR_POOL_SIZE;
+static i32 gMissileCapacity = MISSILE_POOL_SIZE;
+static i32 gInitialMeteorCount = INITIAL_METEOR_COUNT;
+static b8 gMeteorsBounce = 0; // off, meteors pass through each other
+
+MissilePool Missiles;
+MeteorPool Meteors;
+static void *GameMemory = 0;
+
+static Flag Flag_Initialized = FLAG_UNSET;
+static Flag Flag_DrawShip = FLAG_SET;
+static b8 PlayerDead = 0;
+static b8 GameOver = 0;
+static i32 PlayerLives = 3;
+static i32 Score = 0;
+static f32 TimeSincePlayerDied = 0.0f;
+static f32 TimeSinceLastDrawShipFlagFlipped = 0.0f;
+static Vec2 ShipPosition = {0};
+static Vec2 ShipVelocity = {0};
+static f32 ShipRotationRadians = 0.0f;
+static Vec2 PreviousShipPosition = {0};
+static f32 PreviousShipRotationRadians = 0.0f;
+static f32 SimulationAccumulator = 0.0f;
+
+// NOTE: The game uses its own xorshift generator instead of rand() so a seed
+//       produces the same meteors on every platform, which is what makes
+//       input recordings replayable.
+Flag RandomInitialized = FLAG_UNSET;
+static u32 RandomState = 0;
+
+void SeedRandom(u32 seed) {
+	// xorshift gets stuck at zero
+	RandomState = seed ? seed : 0x9E3779B9;
+	RandomInitialized = FLAG_SET;
+}
+
+u32 RandomNext() {
+	if (!RandomInitialized) {
+		SeedRandom((u32)time(0));
+	}
+	u32 x = RandomState;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	RandomState = x;
+	return x;
+}
+
+i32 GenerateRandomNumber(i32 min, i32 max) {
+	i32 random_number = (i32)(RandomNext() % (u32)(max - min + 1)) + min;
+	return random_number;
+}
+
+#include "stdarg.h"
+#include "stdio.h"
+
+// NOTE: Platforms without a debugger output stream write to stderr, which
+//       can be turned off so benchmark runs aren't measuring console writes.
+static b8 gConsoleOutputEnabled = 1;
+
+static void Platform_WriteConsole(char *format, ...) {
+	if (!gConsoleOutputEnabled) return;
+	va_list args;
+	va_start(args, format);
+	char msg[1024] = {0};
+#if _WIN32
+	vsprintf_s(msg, 1024, format, args);
+	OutputDebugString(msg);
+#else
+	vsnprintf(msg, sizeof(msg), format, args);
+	fputs(msg, stderr);
+#endif
+	va_end(args);
+}
+
+// Ends the game. The Win32 layer exits right away, other platform layers
+// finish the current frame and stop when they see gShouldCloseWindow.
+static void Platform_Quit(char *message) {
+#if _WIN32
+	if (message) {
+		MessageBox(NULL, message, "Asteroids!", MB_OK);
+	}
+	ExitProcess(0);
+#else
+	if (message) {
+		Platform_WriteConsole("%s\n", message);
+	}
+	gShouldCloseWindow = 1;
+#endif
+}
+
+void SpawnMeteor(Vec2 position, i32 radius, i32 speed) {
+	i32 slot = MeteorPool_Add(&Meteors);
+	if (slot < 0) {
+		Platform_WriteConsole("Unable to spawn a Meteor, the pool is full!\n");
+		return;
+	}
+
+	Meteors.x[slot] = position.x;
+	Meteors.y[slot] = position.y;
+	Meteors.previous_x[slot] = position.x;
+	Meteors.previous_y[slot] = position.y;
+	Meteors.radius[slot] = (f32)radius;
+	Meteors.speed[slot] = (f32)speed;
+	Meteors.struck[slot] = 0;
+	
+	f32 rand_x = (f32)GenerateRandomNumber(0, 1000);
+	if (GenerateRandomNumber(0, 10) >= 5) {
+		rand_x *= -1.0f;
+	}
+	
+	f32 rand_y = (f32)GenerateRandomNumber(0, 1000);
+	if (GenerateRandomNumber(0, 10) >= 5) {
+		rand_y *= -1.0f;
+	}
+	
+	f32 length = my_sqrt((rand_x * rand_x) + (rand_y * rand_y));
+	rand_x /= length;
+	rand_y /= length;
+	
+	Meteors.dx[slot] = rand_x;
+	Meteors.dy[slot] = rand_y;
+	
+	Platform_WriteConsole("SpawnMeteor() Dir: x=%f y=%f\n", rand_x, rand_y);
+}
+
+// Advances x past the text
+void DrawTextRun(DrawSurface *surface, char *text, i32 text_length, u32 color, i32 *x, i32 *y) {
+	KDTF_DrawTextClipped(&gFont, text, text_length, color, x, y, surface->pixels, surface->width, surface->height,
+		surface->clip_min_x, surface->clip_min_y, surface->clip_max_x, surface->clip_max_y);
+}
+
+i32 RoundNearestFloat(f32 value) {
+	i32 floored = Floor(value);
+	if ((value - (f32)floored) < 0.5f) {
+		return floored;
+	} else {
+		return floored + 1;
+	}
+}
+
+void NewLine(i32 *y_coordinate) {
+	i32 new_coordinate = *y_coordinate + gFont.line_height;
+	*y_coordinate = new_coordinate;
+}
+
+b8 MouseOverMenuButton(char *text, i32 at_x, i32 at_y, i32 mouse_x, i32 mouse_y) {
+	i32 text_length = (i32)strlen(text);
+	
+	b8 MouseHoveringOverButton = 0;
+	
+	i32 text_width = gFont.atlas.glyph_width * text_length;
+	if (mouse_x >= at_x && mouse_x <= (at_x + text_width)) {
+		if (mouse_y >= at_y && mouse_y <= (at_y + gFont.atlas.glyph_height)) {
+			MouseHoveringOverButton = 1;
+		}
+	}
+	
+	return MouseHoveringOverButton;
+}
+
+void *MyAlloc(u64 size) {
+#if _WIN32
+	return VirtualAlloc(0, size, MEM_RESERVE|MEM_COMMIT, PAGE_READWRITE);
+#else
+	return calloc(1, size);
+#endif
+}
+
+void MyFree(void *ptr) {
+#if _WIN32
+	VirtualFree(ptr, 0, MEM_RELEASE);
+#else
+	free(ptr);
+#endif
+}
+
+// Every pool array starts on its own cache line
+#define POOL_ARRAY_ALIGNMENT 64
+
+// Takes capacity elements off the front of the reservation at *at
+static void *Pool_TakeArray(u8 **at, i32 capacity, u64 element_size) {
+	void *array = *at;
+	u64 size = (u64)capacity * element_size;
+	*at += (size + (POOL_ARRAY_ALIGNMENT - 1)) & ~(u64)(POOL_ARRAY_ALIGNMENT - 1);
+	return array;
+}
+
+// Lays the pool's arrays out from memory onwards. With memory 0 it only
+// works out the size, the pool is garbage afterwards.
+// RETURNS: the number of bytes the pool takes
+u64 MissilePool_Place(MissilePool *pool, i32 capacity, u8 *memory) {
+	memset(pool, 0, sizeof(*pool));
+	pool->capacity = capacity;
+	u8 *at = memory;
+	for (i32 k = 0; k < MISSILE_CORNER_COUNT; k++) {
+		pool->x[k] = (f32*)Pool_TakeArray(&at, capacity, sizeof(f32));
+		pool->y[k] = (f32*)Pool_TakeArray(&at, capacity, sizeof(f32));
+		pool->previous_x[k] = (f32*)Pool_TakeArray(&at, capacity, sizeof(f32));
+		pool->previous_y[k] = (f32*)Pool_TakeArray(&at, capacity, sizeof(f32));
+	}
+	pool->dx = (f32*)Pool_TakeArray(&at, capacity, sizeof(f32));
+	pool->dy = (f32*)Pool_TakeArray(&at, capacity, sizeof(f32));
+	pool->rotation = (f32*)Pool_TakeArray(&at, capacity, sizeof(f32));
+	pool->off_screen = (u8*)Pool_TakeArray(&at, capacity, sizeof(u8));
+	pool->spent = (u8*)Pool_TakeArray(&at, capacity, sizeof(u8));
+	pool->hits = (MissileHit*)Pool_TakeArray(&at, capacity, sizeof(MissileHit));
+	return (u64)(at - memory);
+}
+
+// See MissilePool_Place
+u64 MeteorPool_Place(MeteorPool *pool, i32 capacity, u8 *memory) {
+	memset(pool, 0, sizeof(*pool));
+	pool->capacity = capacity;
+	u8 *at = memory;
+	pool->x = (f32*)Pool_TakeArray(&at, capacity, sizeof(f32));
+	pool->y = (f32*)Pool_TakeArray(&at, capacity, sizeof(f32));
+	pool->previous_x = (f32*)Pool_TakeArray(&at, capacity, sizeof(f32));
+	pool->previous_y = (f32*)Pool_TakeArray(&at, capacity, sizeof(f32));
+	pool->dx = (f32*)Pool_TakeArray(&at, capacity, sizeof(f32));
+	pool->dy = (f32*)Pool_TakeArray(&at, capacity, sizeof(f32));
+	pool->speed = (f32*)Pool_TakeArray(&at, capacity, sizeof(f32));
+	pool->radius = (f32*)Pool_TakeArray(&at, capacity, sizeof(f32));
+	pool->struck = (u8*)Pool_TakeArray(&at, capacity, sizeof(u8));
+	pool->grid.cell_starts = (i32*)Pool_TakeArray(&at, METEOR_GRID_CELL_COUNT + 1, sizeof(i32));
+	pool->grid.meteors = (i32*)Pool_TakeArray(&at, capacity, sizeof(i32));
+	pool->grid.cells = (i32*)Pool_TakeArray(&at, capacity, sizeof(i32));
+	pool->grid.candidates = (i32*)Pool_TakeArray(&at, capacity, sizeof(i32));
+	pool->grid.candidate_x = (f32*)Pool_TakeArray(&at, capacity, sizeof(f32));
+	pool->grid.candidate_y = (f32*)Pool_TakeArray(&at, capacity, sizeof(f32));
+	pool->grid.candidate_radius = (f32*)Pool_TakeArray(&at, capacity, sizeof(f32));
+	pool->grid.candidate_times = (f32*)Pool_TakeArray(&at, capacity, sizeof(f32));
+	pool->grid.candidate_hits = (u32*)Pool_TakeArray(&at, (capacity + 31) / 32, sizeof(u32));
+	pool->sweep = (MeteorSweepEntry*)Pool_TakeArray(&at, capacity, sizeof(MeteorSweepEntry));
+	pool->sweep_positions = (i32*)Pool_TakeArray(&at, capacity, sizeof(i32));
+	return (u64)(at - memory);
+}
+
+// Makes both pools, empty, out of one allocation. Nothing is allocated after
+// this: spawning takes a free slot and fails when there are none.
+// RETURNS: the allocation, for EntityPools_Destroy, or 0 if it failed
+void *EntityPools_Create(MeteorPool *meteors, i32 meteor_capacity, MissilePool *missiles, i32 missile_capacity) {
+	u64 meteor_size = MeteorPool_Place(meteors, meteor_capacity, 0);
+	u64 missile_size = MissilePool_Place(missiles, missile_capacity, 0);
+	// MyAlloc only promises 16 byte alignment
+	u8 *memory = (u8*)MyAlloc(meteor_size + missile_size + POOL_ARRAY_ALIGNMENT);
+	if (!memory) {
+		memset(meteors, 0, sizeof(*meteors));
+		memset(missiles, 0, sizeof(*missiles));
+		return 0;
+	}
+	u8 *aligned = (u8*)(((size_t)memory + (POOL_ARRAY_ALIGNMENT - 1)) & ~(size_t)(POOL_ARRAY_ALIGNMENT - 1));
+	MeteorPool_Place(meteors, meteor_capacity, aligned);
+	MissilePool_Place(missiles, missile_capacity, aligned + meteor_size);
+	return memory;
+}
+
+void EntityPools_Destroy(MeteorPool *meteors, MissilePool *missiles, void *memory) {
+	MyFree(memory);
+	memset(meteors, 0, sizeof(*meteors));
+	memset(missiles, 0, sizeof(*missiles));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////
+/// Input Recording
+///
+/// A recording is the RNG seed, surface size, starting meteor count, pool
+/// sizes and rule flags the session started with, followed by the input
+/// state captured before every simulation step. Playing it back from a fresh
+/// game reproduces the session exactly, no matter the frame rate, so it can
+/// be used as a fixed benchmark workload.
+///
+/// File layout (little endian):
+///   InputRecordingHeader
+///   step_count * INPUT_STEP_RECORD_SIZE bytes:
+///     u8  button flags (INPUT_BUTTON_*)
+///     i16 mouse x
+///     i16 mouse y
+
+#define INPUT_RECORDING_MAGIC 0x43455241 // "AREC"
+// NOTE: Bumped whenever the header or the simulation changes, an old
+//       recording would no longer replay the same session
+#define INPUT_RECORDING_VERSION 6
+#define INPUT_STEP_RECORD_SIZE 5
+
+#define INPUT_BUTTON_ROTATE_LEFT 0x01
+#define INPUT_BUTTON_ROTATE_RIGHT 0x02
+#define INPUT_BUTTON_MOVE_FORWARD 0x04
+#define INPUT_BUTTON_SHOOT 0x08
+#define INPUT_BUTTON_MOUSE_LEFT 0x10
+#define INPUT_BUTTON_PAUSED 0x20
+
+#define INPUT_RECORDING_FLAG_METEORS_BOUNCE 0x01
+
+typedef struct {
+	u32 magic;
+	u32 version;
+	u32 seed;
+	i32 width;
+	i32 height;
+	i32 initial_meteor_count;
+	i32 meteor_capacity;
+	i32 missile_capacity;
+	u32 flags; // INPUT_RECORDING_FLAG_*
+	u32 step_count;
+} InputRecordingHeader;
+
+typedef struct {
+	// header followed by the step records, so saving is a single write
+	u8 *data;
+	u64 size;
+	u64 capacity;
+	u64 playback_offset;
+} InputRecording;
+
+// The recording SimulateFrame records into or plays back from, if any
+static InputRecording *gInputRecording = 0;
+static b8 gInputPlayback = 0;
+
+InputRecordingHeader *InputRecording_Header(InputRecording *recording) {
+	return (InputRecordingHeader*)recording->data;
+}
+
+// Resets the game and the RNG so the recording starts from a known state
+void InputRecording_BeginSession(u32 seed) {
+	SeedRandom(seed);
+	Flag_Initialized = FLAG_UNSET;
+	gPaused = 0;
+	SimulationAccumulator = 0.0f;
+}
+
+void InputRecording_BeginRecording(InputRecording *recording, u32 seed, i32 width, i32 height) {
+	if (!recording->data) {
+		recording->capacity = Megabytes(1);
+		recording->data = (u8*)MyAlloc(recording->capacity);
+		Assert(recording->data);
+	}
+
+	InputRecordingHeader *header = InputRecording_Header(recording);
+	header->magic = INPUT_RECORDING_MAGIC;
+	header->version = INPUT_RECORDING_VERSION;
+	header->seed = seed;
+	header->width = width;
+	header->height = height;
+	header->initial_meteor_count = gInitialMeteorCount;
+	header->meteor_capacity = gMeteorCapacity;
+	header->missile_capacity = gMissileCapacity;
+	header->flags = gMeteorsBounce ? INPUT_RECORDING_FLAG_METEORS_BOUNCE : 0;
+	header->step_count = 0;
+	recording->size = sizeof(InputRecordingHeader);
+	recording->playback_offset = 0;
+
+	InputRecording_BeginSession(seed);
+	gInputRecording = recording;
+	gInputPlayback = 0;
+}
+
+// Stops recording or playing back, the recording itself is kept
+void InputRecording_End() {
+	gInputRecording = 0;
+	gInputPlayback = 0;
+}
+
+// Captures the input globals, called right before each simulation step
+void InputRecording_RecordStep(InputRecording *recording) {
+	if (recording->size + INPUT_STEP_RECORD_SIZE > recording->capacity) {
+		// only happens every doubling, not every frame
+		u64 new_capacity = recording->capacity * 2;
+		u8 *new_data = (u8*)MyAlloc(new_capacity);
+		Assert(new_data);
+		memcpy(new_data, recording->data, recording->size);
+		MyFree(recording->data);
+		recording->data = new_data;
+		recording->capacity = new_capacity;
+	}
+
+	u8 buttons = 0;
+	buttons |= gRotateShipLeft ? INPUT_BUTTON_ROTATE_LEFT : 0;
+	buttons |= gRotateShipRight ? INPUT_BUTTON_ROTATE_RIGHT : 0;
+	buttons |= gMoveShipForward ? INPUT_BUTTON_MOVE_FORWARD : 0;
+	buttons |= gShootMissile ? INPUT_BUTTON_SHOOT : 0;
+	buttons |= MouseLeftButtonDown ? INPUT_BUTTON_MOUSE_LEFT : 0;
+	buttons |= gPaused ? INPUT_BUTTON_PAUSED : 0;
+
+	u8 *record = recording->data + recording->size;
+	record[0] = buttons;
+	record[1] = (u8)(MouseX & 0xFF);
+	record[2] = (u8)((MouseX >> 8) & 0xFF);
+	record[3] = (u8)(MouseY & 0xFF);
+	record[4] = (u8)((MouseY >> 8) & 0xFF);
+
+	recording->size += INPUT_STEP_RECORD_SIZE;
+	InputRecording_Header(recording)->step_count += 1;
+}
+
+// Takes ownership of the file contents.
+// RETURNS: 1 when the contents are a valid recording
+b8 InputRecording_Load(InputRecording *recording, void *file_contents, u64 file_size) {
+	if (file_size < sizeof(InputRecordingHeader)) {
+		return 0;
+	}
+
+	InputRecordingHeader *header = (InputRecordingHeader*)file_contents;
+	if (header->magic != INPUT_RECORDING_MAGIC || header->version != INPUT_RECORDING_VERSION) {
+		return 0;
+	}
+	if (header->width <= 0 || header->height <= 0) {
+		return 0;
+	}
+	if (header->initial_meteor_count < 0 || header->meteor_capacity < 1 || header->missile_capacity < 1) {
+		return 0;
+	}
+	if (header->flags & ~(u32)INPUT_RECORDING_FLAG_METEORS_BOUNCE) {
+		return 0;
+	}
+	u64 expected_size = sizeof(InputRecordingHeader) + ((u64)header->step_count * INPUT_STEP_RECORD_SIZE);
+	if (file_size < expected_size) {
+		return 0;
+	}
+
+	recording->data = (u8*)file_contents;
+	recording->size = expected_size;
+	recording->capacity = file_size;
+	recording->playback_offset = 0;
+	return 1;
+}
+
+void InputRecording_BeginPlayback(InputRecording *recording) {
+	InputRecordingHeader *header = InputRecording_Header(recording);
+	recording->playback_offset = sizeof(InputRecordingHeader);
+	// the recording's rules hold for the whole playback
+	gMeteorsBounce = (header->flags & INPUT_RECORDING_FLAG_METEORS_BOUNCE) != 0;
+	InputRecording_BeginSession(header->seed);
+	gInputRecording = recording;
+	gInputPlayback = 1;
+}
+
+b8 InputRecording_PlaybackFinished(InputRecording *recording) {
+	return recording->playback_offset + INPUT_STEP_RECORD_SIZE > recording->size;
+}
+
+// Overwrites the input globals with the next recorded step, called right before each simulation step
+// RETURNS: 0 once every step has been played back
+b8 InputRecording_PlaybackStep(InputRecording *recording) {
+	if (InputRecording_PlaybackFinished(recording)) {
+		return 0;
+	}
+
+	u8 *record = recording->data + recording->playback_offset;
+	u8 buttons = record[0];
+	gRotateShipLeft = (buttons & INPUT_BUTTON_ROTATE_LEFT) != 0;
+	gRotateShipRight = (buttons & INPUT_BUTTON_ROTATE_RIGHT) != 0;
+	gMoveShipForward = (buttons & INPUT_BUTTON_MOVE_FORWARD) != 0;
+	gShootMissile = (buttons & INPUT_BUTTON_SHOOT) != 0;
+	MouseLeftButtonDown = (buttons & INPUT_BUTTON_MOUSE_LEFT) != 0;
+	gPaused = (buttons & INPUT_BUTTON_PAUSED) != 0;
+	MouseX = (i16)(record[1] | (record[2] << 8));
+	MouseY = (i16)(record[3] | (record[4] << 8));
+
+	recording->playback_offset += INPUT_STEP_RECORD_SIZE;
+	return 1;
+}
+
+#define PROFILE_OVERLAY_LINE_CHARACTERS 28
+#define PROFILE_OVERLAY_GRAPH_HEIGHT 100
+#define PROFILE_OVERLAY_MARGIN 10
+
+typedef struct {
+	i32 frame_count;
+	f32 max_frame_seconds;
+	// the frame time line followed by a line per timed block, formatted up
+	// front because the tiled renderer draws the overlay once per tile
+	char lines[TimedBlock_Count + 1][64];
+	f32 frame_seconds[PROFILE_FRAME_COUNT]; // [0] is the most recent frame
+} ProfileOverlay;
+
+// Per-phase timings averaged over the profile ring buffer and the recent
+// frame times. Taken on the thread that runs Profile_EndFrame, so the
+// overlay can be drawn on any thread.
+void GatherProfileOverlay(ProfileOverlay *overlay) {
+	overlay->frame_count = gProfile.frame_count;
+	if (gProfile.frame_count == 0) {
+		return;
+	}
+
+	u64 block_cycles[TimedBlock_Count] = {0};
+	f32 frame_seconds = 0.0f;
+	f32 max_frame_seconds = 1.0f / 60.0f;
+	for (i32 i = 0; i < gProfile.frame_count; i++) {
+		ProfileFrame *frame = Profile_GetFrame(i);
+		for (i32 block = 0; block < TimedBlock_Count; block++) {
+			block_cycles[block] += frame->block_cycles[block];
+		}
+		frame_seconds += frame->frame_seconds;
+		max_frame_seconds = my_max(max_frame_seconds, frame->frame_seconds);
+		overlay->frame_seconds[i] = frame->frame_seconds;
+	}
+	overlay->max_frame_seconds = max_frame_seconds;
+
+	f32 average_frame_ms = SECONDS_TO_MILLISECONDS(frame_seconds / gProfile.frame_count);
+	snprintf(overlay->lines[0], sizeof(overlay->lines[0]), "Frame %7.3fms %5.0ffps", average_frame_ms,
+		average_frame_ms > 0.0f ? 1000.0f / average_frame_ms : 0.0f);
+
+	f64 ms_per_cycle = SECONDS_TO_MILLISECONDS(Profile_SecondsPerCycle()) / gProfile.frame_count;
+	for (i32 block = 0; block < TimedBlock_Count; block++) {
+		snprintf(overlay->lines[block + 1], sizeof(overlay->lines[block + 1]), "%-17s%7.3fms",
+			TimedBlockNames[block], (f64)block_cycles[block] * ms_per_cycle);
+	}
+}
+
+/*
+	What could have been done better:
+		* Writing the usage code first
+			- Drawing text on the screen
+			- Clearing the background color			
+		* Use integers for position data instead of floats
+		* Do more calculations on data when looping over an array.
+		  I loop over the missile pool several times, performing
+		  different operations each time. Memory is the slowest thing
+		  you're going to be working with, so take advantage of the 
+		  data when it's already in memory
+		* Instead of using a boolean when there is a list of items,
+		  keep the list of items separate from that boolean value.
+		* Keep instruction level parallelism in mind
+	
+	What should I continue to do:
+		* Using pools when you have several entities of the same type,
+		  marking the entity as either alive/dead.
+		* Don't insert a split between updating and rendering the game
+		  artificially. In this case, the logic was much easier to understand.
+	
+	What I should stop doing:
+		* Don't put things into a global state struct until you need it for
+		  some reason.
+		* Rushing through fixing something
+*/
+
+// The simulation always advances in steps of SIMULATION_TIMESTEP seconds so
+// the game plays the same regardless of how fast frames are rendered. If a
+// frame takes so long that more than SIMULATION_MAX_STEPS_PER_FRAME steps
+// are due, the rest of the time is dropped so slow frames can't snowball.
+#define SIMULATION_TIMESTEP 0.003f
+#define SIMULATION_MAX_STEPS_PER_FRAME 32
+
+static void InitializeGame(i32 width, i32 height) {
+	Flag_DrawShip = FLAG_SET;
+	PlayerDead = 0;
+	PlayerLives = 3;
+	Score = 0;
+	TimeSincePlayerDied = 0.0f;
+	TimeSinceLastDrawShipFlagFlipped = 0.0f;
+
+	ShipPosition.x = (WindowWidth / 2.0f);
+	ShipPosition.y = (WindowHeight / 2.0f);
+	
+	ShipVelocity.x = 0.0f;
+	ShipVelocity.y = 0.0f;
+	
+	ShipRotationRadians = 0.0f;
+
+	PreviousShipPosition = ShipPosition;
+	PreviousShipRotationRadians = ShipRotationRadians;
+	
+	// NOTE: Restarting keeps the pools, SimulateFrame only ever makes them once
+	MeteorPool_Clear(&Meteors);
+	
+	i32 NumberOfMeteorsToIntialize = gInitialMeteorCount;
+	for (i32 i = 0; i < NumberOfMeteorsToIntialize; i++) {
+		Vec2 position = {0};
+		position.x = (f32)GenerateRandomNumber(0, width - 1);
+		position.y = (f32)GenerateRandomNumber(0, height - 1);
+		i32 radius = GenerateRandomNumber(20, 49);
+		i32 speed = GenerateRandomNumber(150, 249);
+		SpawnMeteor(position, radius, speed);
+	}
+	
+	Missiles.count = 0;
+	
+	Flag_Initialized = FLAG_SET;
+}
+
+// Ship triangle rotated around its centroid, then moved to (x, y)
+Triangle MakeShipTriangle(f32 rotation_radians, f32 x, f32 y) {
+	Triangle ship_triangle = {
+		.a = { 0, 0 },
+		.b = { 15, 45 },
+		.c = { 30, 0 }
+	};
+
+	// Use triangle centroid as the center of rotation
+	Transform2D transform = MakeTransform(rotation_radians, Centroid(ship_triangle), x, y);
+	TransformPoints(&transform, (Point*)&ship_triangle, 3);
+
+	return ship_triangle;
+}
+
+Vec2 ShipForwardDirection(Triangle ship_triangle) {
+	Point ship_center = Centroid(ship_triangle);
 	Vec2 ship_forward_direction = {0};
 	ship_forward_direction.x = ship_triangle.b.x - ship_center.x;
 	ship_forward_direction.y = ship_triangle.b.y - ship_center.y;
@@ -777,316 +2426,1577 @@ static void UpdateAndRender(f32 delta_time, DrawSurface *surface) {
 										(ship_forward_direction.y*ship_forward_direction.y));
 	ship_forward_direction.x /= forward_vector_length;
 	ship_forward_direction.y /= forward_vector_length;
+	return ship_forward_direction;
+}
+
+typedef struct {
+	i32 x;
+	i32 title_y;
+	i32 restart_y;
+	i32 quit_y;
+} PauseMenuLayout;
+
+PauseMenuLayout CalculatePauseMenuLayout(i32 width, i32 height) {
+	PauseMenuLayout result = {0};
+
+	f32 relative_x = 0.6f;
+	result.x = my_floor((f32)width * relative_x);
+	f32 relative_y = 0.4f;
+	i32 y = my_floor((f32)height * relative_y);
+
+	result.title_y = y;
+	NewLine(&y);
+	NewLine(&y);
+	result.restart_y = y;
+	NewLine(&y);
+	NewLine(&y);
+	result.quit_y = y;
+
+	return result;
+}
+
+// Advances the game by one simulation step, nothing is drawn here
+static void UpdateGame(f32 delta_time, i32 width, i32 height) {
+	if (!Flag_Initialized) {
+		InitializeGame(width, height);
+	}
+
+//	if (!Playing) {
+//		
+//	}
+	
+	if (gPaused) {
+		PauseMenuLayout menu = CalculatePauseMenuLayout(width, height);
+
+		b8 restart_pressed = MouseOverMenuButton("Restart", menu.x, menu.restart_y, MouseX, MouseY) && MouseLeftButtonDown;
+		if (restart_pressed) {
+			Flag_Initialized = FLAG_UNSET;
+			gPaused = 0;
+		}
+		
+		b8 quit_pressed = MouseOverMenuButton("Quit", menu.x, menu.quit_y, MouseX, MouseY) && MouseLeftButtonDown;
+		if (quit_pressed) Platform_Quit(0);
+				
+		return;
+	}
+
+	// Keep the state the last step ended with so rendering can interpolate
+	PreviousShipPosition = ShipPosition;
+	PreviousShipRotationRadians = ShipRotationRadians;
+	MissilePool_SavePrevious(&Missiles);
+	MeteorPool_SavePrevious(&Meteors);
+	
+	BEGIN_TIMED_BLOCK(ShipTransform);
+
+	//////////////////////////////////////////////
+	/// Apply Rotation
+	///
+	if (!PlayerDead) {
+		if (gRotateShipLeft && !gRotateShipRight) {
+			ShipRotationRadians -= delta_time * SHIP_ROTATION_STEP;
+		} else if (gRotateShipRight) {
+			ShipRotationRadians += delta_time * SHIP_ROTATION_STEP;
+		}
+	}
+
+	// NOTE: Rotated but not moved yet, the direction and the size don't depend on the position
+	Triangle ship_shape = MakeShipTriangle(ShipRotationRadians, 0.0f, 0.0f);
+	Vec2 ship_forward_direction = ShipForwardDirection(ship_shape);
+	//////////////////////////////////////////////
+	//////////////////////////////////////////////
+	
+
+	///////////////////////////////////////////////
+	/// Apply Translation
+	///
+	ShipVelocity.x *= .9965f;
+	ShipVelocity.y *= .9965f;
+
+	if (!PlayerDead) {	
+		if (gMoveShipForward) {		
+			f32 acceleration = 3.0f; // u/s^2
+	
+			ShipVelocity.x += ship_forward_direction.x * (delta_time * acceleration);
+			ShipVelocity.y += ship_forward_direction.y * (delta_time * acceleration);
+		}
+	}
+	
+	ShipPosition.x += ShipVelocity.x;
+	ShipPosition.y += ShipVelocity.y;
+
+	{
+		Extents e = CalculateExtents((Point*)&ship_shape, 3);
+		i32 ship_draw_area_width = e.max_x - e.min_x;
+		i32 ship_draw_area_height = e.max_y - e.min_y;	
+
+		// don't check <= because ship_pos_x will be equal if
+		// it goes off the right side of the screen
+		if (ShipPosition.x < -ship_draw_area_width) {
+			// went off left side of screen
+			ShipPosition.x = (f32)(width - 1);
+		} else if (ShipPosition.x > (width - 1)) {
+			// went off right side of screen
+			ShipPosition.x = (f32)-ship_draw_area_width;
+		}
+
+		// don't check <= because ship_pos_y will be equal if
+		// it goes off the top side of the screen
+		if (ShipPosition.y < -ship_draw_area_height) {
+			// ship went off bottom of screen
+			ShipPosition.y = (f32)(height - 1);
+		} else if (ShipPosition.y > (height - 1)) {
+			// ship went off top of screen
+			ShipPosition.y = (f32)-ship_draw_area_height;
+		}
+	}
+
+	Triangle ship_triangle = MakeShipTriangle(ShipRotationRadians, ShipPosition.x, ShipPosition.y);
+	Point *ship_points = (Point*)&ship_triangle;
+
+	END_TIMED_BLOCK(ShipTransform);
+
 	//////////////////////////////////////////////
 	//////////////////////////////////////////////
 	
+	///////////////////////////////////////////////
+	///////////////////////////////////////////////
+
+	BEGIN_TIMED_BLOCK(MissileUpdate);
+
+	{
+		MissilePool_Integrate(&Missiles, delta_time, width, height);
+		// backwards, so removing a missile doesn't move one that's still to be looked at
+		for (i32 missile = Missiles.count - 1; missile >= 0; missile--) {
+			if (Missiles.off_screen[missile]) {
+				Platform_WriteConsole("Missile destroyed!\n");
+				MissilePool_Remove(&Missiles, missile);
+			}
+		}
+	}
+
+	if (!PlayerDead && gShootMissile) {
+		i32 new_missile = MissilePool_Add(&Missiles);
+		if (new_missile >= 0) {
+			// set the missile points(the missile will be reused)
+			Point points[MISSILE_CORNER_COUNT] = {
+				{ 0, 0 },
+				{ 0, MISSILE_HEIGHT },
+				{ MISSILE_WIDTH, MISSILE_HEIGHT },
+				{ MISSILE_WIDTH, 0 },
+			};
+
+			// rotate the missile so it's in the same direction as the ship and
+			// put it at the tip of the ship
+			Point missile_center = {0};
+			missile_center.x = MISSILE_WIDTH / 2.0f;
+			missile_center.y = MISSILE_HEIGHT / 2.0f;
+			Transform2D transform = MakeTransform(ShipRotationRadians, missile_center, ship_triangle.b.x, ship_triangle.b.y);
+			TransformPoints(&transform, points, MISSILE_CORNER_COUNT);
+
+			// nothing to interpolate from on the step the missile is fired
+			for (i32 k = 0; k < MISSILE_CORNER_COUNT; k++) {
+				Missiles.x[k][new_missile] = points[k].x;
+				Missiles.y[k][new_missile] = points[k].y;
+				Missiles.previous_x[k][new_missile] = points[k].x;
+				Missiles.previous_y[k][new_missile] = points[k].y;
+			}
+			Missiles.dx[new_missile] = ship_forward_direction.x;
+			Missiles.dy[new_missile] = ship_forward_direction.y;
+			Missiles.rotation[new_missile] = ShipRotationRadians;
+		}
+
+		gShootMissile = 0;
+	}
+
+	END_TIMED_BLOCK(MissileUpdate);
+
+	if (PlayerDead) {
+		TimeSincePlayerDied += delta_time;
+		TimeSinceLastDrawShipFlagFlipped += delta_time;
+	
+		if (TimeSincePlayerDied >= 3.0f) {
+			PlayerDead = 0;
+			Flag_DrawShip = 1;
+			TimeSincePlayerDied = 0.0f;
+			TimeSinceLastDrawShipFlagFlipped = 0.0f;
+		} else if (TimeSinceLastDrawShipFlagFlipped >= 0.3f) {
+			Flag_DrawShip = !Flag_DrawShip;
+			TimeSinceLastDrawShipFlagFlipped = 0.0f;
+		}
+	}
 
-	///////////////////////////////////////////////
-	/// Apply Translation
-	///
-	ShipVelocity.x *= .9965f;
-	ShipVelocity.y *= .9965f;
+	BEGIN_TIMED_BLOCK(MeteorUpdate);
+	MeteorPool_Integrate(&Meteors, delta_time, width, height);
+	END_TIMED_BLOCK(MeteorUpdate);
+
+	if (gMeteorsBounce) {
+		BEGIN_TIMED_BLOCK(MeteorBounce);
+		MeteorPool_Bounce(&Meteors);
+		END_TIMED_BLOCK(MeteorBounce);
+	}
+	
+	BEGIN_TIMED_BLOCK(Collision);
+
+	MeteorGrid_Build(&Meteors.grid, &Meteors);
+
+	// Collision detection between ship and meteor
+	if (!PlayerDead) {
+		Extents ship_extents = CalculateExtents(ship_points, 3);
+		i32 candidate_count = MeteorGrid_Gather(&Meteors.grid, (f32)ship_extents.min_x, (f32)ship_extents.min_y,
+			(f32)ship_extents.max_x, (f32)ship_extents.max_y);
+		MeteorGrid *grid = &Meteors.grid;
+		for (i32 c = 0; c < candidate_count; c++) {
+			i32 meteor = grid->candidates[c];
+			grid->candidate_x[c] = Meteors.x[meteor];
+			grid->candidate_y[c] = Meteors.y[meteor];
+			grid->candidate_radius[c] = Meteors.radius[meteor];
+		}
+		if (TriangleTouchesCircles(&ship_triangle, grid->candidate_x, grid->candidate_y, grid->candidate_radius,
+			candidate_count, grid->candidate_hits)) {
+			// one life a step, however many meteors the ship is in
+			PlayerDead = 1;
+			PlayerLives -= 1;
+			if (PlayerLives <= 0) {
+				GameOver = 1;
+			}
+		}
+	}
+	
+	// Every missile hits the meteor it reaches first along its last step,
+	// and the hits are taken in the order they happen. A missile whose meteor
+	// was taken by an earlier hit goes on to the next one it reaches.
+	memset(Meteors.struck, 0, Meteors.count);
+	memset(Missiles.spent, 0, Missiles.count);
+	MissileHit *hits = Missiles.hits;
+	i32 hit_count = 0;
+	for (i32 missile = 0; missile < Missiles.count; missile++) {
+		if (MissilePool_FindHit(&Missiles, missile, &Meteors, hits + hit_count)) {
+			hit_count += 1;
+		}
+	}
+	qsort(hits, (size_t)hit_count, sizeof(MissileHit), MissileHit_Compare);
+	for (i32 h = 0; h < hit_count; h++) {
+		MissileHit *hit = hits + h;
+		if (Meteors.struck[hit->meteor]) {
+			if (!MissilePool_FindHit(&Missiles, hit->missile, &Meteors, hit)) {
+				hit->meteor = -1;
+				continue;
+			}
+			// no earlier than the hit it replaces, so it can only move back
+			MissileHit moved = *hit;
+			i32 to = h;
+			for (; ((to + 1) < hit_count) && MissileHit_Less(hits + to + 1, &moved); to++) {
+				hits[to] = hits[to + 1];
+			}
+			hits[to] = moved;
+			h -= 1;
+			continue;
+		}
+		Meteors.struck[hit->meteor] = 1;
+		Missiles.spent[hit->missile] = 1;
+		hit->position.x = Meteors.x[hit->meteor];
+		hit->position.y = Meteors.y[hit->meteor];
+		hit->radius = (i32)Meteors.radius[hit->meteor];
+		hit->speed = (i32)Meteors.speed[hit->meteor];
+	}
+
+	// NOTE: Backwards, so whatever moves into a removed one's place has
+	//       already been looked at.
+	if (hit_count) {
+		for (i32 meteor = Meteors.count - 1; meteor >= 0; meteor--) {
+			if (Meteors.struck[meteor]) {
+				MeteorPool_Remove(&Meteors, meteor);
+			}
+		}
+		for (i32 missile = Missiles.count - 1; missile >= 0; missile--) {
+			if (Missiles.spent[missile]) {
+				MissilePool_Remove(&Missiles, missile);
+			}
+		}
+	}
+	for (i32 h = 0; h < hit_count; h++) {
+		MissileHit *hit = hits + h;
+		if (hit->meteor < 0) {
+			continue;
+		}
+		Score += 1;
+		if (hit->radius >= 35) {
+			i32 radius = GenerateRandomNumber(15, 29);
+			SpawnMeteor(hit->position, radius, hit->speed);
+			radius = GenerateRandomNumber(15, 29);
+			SpawnMeteor(hit->position, radius, hit->speed);
+		}
+	}
+
+	i32 active_meteor_count = Meteors.count;
+
+	END_TIMED_BLOCK(Collision);
+
+	if (active_meteor_count == 0) {
+		Platform_Quit("You won! You destoryed all the meteors!");
+		return;
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////////////////
+/// Sprites
+///
+/// The ship, the missiles and the meteors are rasterized once at startup
+/// into an atlas of one byte masks: the rotating sprites at
+/// SPRITE_ROTATION_STEPS angles, the meteors at every radius. A frame
+/// then draws each of them as a masked blit of the frame nearest to its
+/// rotation, which costs the same however complicated the shape is.
+///
+/// Sprites land on whole pixels, so an entity is up to half a pixel and
+/// half a rotation step off where the geometry would have drawn it.
+
+#define SPRITE_ROTATION_STEPS 256
+#define SPRITE_METEOR_RADIUS_COUNT 64 // meteors of radius 0 to 63
+#define SPRITE_SCRATCH_SIZE 256 // frames are rasterized around the middle of a scratch surface
+
+typedef enum {
+	Sprite_Ship,
+	Sprite_ShipFilled,
+	Sprite_Missile,
+	Sprite_Meteor,
+
+	Sprite_Count,
+} SpriteId;
+
+typedef struct {
+	u32 offset; // into SpriteAtlas.masks, rows of width bytes
+	i16 width;
+	i16 height;
+	i16 origin_x; // the pixel of the mask that goes on the sprite's position
+	i16 origin_y;
+} SpriteFrame;
+
+typedef struct {
+	i32 first_frame[Sprite_Count];
+	i32 frame_count[Sprite_Count];
+	SpriteFrame *frames;
+	u8 *masks; // 0xFF where the sprite is, 0 where it's see through
+	u64 mask_size;
+} SpriteAtlas;
+
+// read only once built, so any number of threads can draw from it
+static SpriteAtlas gSprites;
+static b8 gDrawSprites = true;
+
+static void Sprites_RasterizeFrame(DrawSurface *scratch, SpriteId sprite, i32 frame) {
+	memset(scratch->pixels, 0, (u64)scratch->width * scratch->height * sizeof(u32));
+	f32 middle = (f32)(SPRITE_SCRATCH_SIZE / 2);
+	f32 rotation = ((f32)frame * 2.0f * PI) / SPRITE_ROTATION_STEPS;
+	switch (sprite) {
+	case Sprite_Ship:
+	case Sprite_ShipFilled: {
+		// the ship's position is the corner of its unrotated triangle
+		Triangle ship_triangle = MakeShipTriangle(rotation, middle, middle);
+		if (sprite == Sprite_ShipFilled) {
+			DrawConvexPolygon(scratch, (Point*)&ship_triangle, 3, 0xFFFFFFFF);
+		} else {
+			DrawPolyline(scratch, (Point*)&ship_triangle, 3, 1, 0xFFFFFFFF);
+		}
+	} break;
+	case Sprite_Missile: {
+		// the missile's position is its center
+		Point points[4] = {
+			{ -MISSILE_WIDTH / 2.0f, -MISSILE_HEIGHT / 2.0f },
+			{ -MISSILE_WIDTH / 2.0f, MISSILE_HEIGHT / 2.0f },
+			{ MISSILE_WIDTH / 2.0f, MISSILE_HEIGHT / 2.0f },
+			{ MISSILE_WIDTH / 2.0f, -MISSILE_HEIGHT / 2.0f },
+		};
+		Point center = {0};
+		Transform2D transform = MakeTransform(rotation, center, middle, middle);
+		TransformPoints(&transform, points, 4);
+		DrawConvexPolygon(scratch, points, 4, 0xFFFFFFFF);
+	} break;
+	case Sprite_Meteor: {
+		// frame is the radius
+		DrawCircle(scratch, frame, middle, middle, 0xFFFFFFFF);
+	} break;
+	default: break;
+	}
+}
+
+// Builds gSprites
+// RETURNS: 0 if it ran out of memory, entities are then drawn without sprites
+b8 Sprites_Init(void) {
+	SpriteAtlas *atlas = &gSprites;
+	i32 frame_count = 0;
+	for (i32 sprite = 0; sprite < Sprite_Count; sprite++) {
+		atlas->first_frame[sprite] = frame_count;
+		atlas->frame_count[sprite] = sprite == Sprite_Meteor ? SPRITE_METEOR_RADIUS_COUNT : SPRITE_ROTATION_STEPS;
+		frame_count += atlas->frame_count[sprite];
+	}
+
+	u32 *scratch_pixels = (u32*)MyAlloc((u64)SPRITE_SCRATCH_SIZE * SPRITE_SCRATCH_SIZE * sizeof(u32));
+	atlas->frames = (SpriteFrame*)MyAlloc((u64)frame_count * sizeof(SpriteFrame));
+	if (!scratch_pixels || !atlas->frames) {
+		return 0;
+	}
+	DrawSurface scratch = MakeDrawSurface(scratch_pixels, SPRITE_SCRATCH_SIZE, SPRITE_SCRATCH_SIZE);
+
+	// NOTE: Rasterize everything twice, first to find the tight bounds of
+	//       every frame and size the atlas, then to copy the masks in.
+	for (i32 pass = 0; pass < 2; pass++) {
+		u64 mask_size = 0;
+		for (i32 sprite = 0; sprite < Sprite_Count; sprite++) {
+			for (i32 i = 0; i < atlas->frame_count[sprite]; i++) {
+				SpriteFrame *frame = atlas->frames + atlas->first_frame[sprite] + i;
+				Sprites_RasterizeFrame(&scratch, (SpriteId)sprite, i);
+
+				if (pass == 0) {
+					i32 min_x = SPRITE_SCRATCH_SIZE;
+					i32 min_y = SPRITE_SCRATCH_SIZE;
+					i32 max_x = -1;
+					i32 max_y = -1;
+					for (i32 y = 0; y < SPRITE_SCRATCH_SIZE; y++) {
+						for (i32 x = 0; x < SPRITE_SCRATCH_SIZE; x++) {
+							if (scratch_pixels[x + (y * SPRITE_SCRATCH_SIZE)]) {
+								min_x = min_i32(min_x, x);
+								min_y = min_i32(min_y, y);
+								max_x = max_i32(max_x, x);
+								max_y = max_i32(max_y, y);
+							}
+						}
+					}
+					if (max_x < 0) {
+						// nothing to draw
+						min_x = min_y = 0;
+						max_x = max_y = -1;
+					}
+					frame->width = (i16)(max_x - min_x + 1);
+					frame->height = (i16)(max_y - min_y + 1);
+					frame->origin_x = (i16)((SPRITE_SCRATCH_SIZE / 2) - min_x);
+					frame->origin_y = (i16)((SPRITE_SCRATCH_SIZE / 2) - min_y);
+					frame->offset = (u32)mask_size;
+				} else {
+					u8 *mask = atlas->masks + frame->offset;
+					i32 min_x = (SPRITE_SCRATCH_SIZE / 2) - frame->origin_x;
+					i32 min_y = (SPRITE_SCRATCH_SIZE / 2) - frame->origin_y;
+					for (i32 y = 0; y < frame->height; y++) {
+						u32 *row = scratch_pixels + min_x + ((min_y + y) * SPRITE_SCRATCH_SIZE);
+						for (i32 x = 0; x < frame->width; x++) {
+							*mask++ = row[x] ? 0xFF : 0;
+						}
+					}
+				}
+				mask_size += (u64)frame->width * frame->height;
+			}
+		}
+
+		if (pass == 0) {
+			atlas->mask_size = mask_size;
+			atlas->masks = (u8*)MyAlloc(mask_size);
+			if (!atlas->masks) {
+				MyFree(scratch_pixels);
+				MyFree(atlas->frames);
+				atlas->frames = 0;
+				return 0;
+			}
+		}
+	}
+
+	MyFree(scratch_pixels);
+	return 1;
+}
+
+// RETURNS: the frame of a rotating sprite nearest to rotation_radians
+i32 SpriteRotationFrame(f32 rotation_radians) {
+	i32 step = RoundNearest(rotation_radians * (SPRITE_ROTATION_STEPS / (2.0f * PI)));
+	// two's complement wraps negative rotations around too
+	return step & (SPRITE_ROTATION_STEPS - 1);
+}
+
+// Writes color everywhere the frame's mask is set, with the frame's origin on (x, y)
+void DrawSprite(DrawSurface *surface, SpriteFrame *frame, i32 x, i32 y, u32 color) {
+	i32 left = x - frame->origin_x;
+	i32 top = y - frame->origin_y;
+	i32 min_x = max_i32(left, surface->clip_min_x);
+	i32 min_y = max_i32(top, surface->clip_min_y);
+	i32 max_x = min_i32(left + frame->width, surface->clip_max_x);
+	i32 max_y = min_i32(top + frame->height, surface->clip_max_y);
+	if (min_x >= max_x || min_y >= max_y) {
+		return;
+	}
+
+	// NOTE: 16 mask bytes are tested at a time, so the empty insides of
+	//       outlines cost next to nothing. Set bytes are widened 4 at a time
+	//       to lanes that pick between the color and what's already there.
+	__m128i colors = _mm_set1_epi32((i32)color);
+	i32 span_width = max_x - min_x;
+	for (i32 row_y = min_y; row_y < max_y; row_y++) {
+		u8 *mask = gSprites.masks + frame->offset + (min_x - left) + ((row_y - top) * frame->width);
+		u32 *row = surface->pixels + min_x + ((i64)row_y * surface->width);
+		i32 i = 0;
+		for (; i + 16 <= span_width; i += 16) {
+			__m128i mask_bytes = _mm_loadu_si128((__m128i*)(mask + i));
+			if (_mm_testz_si128(mask_bytes, mask_bytes)) {
+				continue;
+			}
+			for (i32 quarter = 0; quarter < 4; quarter++) {
+				__m128i lanes = _mm_cvtepi8_epi32(mask_bytes);
+				__m128i pixels = _mm_loadu_si128((__m128i*)(row + i + (quarter * 4)));
+				_mm_storeu_si128((__m128i*)(row + i + (quarter * 4)), _mm_blendv_epi8(pixels, colors, lanes));
+				mask_bytes = _mm_srli_si128(mask_bytes, 4);
+			}
+		}
+		for (; i + 4 <= span_width; i += 4) {
+			u32 mask_bytes;
+			memcpy(&mask_bytes, mask + i, sizeof(mask_bytes));
+			if (mask_bytes == 0) {
+				continue;
+			}
+			__m128i lanes = _mm_cvtepi8_epi32(_mm_cvtsi32_si128((i32)mask_bytes));
+			__m128i pixels = _mm_loadu_si128((__m128i*)(row + i));
+			_mm_storeu_si128((__m128i*)(row + i), _mm_blendv_epi8(pixels, colors, lanes));
+		}
+		for (; i < span_width; i++) {
+			if (mask[i]) {
+				row[i] = color;
+			}
+		}
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////////////////
+/// Render Commands
+///
+/// The game doesn't draw, it describes the frame as a list of draw commands
+/// built from the game state after the simulation steps. A backend turns the
+/// list into pixels later, on whichever thread it likes:
+/// ExecuteRenderCommands draws the commands in order, ExecuteRenderCommandsTiled
+/// bins them into tiles and draws the tiles in parallel.
+///
+/// Every command carries the bounding box of the pixels it can write.
+/// Commands that are entirely off the surface are never recorded, and
+/// backends skip the ones that miss their clip rectangle without looking at
+/// them. The buffer is also the snapshot the simulation hands to the renderer,
+/// so the renderer never touches the live game state and the simulation of
+/// the next frame can run while this one is being drawn and presented.
+
+// Room for everything that isn't the ship, a missile or a meteor: the
+// background, the HUD, the pause menu and the profile overlay. The entities
+// get their room on top, from the pool capacities.
+#define RENDER_COMMAND_HUD_CAPACITY 512
+#define RENDER_COMMAND_TEXT_CAPACITY 2048
+#define RENDER_COMMAND_HUD_POINT_CAPACITY 1024
+
+typedef enum {
+	RenderCommand_Clear, // fills an axis aligned rectangle
+	RenderCommand_Line,
+	RenderCommand_Polyline,
+	RenderCommand_Circle, // outline
+	RenderCommand_Disc, // filled circle
+	RenderCommand_Polygon, // filled convex polygon
+	RenderCommand_Text,
+	RenderCommand_Sprite, // a frame of gSprites
+} RenderCommandType;
+
+typedef struct {
+	u8 type; // RenderCommandType
+	u8 timed_block; // the TimedBlock its raster time counts towards
+	u32 color;
+	// every pixel the command can write is inside [min_x, max_x] x [min_y, max_y]
+	i32 min_x, min_y, max_x, max_y;
+	union {
+		struct { i32 x, y, width, height; } clear;
+		struct { Point p1, p2; } line;
+		struct { i32 offset, count; b8 closed; } polyline; // offset into RenderCommandBuffer.points
+		struct { f32 x, y; i32 radius; } circle; // also the disc
+		struct { i32 offset, count; } polygon; // offset into RenderCommandBuffer.points, in order around it
+		struct { i32 x, y, offset, length; } text; // offset into RenderCommandBuffer.text
+		struct { i32 x, y, frame; } sprite; // frame indexes gSprites.frames
+	} params;
+} RenderCommand;
+
+typedef struct {
+	i32 width; // of the surface the commands were built for
+	i32 height;
+	i32 command_count;
+	i32 text_length;
+	i32 point_count;
+	i32 command_capacity;
+	i32 text_capacity;
+	i32 point_capacity;
+	RenderCommand *commands;
+	char *text;
+	Point *points;
+} RenderCommandBuffer;
+
+// Lays the buffer's arrays out from memory onwards, like the pools. Every
+// ship, missile and meteor gets a command and its points on top of the HUD
+// room, so a full pool can't push the HUD out of the frame. With memory 0 it
+// only works out the size.
+// RETURNS: the number of bytes the arrays take
+u64 RenderCommandBuffer_Place(RenderCommandBuffer *buffer, i32 meteor_capacity, i32 missile_capacity, u8 *memory) {
+	memset(buffer, 0, sizeof(*buffer));
+	buffer->command_capacity = 1 + missile_capacity + meteor_capacity + RENDER_COMMAND_HUD_CAPACITY;
+	buffer->text_capacity = RENDER_COMMAND_TEXT_CAPACITY;
+	buffer->point_capacity = 3 + (missile_capacity * MISSILE_CORNER_COUNT) + RENDER_COMMAND_HUD_POINT_CAPACITY;
+	u8 *at = memory;
+	buffer->commands = (RenderCommand*)Pool_TakeArray(&at, buffer->command_capacity, sizeof(RenderCommand));
+	buffer->text = (char*)Pool_TakeArray(&at, buffer->text_capacity, sizeof(char));
+	buffer->points = (Point*)Pool_TakeArray(&at, buffer->point_capacity, sizeof(Point));
+	return (u64)(at - memory);
+}
+
+// NOTE: The platform registers every command buffer it builds frames into
+//       before the first frame, and the game places their arrays in the same
+//       reservation as the pools.
+#define RENDER_COMMAND_BUFFER_MAX 4
+static RenderCommandBuffer *gRenderCommandBuffers[RENDER_COMMAND_BUFFER_MAX];
+static i32 gRenderCommandBufferCount = 0;
+
+// RETURNS: 0 if there are too many buffers, or the game has already started
+b8 RenderCommandBuffer_Register(RenderCommandBuffer *buffer) {
+	if (GameMemory || gRenderCommandBufferCount == RENDER_COMMAND_BUFFER_MAX) {
+		return 0;
+	}
+	gRenderCommandBuffers[gRenderCommandBufferCount++] = buffer;
+	return 1;
+}
+
+// Makes the pools and the arrays of every registered command buffer out of
+// one allocation. It is the only one the game makes.
+// RETURNS: the allocation, or 0 if it failed
+static void *GameMemory_Create(void) {
+	RenderCommandBuffer measure;
+	u64 meteor_size = MeteorPool_Place(&Meteors, gMeteorCapacity, 0);
+	u64 missile_size = MissilePool_Place(&Missiles, gMissileCapacity, 0);
+	u64 buffer_size = RenderCommandBuffer_Place(&measure, gMeteorCapacity, gMissileCapacity, 0);
+	// MyAlloc only promises 16 byte alignment
+	u8 *memory = (u8*)MyAlloc(meteor_size + missile_size + (buffer_size * gRenderCommandBufferCount) +
+		POOL_ARRAY_ALIGNMENT);
+	if (!memory) {
+		memset(&Meteors, 0, sizeof(Meteors));
+		memset(&Missiles, 0, sizeof(Missiles));
+		return 0;
+	}
+	u8 *at = (u8*)(((size_t)memory + (POOL_ARRAY_ALIGNMENT - 1)) & ~(size_t)(POOL_ARRAY_ALIGNMENT - 1));
+	at += MeteorPool_Place(&Meteors, gMeteorCapacity, at);
+	at += MissilePool_Place(&Missiles, gMissileCapacity, at);
+	for (i32 i = 0; i < gRenderCommandBufferCount; i++) {
+		at += RenderCommandBuffer_Place(gRenderCommandBuffers[i], gMeteorCapacity, gMissileCapacity, at);
+	}
+	return memory;
+}
+
+// RETURNS: the command to fill in, 0 if it is entirely off the surface and
+//          doesn't need to be recorded, or the buffer is full
+static RenderCommand *PushRenderCommand(RenderCommandBuffer *buffer, RenderCommandType type, TimedBlock timed_block,
+	u32 color, i32 min_x, i32 min_y, i32 max_x, i32 max_y) {
+	if (max_x < 0 || min_x >= buffer->width || max_y < 0 || min_y >= buffer->height) {
+		return 0;
+	}
+	if (buffer->command_count == buffer->command_capacity) {
+		// drop the rest of the frame rather than overflow
+		return 0;
+	}
+
+	RenderCommand *command = buffer->commands + buffer->command_count++;
+	command->type = (u8)type;
+	command->timed_block = (u8)timed_block;
+	command->color = color;
+	command->min_x = min_x;
+	command->min_y = min_y;
+	command->max_x = max_x;
+	command->max_y = max_y;
+	return command;
+}
+
+void PushClear(RenderCommandBuffer *buffer, i32 x, i32 y, i32 width, i32 height, u32 color, TimedBlock timed_block) {
+	if (width <= 0 || height <= 0) {
+		return;
+	}
+	RenderCommand *command = PushRenderCommand(buffer, RenderCommand_Clear, timed_block, color,
+		x, y, x + width - 1, y + height - 1);
+	if (command) {
+		command->params.clear.x = x;
+		command->params.clear.y = y;
+		command->params.clear.width = width;
+		command->params.clear.height = height;
+	}
+}
+
+void PushLine(RenderCommandBuffer *buffer, Point p1, Point p2, u32 color, TimedBlock timed_block) {
+	// DrawLine only draws between the pixels nearest to the end points
+	i32 x1 = RoundNearest(p1.x);
+	i32 y1 = RoundNearest(p1.y);
+	i32 x2 = RoundNearest(p2.x);
+	i32 y2 = RoundNearest(p2.y);
+	RenderCommand *command = PushRenderCommand(buffer, RenderCommand_Line, timed_block, color,
+		min_i32(x1, x2), min_i32(y1, y2), max_i32(x1, x2), max_i32(y1, y2));
+	if (command) {
+		command->params.line.p1 = p1;
+		command->params.line.p2 = p2;
+	}
+}
+
+void PushPolyline(RenderCommandBuffer *buffer, Point *points, i32 point_count, b8 closed, u32 color,
+	TimedBlock timed_block) {
+	if (point_count <= 0 || buffer->point_count + point_count > buffer->point_capacity) {
+		return;
+	}
+
+	i32 min_x = RoundNearest(points[0].x);
+	i32 min_y = RoundNearest(points[0].y);
+	i32 max_x = min_x;
+	i32 max_y = min_y;
+	for (i32 i = 1; i < point_count; i++) {
+		i32 x = RoundNearest(points[i].x);
+		i32 y = RoundNearest(points[i].y);
+		min_x = min_i32(min_x, x);
+		min_y = min_i32(min_y, y);
+		max_x = max_i32(max_x, x);
+		max_y = max_i32(max_y, y);
+	}
+	RenderCommand *command = PushRenderCommand(buffer, RenderCommand_Polyline, timed_block, color,
+		min_x, min_y, max_x, max_y);
+	if (command) {
+		memcpy(buffer->points + buffer->point_count, points, point_count * sizeof(Point));
+		command->params.polyline.offset = buffer->point_count;
+		command->params.polyline.count = point_count;
+		command->params.polyline.closed = closed;
+		buffer->point_count += point_count;
+	}
+}
+
+static void PushCircleCommand(RenderCommandBuffer *buffer, RenderCommandType type, f32 x, f32 y, i32 radius, u32 color,
+	TimedBlock timed_block) {
+	if (radius < 0) {
+		return;
+	}
+	// circles are drawn around the pixel nearest to the center
+	i32 center_x = RoundNearest(x);
+	i32 center_y = RoundNearest(y);
+	RenderCommand *command = PushRenderCommand(buffer, type, timed_block, color,
+		center_x - radius, center_y - radius, center_x + radius, center_y + radius);
+	if (command) {
+		command->params.circle.x = x;
+		command->params.circle.y = y;
+		command->params.circle.radius = radius;
+	}
+}
+
+void PushCircle(RenderCommandBuffer *buffer, f32 x, f32 y, i32 radius, u32 color, TimedBlock timed_block) {
+	PushCircleCommand(buffer, RenderCommand_Circle, x, y, radius, color, timed_block);
+}
+
+void PushDisc(RenderCommandBuffer *buffer, f32 x, f32 y, i32 radius, u32 color, TimedBlock timed_block) {
+	PushCircleCommand(buffer, RenderCommand_Disc, x, y, radius, color, timed_block);
+}
+
+void PushConvexPolygon(RenderCommandBuffer *buffer, Point *points, i32 point_count, u32 color, TimedBlock timed_block) {
+	if (point_count < 3 || buffer->point_count + point_count > buffer->point_capacity) {
+		return;
+	}
+	// DrawConvexPolygon fills pixels whose coordinates are inside the polygon
+	Extents e = CalculateExtents(points, point_count);
+	RenderCommand *command = PushRenderCommand(buffer, RenderCommand_Polygon, timed_block, color,
+		e.min_x, e.min_y, e.max_x, e.max_y);
+	if (command) {
+		memcpy(buffer->points + buffer->point_count, points, point_count * sizeof(Point));
+		command->params.polygon.offset = buffer->point_count;
+		command->params.polygon.count = point_count;
+		buffer->point_count += point_count;
+	}
+}
+
+// frame is relative to the sprite's first frame, the sprite's origin goes
+// on the pixel nearest to (x, y)
+void PushSprite(RenderCommandBuffer *buffer, SpriteId sprite, i32 frame, f32 x, f32 y, u32 color,
+	TimedBlock timed_block) {
+	i32 frame_index = gSprites.first_frame[sprite] + frame;
+	SpriteFrame *sprite_frame = gSprites.frames + frame_index;
+	if (sprite_frame->width <= 0) {
+		return;
+	}
+	i32 at_x = RoundNearest(x);
+	i32 at_y = RoundNearest(y);
+	i32 left = at_x - sprite_frame->origin_x;
+	i32 top = at_y - sprite_frame->origin_y;
+	RenderCommand *command = PushRenderCommand(buffer, RenderCommand_Sprite, timed_block, color,
+		left, top, left + sprite_frame->width - 1, top + sprite_frame->height - 1);
+	if (command) {
+		command->params.sprite.x = at_x;
+		command->params.sprite.y = at_y;
+		command->params.sprite.frame = frame_index;
+	}
+}
+
+// RETURNS: how far DrawTextRun moves x for the text
+i32 TextAdvance(char *text, i32 text_length) {
+	i32 advance = 0;
+	for (i32 i = 0; i < text_length; i++) {
+		// characters that aren't in the atlas are skipped without moving on
+		if (text[i] == ' ' || KDTF_GetXOffsetForGlyph(&gFont.atlas, text[i]) != -1) {
+			advance += gFont.atlas.glyph_width;
+		}
+	}
+	return advance;
+}
+
+// Advances x past the text
+void PushTextRun(RenderCommandBuffer *buffer, char *text, i32 text_length, u32 color, i32 *x, i32 y,
+	TimedBlock timed_block) {
+	i32 advance = TextAdvance(text, text_length);
+	i32 at_x = *x;
+	*x += advance;
+	if (advance == 0 || buffer->text_length + text_length > buffer->text_capacity) {
+		return;
+	}
+
+	// glyphs cover rows [y, y + glyph_height), or [y + 1, y + glyph_height] when flipped
+	RenderCommand *command = PushRenderCommand(buffer, RenderCommand_Text, timed_block, color,
+		at_x, y, at_x + advance - 1, y + gFont.atlas.glyph_height);
+	if (command) {
+		memcpy(buffer->text + buffer->text_length, text, text_length);
+		command->params.text.x = at_x;
+		command->params.text.y = y;
+		command->params.text.offset = buffer->text_length;
+		command->params.text.length = text_length;
+		buffer->text_length += text_length;
+	}
+}
+
+void PushString(RenderCommandBuffer *buffer, char *text, i32 x, i32 y, TimedBlock timed_block) {
+	PushTextRun(buffer, text, (i32)strlen(text), 0xFFFFFFFF, &x, y, timed_block);
+}
+
+// Advances x past the number
+void PushNumber(RenderCommandBuffer *buffer, i32 number, u32 color, i32 *x, i32 y, TimedBlock timed_block) {
+	if (number < 0) {
+		// KDTF_DrawNumber draws nothing for negative numbers, and the lives
+		// counter goes below zero on the frame the game ends
+		return;
+	}
+	char digits[16] = {0};
+	i32 digit_count = snprintf(digits, sizeof(digits), "%d", number);
+	PushTextRun(buffer, digits, digit_count, color, x, y, timed_block);
+}
+
+void PushMenuButton(RenderCommandBuffer *buffer, char *text, i32 at_x, i32 at_y, i32 mouse_x, i32 mouse_y) {
+	u32 TextColor = 0xFFFFFFFF;
+	if (MouseOverMenuButton(text, at_x, at_y, mouse_x, mouse_y)) {
+		TextColor = 0xFF3D3D3D;
+	}
+	PushTextRun(buffer, text, (i32)strlen(text), TextColor, &at_x, at_y, TimedBlock_HudText);
+}
+
+// The per-phase breakdown followed by a graph of the recent frame times with
+// a line at 60fps
+void PushProfileOverlay(RenderCommandBuffer *buffer, ProfileOverlay *overlay) {
+	if (overlay->frame_count == 0) {
+		return;
+	}
+
+	i32 overlay_width = gFont.atlas.glyph_width * PROFILE_OVERLAY_LINE_CHARACTERS;
+	i32 overlay_height = (gFont.line_height * (TimedBlock_Count + 1)) + PROFILE_OVERLAY_GRAPH_HEIGHT;
+	if (buffer->width < overlay_width + (2 * PROFILE_OVERLAY_MARGIN) ||
+		buffer->height < overlay_height + (2 * PROFILE_OVERLAY_MARGIN)) {
+		// doesn't fit, don't draw it at all rather than cut it off
+		return;
+	}
+
+	f32 max_frame_seconds = overlay->max_frame_seconds;
+
+	i32 x = buffer->width - overlay_width - PROFILE_OVERLAY_MARGIN;
+	i32 y = PROFILE_OVERLAY_MARGIN;
+
+	for (i32 line = 0; line < TimedBlock_Count + 1; line++) {
+		PushString(buffer, overlay->lines[line], x, y, TimedBlock_HudText);
+		NewLine(&y);
+	}
+
+	// oldest frame on the left, newest on the right
+	i32 graph_bottom = y + PROFILE_OVERLAY_GRAPH_HEIGHT;
+	i32 bar_width = Max2(overlay_width / PROFILE_FRAME_COUNT, 1);
+	for (i32 i = 0; i < overlay->frame_count; i++) {
+		f32 frame_seconds = overlay->frame_seconds[i];
+		i32 bar_height = (i32)((frame_seconds / max_frame_seconds) * PROFILE_OVERLAY_GRAPH_HEIGHT);
+		bar_height = Max2(Min2(bar_height, PROFILE_OVERLAY_GRAPH_HEIGHT), 1);
+		i32 bar_x = x + overlay_width - ((i + 1) * bar_width);
+		if (bar_x < x) {
+			break;
+		}
+		u32 color = frame_seconds > (1.0f / 60.0f) ? 0xFFFF553B : 0xFF38AFFF;
+		PushClear(buffer, bar_x, graph_bottom - bar_height, bar_width, bar_height, color, TimedBlock_HudText);
+	}
+
+	i32 target_y = graph_bottom - (i32)(((1.0f / 60.0f) / max_frame_seconds) * PROFILE_OVERLAY_GRAPH_HEIGHT);
+	PushClear(buffer, x, target_y, overlay_width, 1, 0xFFFFFFFF, TimedBlock_HudText);
+}
+
+// Blends the previous and current step. A jump of more than half the
+// screen is the entity wrapping around, which is drawn where it ended up.
+f32 InterpolateWrapped(f32 previous, f32 current, f32 alpha, f32 screen_size) {
+	f32 delta = current - previous;
+	if (delta > screen_size * 0.5f || delta < screen_size * -0.5f) {
+		return current;
+	}
+	return previous + (delta * alpha);
+}
+
+// Records the frame for a width x height surface, drawn alpha of the way
+// from the previous simulation step to the last one
+void BuildRenderCommands(RenderCommandBuffer *buffer, f32 alpha, i32 width, i32 height) {
+	BEGIN_TIMED_BLOCK(RenderCommands);
+	buffer->width = width;
+	buffer->height = height;
+	buffer->command_count = 0;
+	buffer->text_length = 0;
+	buffer->point_count = 0;
+
+	if (gPaused) {
+		PushClear(buffer, 0, 0, width, height, BACKGROUND_COLOR, TimedBlock_ClearBackground);
+		
+		PauseMenuLayout menu = CalculatePauseMenuLayout(width, height);
+		PushString(buffer, "ASTEROIDS!", menu.x, menu.title_y, TimedBlock_HudText);
+		PushMenuButton(buffer, "Restart", menu.x, menu.restart_y, MouseX, MouseY);
+		PushMenuButton(buffer, "Quit", menu.x, menu.quit_y, MouseX, MouseY);
+		END_TIMED_BLOCK(RenderCommands);
+		return;
+	}
+
+	PushClear(buffer, 0, 0, width, height, BACKGROUND_COLOR, TimedBlock_ClearBackground);
+	
+	if (Flag_DrawShip) {
+		f32 rotation = PreviousShipRotationRadians + ((ShipRotationRadians - PreviousShipRotationRadians) * alpha);
+		f32 ship_x = InterpolateWrapped(PreviousShipPosition.x, ShipPosition.x, alpha, (f32)width);
+		f32 ship_y = InterpolateWrapped(PreviousShipPosition.y, ShipPosition.y, alpha, (f32)height);
+
+		if (gDrawSprites && gSprites.masks) {
+			PushSprite(buffer, gFillShip ? Sprite_ShipFilled : Sprite_Ship, SpriteRotationFrame(rotation),
+				ship_x, ship_y, SHIP_COLOR, TimedBlock_ShipDraw);
+		} else {
+			Triangle ship_triangle = MakeShipTriangle(rotation, ship_x, ship_y);
+			if (gFillShip) {
+				PushConvexPolygon(buffer, (Point*)&ship_triangle, 3, SHIP_COLOR, TimedBlock_ShipDraw);
+			} else {
+				PushPolyline(buffer, (Point*)&ship_triangle, 3, 1, SHIP_COLOR, TimedBlock_ShipDraw);
+			}
+		}
+	}
+	
+	for (i32 missile = 0; missile < Missiles.count; missile++) {
+
+		// missiles are destroyed when they leave the screen, so they never wrap
+		Point points[MISSILE_CORNER_COUNT];
+		for (i32 k = 0; k < MISSILE_CORNER_COUNT; k++) {
+			f32 previous_x = Missiles.previous_x[k][missile];
+			f32 previous_y = Missiles.previous_y[k][missile];
+			points[k].x = previous_x + ((Missiles.x[k][missile] - previous_x) * alpha);
+			points[k].y = previous_y + ((Missiles.y[k][missile] - previous_y) * alpha);
+		}
+		if (gDrawSprites && gSprites.masks) {
+			f32 center_x = (points[0].x + points[1].x + points[2].x + points[3].x) * 0.25f;
+			f32 center_y = (points[0].y + points[1].y + points[2].y + points[3].y) * 0.25f;
+			PushSprite(buffer, Sprite_Missile, SpriteRotationFrame(Missiles.rotation[missile]), center_x, center_y,
+				0xFFFFFFFF, TimedBlock_MissileRaster);
+		} else {
+			PushConvexPolygon(buffer, points, 4, 0xFFFFFFFF, TimedBlock_MissileRaster);
+		}
+	}
+
+	for (i32 meteor = 0; meteor < Meteors.count; meteor++) {
+		f32 meteor_x = InterpolateWrapped(Meteors.previous_x[meteor], Meteors.x[meteor], alpha, (f32)width);
+		f32 meteor_y = InterpolateWrapped(Meteors.previous_y[meteor], Meteors.y[meteor], alpha, (f32)height);
+		i32 radius = (i32)Meteors.radius[meteor];
+		if (gDrawSprites && gSprites.masks && radius < SPRITE_METEOR_RADIUS_COUNT) {
+			PushSprite(buffer, Sprite_Meteor, radius, meteor_x, meteor_y, 0xFFFFFFFF, TimedBlock_MeteorDraw);
+		} else {
+			PushCircle(buffer, meteor_x, meteor_y, radius, 0xFFFFFFFF, TimedBlock_MeteorDraw);
+		}
+	}
+
+	if (GameOver) {
+		f32 relative_x = 0.5f;
+		i32 xPos = my_ceil((f32)width * relative_x);
+	
+		f32 relative_y = 0.5f;
+		i32 yPos = my_ceil((f32)height * relative_y);
+		
+		PushString(buffer, "GAME OVER", xPos, yPos, TimedBlock_HudText);
+	}
+	
+	f32 relative_x = 0.05f;
+	i32 xPos = my_ceil((f32)width * relative_x);
+
+	f32 relative_y = 0.05f;
+	i32 yPos = my_ceil((f32)height * relative_y);
+
+	char *score_text = "Score: ";
+	i32 score_text_length = (i32)strlen(score_text);
+	PushTextRun(buffer, score_text, score_text_length, 0xFFFFFFFF, &xPos, yPos, TimedBlock_HudText);
+	PushNumber(buffer, Score, 0xFFFFFFFF, &xPos, yPos, TimedBlock_HudText);
+
+	xPos = my_ceil((f32)width * relative_x);
+	NewLine(&yPos);
+	
+	char *lives_text = "Lives: ";
+	i32 lives_left_text_length = (i32)strlen(lives_text);
+	PushTextRun(buffer, lives_text, lives_left_text_length, 0xFFFFFFFF, &xPos, yPos, TimedBlock_HudText);
+	PushNumber(buffer, PlayerLives, 0xFFFFFFFF, &xPos, yPos, TimedBlock_HudText);
+
+	if (gShowProfileOverlay) {
+		ProfileOverlay overlay;
+		GatherProfileOverlay(&overlay);
+		PushProfileOverlay(buffer, &overlay);
+	}
+	END_TIMED_BLOCK(RenderCommands);
+}
+
+static void ExecuteRenderCommand(DrawSurface *surface, RenderCommandBuffer *buffer, RenderCommand *command) {
+	switch (command->type) {
+	case RenderCommand_Clear: {
+		DrawRectangle(surface, command->params.clear.x, command->params.clear.y,
+			command->params.clear.width, command->params.clear.height, command->color);
+	} break;
+	case RenderCommand_Line: {
+		DrawLine(surface, command->params.line.p1, command->params.line.p2, command->color);
+	} break;
+	case RenderCommand_Polyline: {
+		DrawPolyline(surface, buffer->points + command->params.polyline.offset, command->params.polyline.count,
+			command->params.polyline.closed, command->color);
+	} break;
+	case RenderCommand_Circle: {
+		DrawCircle(surface, command->params.circle.radius, command->params.circle.x, command->params.circle.y,
+			command->color);
+	} break;
+	case RenderCommand_Disc: {
+		DrawDisc(surface, command->params.circle.radius, command->params.circle.x, command->params.circle.y,
+			command->color);
+	} break;
+	case RenderCommand_Polygon: {
+		DrawConvexPolygon(surface, buffer->points + command->params.polygon.offset, command->params.polygon.count,
+			command->color);
+	} break;
+	case RenderCommand_Sprite: {
+		DrawSprite(surface, gSprites.frames + command->params.sprite.frame, command->params.sprite.x,
+			command->params.sprite.y, command->color);
+	} break;
+	case RenderCommand_Text: {
+		i32 x = command->params.text.x;
+		i32 y = command->params.text.y;
+		DrawTextRun(surface, buffer->text + command->params.text.offset, command->params.text.length,
+			command->color, &x, &y);
+	} break;
+	}
+}
+
+// Draws the commands at indices[0, count) in that order, or the first count
+// commands when indices is 0
+static void ExecuteRenderCommandList(DrawSurface *surface, RenderCommandBuffer *buffer, i32 *indices, i32 count) {
+#if PROFILE
+	// added up locally so tiles running in parallel don't fight over the counters
+	u64 block_cycles[TimedBlock_Count] = {0};
+#endif
+	for (i32 i = 0; i < count; i++) {
+		RenderCommand *command = buffer->commands + (indices ? indices[i] : i);
+		if (!OverlapsClip(surface, command->min_x, command->min_y, command->max_x, command->max_y)) {
+			continue;
+		}
+#if PROFILE
+		u64 begin_cycles = __rdtsc();
+#endif
+		ExecuteRenderCommand(surface, buffer, command);
+#if PROFILE
+		block_cycles[command->timed_block] += __rdtsc() - begin_cycles;
+#endif
+	}
+#if PROFILE
+	for (i32 block = 0; block < TimedBlock_Count; block++) {
+		if (block_cycles[block]) {
+			AtomicAddU64(&gProfile.current_block_cycles[block], block_cycles[block]);
+		}
+	}
+#endif
+}
+
+// Only reads the buffer, so it can run on another thread while the
+// simulation carries on with the next frame
+void ExecuteRenderCommands(DrawSurface *surface, RenderCommandBuffer *buffer) {
+	ExecuteRenderCommandList(surface, buffer, 0, buffer->command_count);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////
+/// Dirty Rectangles
+///
+/// Most of a frame is background. A DirtyTracker remembers which cells of a
+/// pixel buffer the last frame drawn into it touched with anything but the
+/// background clear, so the next frame into the same buffer only clears and
+/// redraws the cells touched by either frame. Every redrawn cell runs the
+/// whole command list clipped to it, starting with the background clear,
+/// so the result is identical to drawing the frame from scratch.
+///
+/// Use one tracker per pixel buffer: a double buffered target needs two,
+/// since the frame in the back buffer is two frames old.
+
+#define DIRTY_CELL_SIZE 32
+
+typedef struct {
+	i32 min_x, min_y, max_x, max_y; // max is exclusive
+} DirtyRect;
+
+typedef struct {
+	i32 width;
+	i32 height;
+	i32 cell_size;
+	i32 cells_x;
+	i32 cells_y;
+	b8 valid; // the buffer holds a complete frame the tracker saw being drawn
+	u32 background;
+	u8 *touched; // cells the frame in the buffer drew something other than background into
+	u8 *dirty; // cells the current frame redraws
+	i32 *dirty_cells; // indices of the dirty cells, row by row
+	i32 dirty_cell_count;
+
+	// the regions of the current frame, the only pixels that need uploading
+	DirtyRect *rects;
+	i32 rect_count;
+
+	u64 frames;
+	u64 pixels_redrawn;
+} DirtyTracker;
+
+void DirtyTracker_Free(DirtyTracker *tracker) {
+	if (tracker->touched) {
+		MyFree(tracker->touched);
+		MyFree(tracker->dirty);
+		MyFree(tracker->dirty_cells);
+		MyFree(tracker->rects);
+	}
+	tracker->touched = 0;
+	tracker->dirty = 0;
+	tracker->dirty_cells = 0;
+	tracker->rects = 0;
+	tracker->cells_x = 0;
+	tracker->cells_y = 0;
+	tracker->valid = 0;
+}
+
+static b8 DirtyTracker_Resize(DirtyTracker *tracker, i32 width, i32 height, i32 cell_size) {
+	if (tracker->touched && tracker->width == width && tracker->height == height && tracker->cell_size == cell_size) {
+		return 1;
+	}
+	DirtyTracker_Free(tracker);
+
+	i32 cells_x = (width + cell_size - 1) / cell_size;
+	i32 cells_y = (height + cell_size - 1) / cell_size;
+	u64 cell_count = (u64)cells_x * cells_y;
+	tracker->touched = (u8*)MyAlloc(cell_count);
+	tracker->dirty = (u8*)MyAlloc(cell_count);
+	tracker->dirty_cells = (i32*)MyAlloc(cell_count * sizeof(i32));
+	// every other cell in a row dirty is the most runs there can be
+	tracker->rects = (DirtyRect*)MyAlloc((u64)(((cells_x + 1) / 2) * cells_y) * sizeof(DirtyRect));
+	if (!tracker->touched || !tracker->dirty || !tracker->dirty_cells || !tracker->rects) {
+		DirtyTracker_Free(tracker);
+		return 0;
+	}
+	tracker->width = width;
+	tracker->height = height;
+	tracker->cell_size = cell_size;
+	tracker->cells_x = cells_x;
+	tracker->cells_y = cells_y;
+	return 1;
+}
 
-	if (!PlayerDead) {	
-		if (gMoveShipForward) {		
-			f32 acceleration = 3.0f; // u/s^2
-	
-			ShipVelocity.x += ship_forward_direction.x * (delta_time * acceleration);
-			ShipVelocity.y += ship_forward_direction.y * (delta_time * acceleration);
-		}
+// RETURNS: 1 if the buffer starts with a clear of the whole surface, which
+//          is what makes the untouched cells known to be background
+static b8 StartsWithBackgroundClear(DrawSurface *surface, RenderCommandBuffer *buffer) {
+	if (buffer->command_count == 0 || buffer->width != surface->width || buffer->height != surface->height) {
+		return 0;
 	}
-	
-	ShipPosition.x += ShipVelocity.x;
-	ShipPosition.y += ShipVelocity.y;
+	RenderCommand *clear = buffer->commands;
+	return clear->type == RenderCommand_Clear &&
+		clear->params.clear.x <= 0 && clear->params.clear.y <= 0 &&
+		clear->params.clear.x + clear->params.clear.width >= surface->width &&
+		clear->params.clear.y + clear->params.clear.height >= surface->height;
+}
 
-	{
-		Extents e = CalculateExtents((Point*)&ship_triangle, 3);
-		i32 ship_draw_area_width = e.max_x - e.min_x;
-		i32 ship_draw_area_height = e.max_y - e.min_y;	
+// Works out which cells the frame in buffer redraws and their rectangles
+// RETURNS: 0 if the whole surface has to be drawn without the tracker, which
+//          then knows nothing about the buffer until the next frame
+b8 DirtyTracker_BeginFrame(DirtyTracker *tracker, DrawSurface *surface, RenderCommandBuffer *buffer, i32 cell_size) {
+	b8 full_surface_clip = surface->clip_min_x == 0 && surface->clip_min_y == 0 &&
+		surface->clip_max_x == surface->width && surface->clip_max_y == surface->height;
+	if (!full_surface_clip || !StartsWithBackgroundClear(surface, buffer) ||
+		!DirtyTracker_Resize(tracker, surface->width, surface->height, cell_size)) {
+		tracker->valid = 0;
+		return 0;
+	}
 
-		// don't check <= because ship_pos_x will be equal if
-		// it goes off the right side of the screen
-		if (ShipPosition.x < -ship_draw_area_width) {
-			// went off left side of screen
-			ShipPosition.x = (f32)(surface->width - 1);
-		} else if (ShipPosition.x > (surface->width - 1)) {
-			// went off right side of screen
-			ShipPosition.x = (f32)-ship_draw_area_width;
+	u32 background = buffer->commands[0].color;
+	u64 cell_count = (u64)tracker->cells_x * tracker->cells_y;
+	if (tracker->valid && tracker->background == background) {
+		memcpy(tracker->dirty, tracker->touched, cell_count);
+	} else {
+		// nothing is known about the buffer, redraw all of it
+		memset(tracker->dirty, 1, cell_count);
+	}
+
+	memset(tracker->touched, 0, cell_count);
+	for (i32 i = 1; i < buffer->command_count; i++) {
+		RenderCommand *command = buffer->commands + i;
+		if (!OverlapsClip(surface, command->min_x, command->min_y, command->max_x, command->max_y)) {
+			continue;
+		}
+		i32 min_cell_x = max_i32(command->min_x, 0) / cell_size;
+		i32 min_cell_y = max_i32(command->min_y, 0) / cell_size;
+		i32 max_cell_x = min_i32(command->max_x, surface->width - 1) / cell_size;
+		i32 max_cell_y = min_i32(command->max_y, surface->height - 1) / cell_size;
+		for (i32 cell_y = min_cell_y; cell_y <= max_cell_y; cell_y++) {
+			u8 *row = tracker->touched + ((u64)cell_y * tracker->cells_x);
+			for (i32 cell_x = min_cell_x; cell_x <= max_cell_x; cell_x++) {
+				row[cell_x] = 1;
+			}
+		}
+	}
+	tracker->dirty_cell_count = 0;
+	for (u64 cell = 0; cell < cell_count; cell++) {
+		tracker->dirty[cell] |= tracker->touched[cell];
+		if (tracker->dirty[cell]) {
+			tracker->dirty_cells[tracker->dirty_cell_count++] = (i32)cell;
 		}
+	}
 
-		// don't check <= because ship_pos_y will be equal if
-		// it goes off the top side of the screen
-		if (ShipPosition.y < -ship_draw_area_height) {
-			// ship went off bottom of screen
-			ShipPosition.y = (f32)(surface->height - 1);
-		} else if (ShipPosition.y > (surface->height - 1)) {
-			// ship went off top of screen
-			ShipPosition.y = (f32)-ship_draw_area_height;
+	// runs of dirty cells along each row of cells
+	tracker->rect_count = 0;
+	for (i32 cell_y = 0; cell_y < tracker->cells_y; cell_y++) {
+		u8 *row = tracker->dirty + ((u64)cell_y * tracker->cells_x);
+		for (i32 cell_x = 0; cell_x < tracker->cells_x;) {
+			if (!row[cell_x]) {
+				cell_x++;
+				continue;
+			}
+			i32 run_start = cell_x;
+			while (cell_x < tracker->cells_x && row[cell_x]) {
+				cell_x++;
+			}
+			DirtyRect *rect = tracker->rects + tracker->rect_count++;
+			rect->min_x = run_start * cell_size;
+			rect->min_y = cell_y * cell_size;
+			rect->max_x = min_i32(cell_x * cell_size, surface->width);
+			rect->max_y = min_i32((cell_y + 1) * cell_size, surface->height);
+			tracker->pixels_redrawn += (u64)(rect->max_x - rect->min_x) * (rect->max_y - rect->min_y);
 		}
 	}
 
-	TranslatePoints((Point*)&ship_triangle, 3, ShipPosition.x, ShipPosition.y);
+	tracker->background = background;
+	tracker->valid = 1;
+	tracker->frames += 1;
+	return 1;
+}
 
-	ship_center = Centroid(ship_triangle);
-	ship_forward_direction.x = ship_triangle.b.x - ship_center.x;
-	ship_forward_direction.y = ship_triangle.b.y - ship_center.y;
-	forward_vector_length = my_sqrt((ship_forward_direction.x*ship_forward_direction.x) + (ship_forward_direction.y*ship_forward_direction.y));
-	ship_forward_direction.x /= forward_vector_length;
-	ship_forward_direction.y /= forward_vector_length;
+// Same output as ExecuteRenderCommands(surface, buffer), as long as the
+// surface holds the last frame drawn through the same tracker
+void ExecuteRenderCommandsDirty(DrawSurface *surface, RenderCommandBuffer *buffer, DirtyTracker *tracker) {
+	if (!DirtyTracker_BeginFrame(tracker, surface, buffer, DIRTY_CELL_SIZE)) {
+		ExecuteRenderCommands(surface, buffer);
+		return;
+	}
+	for (i32 i = 0; i < tracker->rect_count; i++) {
+		DirtyRect *rect = tracker->rects + i;
+		DrawSurface clipped = *surface;
+		clipped.clip_min_x = rect->min_x;
+		clipped.clip_min_y = rect->min_y;
+		clipped.clip_max_x = rect->max_x;
+		clipped.clip_max_y = rect->max_y;
+		ExecuteRenderCommands(&clipped, buffer);
+	}
+}
 
-	//////////////////////////////////////////////
-	//////////////////////////////////////////////
-	
-	///////////////////////////////////////////////
-	///////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////
+/// Render Snapshots
+///
+/// Lock-free single producer/single consumer triple buffer of command buffers.
+///
+/// The simulation fills the back buffer and swaps it with the middle one,
+/// the renderer swaps its front buffer with the middle one when a newer
+/// buffer is there, so the renderer always gets the latest complete frame.
+/// The swaps themselves never wait. The platform layers do make the
+/// simulation wait, in Win32_PublishSnapshot and Linux_PublishSnapshot, until
+/// the renderer has taken the previous snapshot (snapshot_acquired), so it
+/// stays at most one frame ahead and no frame is skipped.
+///
+/// state holds the index of the middle buffer, plus
+/// RENDER_SNAPSHOT_NEW_BIT when it hasn't been picked up by the renderer yet.
+#define RENDER_SNAPSHOT_INDEX_MASK 0x3
+#define RENDER_SNAPSHOT_NEW_BIT 0x4
 
-	for (i32 i = 0; i < MISSILE_POOL_SIZE; i++) {
-		Missile *missile = Missiles + i;
+typedef struct {
+	RenderCommandBuffer snapshots[3];
+	volatile u32 state;
+	u32 back_index; // only touched by the simulation
+	u32 front_index; // only touched by the renderer
+} RenderSnapshotBuffer;
+
+// RETURNS: 0 if the snapshots couldn't be registered, see RenderCommandBuffer_Register
+b8 RenderSnapshotBuffer_Init(RenderSnapshotBuffer *buffer) {
+	buffer->back_index = 0;
+	buffer->state = 1;
+	buffer->front_index = 2;
+	for (i32 i = 0; i < (i32)(sizeof(buffer->snapshots) / sizeof(buffer->snapshots[0])); i++) {
+		if (!RenderCommandBuffer_Register(buffer->snapshots + i)) {
+			return 0;
+		}
+	}
+	return 1;
+}
 
-		if (!missile->live) continue;
-		
-		f32 speed = delta_time * MISSILE_SPEED;
-		f32 missile_delta_x = speed * missile->direction.x;
-		f32 missile_delta_y = speed * missile->direction.y;
+// RETURNS: the command buffer to record the next frame into
+RenderCommandBuffer *RenderSnapshotBuffer_BeginWrite(RenderSnapshotBuffer *buffer) {
+	return buffer->snapshots + buffer->back_index;
+}
 
-		TranslatePoints(missile->points, 4, missile_delta_x, missile_delta_y);
+void RenderSnapshotBuffer_Publish(RenderSnapshotBuffer *buffer) {
+	u32 previous = AtomicExchangeU32(&buffer->state, buffer->back_index | RENDER_SNAPSHOT_NEW_BIT);
+	buffer->back_index = previous & RENDER_SNAPSHOT_INDEX_MASK;
+}
 
-		Extents e = CalculateExtents(missile->points, 4);
-		if ((e.min_x < 0 && e.max_x < 0) || 
-			(e.min_x > surface->width || e.max_x > surface->width) ||
-			(e.min_y < 0 && e.max_y < 0) ||
-			(e.min_y > surface->height || e.max_y > surface->height)) {
-				OutputDebugString("Missile destroyed!\n");
-				missile->live = 0;
-		}
+// RETURNS: 1 if a snapshot was published since the last call
+b8 RenderSnapshotBuffer_HasNew(RenderSnapshotBuffer *buffer) {
+	return (AtomicLoadU32(&buffer->state) & RENDER_SNAPSHOT_NEW_BIT) != 0;
+}
+
+// RETURNS: the latest published command buffer, it stays valid until the next call
+RenderCommandBuffer *RenderSnapshotBuffer_AcquireLatest(RenderSnapshotBuffer *buffer) {
+	if (RenderSnapshotBuffer_HasNew(buffer)) {
+		u32 previous = AtomicExchangeU32(&buffer->state, buffer->front_index);
+		buffer->front_index = previous & RENDER_SNAPSHOT_INDEX_MASK;
 	}
+	return buffer->snapshots + buffer->front_index;
+}
 
-	if (!PlayerDead && gShootMissile) {
-		Missile *new_missile = 0;
-		for (i32 i = 0; i < MISSILE_POOL_SIZE; i++) {
-			Missile *m = Missiles + i;
-			if (!m->live) {
-				new_missile = m;
-				break;
-			}
-		}
+//////////////////////////////////////////////////////////////////////////////////////
+/// Tiled Rendering
+///
+/// Splits the surface into square tiles, bins every command into the tiles
+/// its bounding box touches and draws the tiles in parallel with the clip
+/// rectangle set to the tile. A tile draws its commands in the same order as
+/// ExecuteRenderCommands and the draw routines never write outside the clip,
+/// so the output is identical.
 
-		if (new_missile) {
-			// set the missile points(the missile will be reused)
-			new_missile->points[0].x = 0;
-			new_missile->points[0].y = 0;
-			new_missile->points[1].x = 0;
-			new_missile->points[1].y = MISSILE_HEIGHT;
-			new_missile->points[2].x = MISSILE_WIDTH;
-			new_missile->points[2].y = MISSILE_HEIGHT;
-			new_missile->points[3].x = MISSILE_WIDTH;
-			new_missile->points[3].y = 0;
-
-			// rotate the missile so it's in the same direction as the ship
-			Point missile_center = {0};
-			missile_center.x = MISSILE_WIDTH / 2.0f;
-			missile_center.y = MISSILE_HEIGHT / 2.0f;
-			RotatePoints(new_missile->points, 4, missile_center, ShipRotationRadians);
+#define RENDER_TILE_SIZE 64
 
-			// put the missile at the tip of the ship
-			TranslatePoints(new_missile->points, 4, ship_triangle.b.x, ship_triangle.b.y);
+// Scratch space for the bins, grown as needed and reused every frame
+typedef struct {
+	i32 tile_capacity;
+	i32 index_capacity;
+	i32 *tile_offsets; // the commands of tile i are command_indices[tile_offsets[i], tile_offsets[i + 1])
+	i32 *tile_cursors;
+	i32 *command_indices;
+} RenderTileBins;
+
+void RenderTileBins_Free(RenderTileBins *bins) {
+	if (bins->tile_offsets) {
+		MyFree(bins->tile_offsets);
+		MyFree(bins->tile_cursors);
+	}
+	if (bins->command_indices) {
+		MyFree(bins->command_indices);
+	}
+	bins->tile_offsets = 0;
+	bins->tile_cursors = 0;
+	bins->command_indices = 0;
+	bins->tile_capacity = 0;
+	bins->index_capacity = 0;
+}
 
-			new_missile->direction = ship_forward_direction;
+static b8 RenderTileBins_ReserveTiles(RenderTileBins *bins, i32 tile_count) {
+	if (tile_count <= bins->tile_capacity) {
+		return 1;
+	}
+	if (bins->tile_offsets) {
+		MyFree(bins->tile_offsets);
+		MyFree(bins->tile_cursors);
+	}
+	bins->tile_offsets = (i32*)MyAlloc((u64)(tile_count + 1) * sizeof(i32));
+	bins->tile_cursors = (i32*)MyAlloc((u64)tile_count * sizeof(i32));
+	if (!bins->tile_offsets || !bins->tile_cursors) {
+		bins->tile_capacity = 0;
+		return 0;
+	}
+	bins->tile_capacity = tile_count;
+	return 1;
+}
 
-			new_missile->live = 1;
-		}
+static b8 RenderTileBins_ReserveIndices(RenderTileBins *bins, i32 index_count) {
+	if (index_count <= bins->index_capacity) {
+		return 1;
+	}
+	if (bins->command_indices) {
+		MyFree(bins->command_indices);
+	}
+	// room to grow, the overlay and more meteors add indices
+	i32 capacity = index_count * 2;
+	bins->command_indices = (i32*)MyAlloc((u64)capacity * sizeof(i32));
+	if (!bins->command_indices) {
+		bins->index_capacity = 0;
+		return 0;
+	}
+	bins->index_capacity = capacity;
+	return 1;
+}
 
-		gShootMissile = 0;
+typedef struct {
+	DrawSurface *surface;
+	RenderCommandBuffer *buffer;
+	RenderTileBins *bins;
+	i32 tile_size;
+	i32 tiles_x;
+	i32 *tiles; // the tiles to draw, 0 for all of them
+} RenderTilesJob;
+
+// RETURNS: 0 if the command doesn't touch any tile
+static b8 CommandTileRange(RenderTilesJob *job, RenderCommand *command,
+	i32 *min_tile_x, i32 *min_tile_y, i32 *max_tile_x, i32 *max_tile_y) {
+	DrawSurface *surface = job->surface;
+	if (!OverlapsClip(surface, command->min_x, command->min_y, command->max_x, command->max_y)) {
+		return 0;
 	}
+	*min_tile_x = (max_i32(command->min_x, surface->clip_min_x) - surface->clip_min_x) / job->tile_size;
+	*min_tile_y = (max_i32(command->min_y, surface->clip_min_y) - surface->clip_min_y) / job->tile_size;
+	*max_tile_x = (min_i32(command->max_x, surface->clip_max_x - 1) - surface->clip_min_x) / job->tile_size;
+	*max_tile_y = (min_i32(command->max_y, surface->clip_max_y - 1) - surface->clip_min_y) / job->tile_size;
+	return 1;
+}
 
-	// Clear background
-	DrawRectangle(surface, 0, 0, surface->width, surface->height, BACKGROUND_COLOR);	
+static void RenderTile(void *data, i32 index) {
+	RenderTilesJob *job = (RenderTilesJob*)data;
+	i32 tile_index = job->tiles ? job->tiles[index] : index;
+	DrawSurface tile = *job->surface;
+	tile.clip_min_x = job->surface->clip_min_x + ((tile_index % job->tiles_x) * job->tile_size);
+	tile.clip_min_y = job->surface->clip_min_y + ((tile_index / job->tiles_x) * job->tile_size);
+	tile.clip_max_x = min_i32(tile.clip_min_x + job->tile_size, job->surface->clip_max_x);
+	tile.clip_max_y = min_i32(tile.clip_min_y + job->tile_size, job->surface->clip_max_y);
+
+	i32 first = job->bins->tile_offsets[tile_index];
+	i32 count = job->bins->tile_offsets[tile_index + 1] - first;
+	ExecuteRenderCommandList(&tile, job->buffer, job->bins->command_indices + first, count);
+}
 
-	if (PlayerDead) {
-		TimeSincePlayerDied += delta_time;
-		TimeSinceLastDrawShipFlagFlipped += delta_time;
-	
-		if (TimeSincePlayerDied >= 3.0f) {
-			PlayerDead = 0;
-			Flag_DrawShip = 1;
-			TimeSincePlayerDied = 0.0f;
-			TimeSinceLastDrawShipFlagFlipped = 0.0f;
-		} else if (TimeSinceLastDrawShipFlagFlipped >= 0.3f) {
-			Flag_DrawShip = !Flag_DrawShip;
-			TimeSinceLastDrawShipFlagFlipped = 0.0f;
-		}
+// Same output as ExecuteRenderCommands(surface, buffer), drawn on every thread of the job system
+// dirty is optional, with it only the tiles it marks dirty are drawn and its
+// cells are the tiles
+void ExecuteRenderCommandsTiled(DrawSurface *surface, RenderCommandBuffer *buffer, JobSystem *jobs,
+	RenderTileBins *bins, i32 tile_size, DirtyTracker *dirty) {
+	i32 clip_width = surface->clip_max_x - surface->clip_min_x;
+	i32 clip_height = surface->clip_max_y - surface->clip_min_y;
+	if (clip_width <= 0 || clip_height <= 0) {
+		return;
 	}
-	
-	if (Flag_DrawShip) {
-		for (i32 i = 0; i < ship_point_count; i++) {
-			Point p1 = *(ship_points + i);
-			Point p2 = {0};
-			if (i == ship_point_count - 1) {
-				p2 = *ship_points;
-			} else {
-				p2 = *(ship_points + i + 1);
-			}
-			
-			DrawLine(surface, p1, p2, SHIP_COLOR);
-		}
+
+	RenderTilesJob job = {0};
+	job.surface = surface;
+	job.buffer = buffer;
+	job.bins = bins;
+	job.tile_size = tile_size;
+	job.tiles_x = (clip_width + tile_size - 1) / tile_size;
+	i32 tiles_y = (clip_height + tile_size - 1) / tile_size;
+	i32 tile_count = job.tiles_x * tiles_y;
+	if (!RenderTileBins_ReserveTiles(bins, tile_count)) {
+		ExecuteRenderCommands(surface, buffer);
+		return;
 	}
-	
-	for (i32 i = 0; i < MISSILE_POOL_SIZE; i++) {
-		Missile missile = Missiles[i];
-		if (!missile.live) continue;
-
-		// constrain how the number of points to check that in a the missile rectangle
-		Extents e = CalculateExtents(missile.points, 4);
-
-		// NOTE: Rasterize the rectangle by checking if a point is inside the rectangle. Do so
-		//       by constructing vectors representing the sides of the rectangle, and a vector
-		//       representing the test point. Project the vector representing the test point on
-		//       to both vectors representing the sides of the rectangle, and if the projection
-		//       length is within the respective range, then the point is inside the rectangle.
-
-		Vec2 ab = {0};
-		ab.x = missile.points[1].x - missile.points[0].x;
-		ab.y = missile.points[1].y - missile.points[0].y;
-		f32 dot_ab_ab = VectorLength(ab);
-
-		Vec2 ad = {0};
-		ad.x = missile.points[3].x - missile.points[0].x;
-		ad.y = missile.points[3].y - missile.points[0].y;
-		f32 dot_ad_ad = VectorLength(ad);
-
-		for (i32 y = e.min_y; y < e.max_y; y++) {
-			for (i32 x = e.min_x; x < e.max_x; x++) {
-				Vec2 am = { .x = (x - missile.points[0].x), .y = (y - missile.points[0].y) };
-
-				f32 dot_am_ab = DotProduct(am, ab);
-				if (dot_am_ab < 0 || dot_am_ab > dot_ab_ab) {
-					continue;
-				}
 
-				f32 dot_am_ad = DotProduct(am, ad);
-				if (dot_am_ad < 0 || dot_am_ad > dot_ad_ad) {
-					continue;
-				}
-				
-				if (x < 0 || x >= surface->width) {
-					continue;
-				}
-				if (y < 0 || y >= surface->height) {
-					continue;
-				}
-				u32 *pixel = surface->pixels + x + (y * surface->width);
-				*pixel = 0xFFFFFFFF;
+	// count the commands of every tile, then lay the bins out back to back
+	i32 *tile_offsets = bins->tile_offsets;
+	for (i32 tile = 0; tile <= tile_count; tile++) {
+		tile_offsets[tile] = 0;
+	}
+	for (i32 i = 0; i < buffer->command_count; i++) {
+		i32 min_tile_x, min_tile_y, max_tile_x, max_tile_y;
+		if (!CommandTileRange(&job, buffer->commands + i, &min_tile_x, &min_tile_y, &max_tile_x, &max_tile_y)) {
+			continue;
+		}
+		for (i32 tile_y = min_tile_y; tile_y <= max_tile_y; tile_y++) {
+			for (i32 tile_x = min_tile_x; tile_x <= max_tile_x; tile_x++) {
+				tile_offsets[(tile_y * job.tiles_x) + tile_x + 1] += 1;
 			}
 		}
 	}
+	for (i32 tile = 0; tile < tile_count; tile++) {
+		tile_offsets[tile + 1] += tile_offsets[tile];
+		bins->tile_cursors[tile] = tile_offsets[tile];
+	}
+	if (!RenderTileBins_ReserveIndices(bins, tile_offsets[tile_count])) {
+		ExecuteRenderCommands(surface, buffer);
+		return;
+	}
 
-	for (i32 i = 0; i < METEOR_POOL_SIZE; i++) {
-		Meteor *meteor = Meteors + i;
-		if (!meteor->active) continue;
-		meteor->pos.x += meteor->direction.x * (delta_time * meteor->speed);
-		meteor->pos.y += meteor->direction.y * (delta_time * meteor->speed);
-		
-		if ((meteor->pos.x + meteor->radius) <= 0) {
-			meteor->pos.x = (f32)(surface->width + meteor->radius);
-		} else if ((meteor->pos.x - meteor->radius) >= surface->width) {
-			meteor->pos.x = (f32)(-1 * meteor->radius);
+	// commands go into the bins in order, so every tile draws them in order
+	for (i32 i = 0; i < buffer->command_count; i++) {
+		i32 min_tile_x, min_tile_y, max_tile_x, max_tile_y;
+		if (!CommandTileRange(&job, buffer->commands + i, &min_tile_x, &min_tile_y, &max_tile_x, &max_tile_y)) {
+			continue;
 		}
-		
-		if ((meteor->pos.y + meteor->radius) <= 0) {
-			meteor->pos.y = (f32)(surface->height + meteor->radius);
-		} else if ((meteor->pos.y - meteor->radius) >= surface->height) {
-			meteor->pos.y = (f32)(-1 * meteor->radius);
+		for (i32 tile_y = min_tile_y; tile_y <= max_tile_y; tile_y++) {
+			for (i32 tile_x = min_tile_x; tile_x <= max_tile_x; tile_x++) {
+				i32 tile = (tile_y * job.tiles_x) + tile_x;
+				bins->command_indices[bins->tile_cursors[tile]++] = i;
+			}
 		}
-		
-		DrawCircle(surface, meteor->radius, meteor->pos.x, meteor->pos.y);
 	}
-	
-	// Collision detection between ship and meteor
-	if (!PlayerDead) {
-		for (i32 i = 0; i < METEOR_POOL_SIZE; i++) {
-			Meteor *meteor = Meteors + i;
-			if (!meteor->active) continue;
-			
-			if (AnyPointsInsideCircle(meteor->radius, meteor->pos, ship_points, 3)) {
-				PlayerDead = 1;
-				PlayerLives -= 1;
-				if (PlayerLives == 0) {
-					GameOver = 1;
-				}
-			}
+
+	if (dirty && DirtyTracker_BeginFrame(dirty, surface, buffer, tile_size)) {
+		job.tiles = dirty->dirty_cells;
+		ParallelFor(jobs, dirty->dirty_cell_count, RenderTile, &job);
+	} else {
+		ParallelFor(jobs, tile_count, RenderTile, &job);
+	}
+}
+
+// frame_seconds is the real time the previous frame took. It is banked and
+// spent in fixed simulation steps.
+// RETURNS: how far past the last step the frame is, in [0, 1)
+static f32 SimulateFrame(f32 frame_seconds, i32 width, i32 height) {
+	if (!GameMemory) {
+		GameMemory = GameMemory_Create();
+		if (!GameMemory) {
+			Platform_Quit("Failed to allocate the meteors, missiles and render commands!");
+			return 0.0f;
 		}
 	}
-	
-	for (i32 i = 0; i < METEOR_POOL_SIZE; i++) {
-		Meteor *meteor = Meteors + i;
-		if (!meteor->active) continue;
-		
-		for (i32 j = 0; j < MISSILE_POOL_SIZE; j++) {
-			Missile *missile = Missiles + j;
-			if (!missile->live) continue;
-			
-			if (AnyPointsInsideCircle(meteor->radius, meteor->pos, missile->points, 4)) {
-				meteor->active = 0;
-				missile->live = 0;
-				Score += 1;
-				if (meteor->radius >= 35) {
-					i32 radius = 15 + (rand() % 15);
-					i32 speed = meteor->speed;
-					SpawnMeteor(meteor->pos, radius, speed);
-					radius = 15 + (rand() % 15);
-					speed = meteor->speed;
-					SpawnMeteor(meteor->pos, radius, speed);
+
+	SimulationAccumulator += frame_seconds;
+
+	i32 steps = 0;
+	while (SimulationAccumulator >= SIMULATION_TIMESTEP) {
+		if (steps == SIMULATION_MAX_STEPS_PER_FRAME) {
+			SimulationAccumulator = 0.0f;
+			break;
+		}
+
+		if (gInputRecording) {
+			if (gInputPlayback) {
+				if (!InputRecording_PlaybackStep(gInputRecording)) {
+					// the recording is over
+					InputRecording_End();
+					Platform_Quit(0);
+					break;
 				}
-				break;
+			} else {
+				InputRecording_RecordStep(gInputRecording);
 			}
 		}
-	}
-	
-	i32 active_meteor_count = 0;
-	for (i32 i = 0; i < METEOR_POOL_SIZE; i++) {
-		Meteor *meteor = Meteors + i;
-		active_meteor_count += meteor->active;
-	}
-	if (active_meteor_count == 0) {
-		MessageBox(
-			NULL,
-			"You won! You destoryed all the meteors!",
-			"Asteroids!",
-			MB_OK
-		);
-		ExitProcess(0);
-	}
 
-	if (GameOver) {
-		f32 relative_x = 0.5f;
-		i32 xPos = my_ceil((f32)surface->width * relative_x);
-	
-		f32 relative_y = 0.5f;
-		i32 yPos = my_ceil((f32)surface->height * relative_y);
-		
-		DrawString(surface, "GAME OVER", xPos, yPos);		
+		UpdateGame(SIMULATION_TIMESTEP, width, height);
+		SimulationAccumulator -= SIMULATION_TIMESTEP;
+		steps++;
 	}
-	
-	f32 relative_x = 0.05f;
-	i32 xPos = my_ceil((f32)surface->width * relative_x);
-
-	f32 relative_y = 0.05f;
-	i32 yPos = my_ceil((f32)surface->height * relative_y);
 
-	char *score_text = "Score: ";
-	i32 score_text_length = (i32)strlen(score_text);
-	KDTF_DrawText(&gFont, score_text, score_text_length, 0xFFFFFFFF, &xPos, &yPos, surface->pixels, surface->width, surface->height);
-	KDTF_DrawNumber(&gFont, Score, 0xFFFFFFFF, &xPos, &yPos, surface->pixels, surface->width, surface->height);
+	if (!Flag_Initialized) {
+		InitializeGame(width, height);
+	}
 
-	xPos = my_ceil((f32)surface->width * relative_x);
-	NewLine(&yPos);
-	
-	char *lives_text = "Lives: ";
-	i32 lives_left_text_length = (i32)strlen(lives_text);
-	KDTF_DrawText(&gFont, lives_text, lives_left_text_length, 0xFFFFFFFF, &xPos, &yPos, surface->pixels, surface->width, surface->height);
-	KDTF_DrawNumber(&gFont, PlayerLives, 0xFFFFFFFF, &xPos, &yPos, surface->pixels, surface->width, surface->height);
+	return SimulationAccumulator / SIMULATION_TIMESTEP;
 }
 
+
+#if _WIN32
 b8 Win32_ReadFile(char *filepath, void **out_bytes, u64 *out_byte_count) {
 	HANDLE file_handle = CreateFileA(
 		filepath, GENERIC_READ|GENERIC_WRITE, FILE_SHARE_READ, 
@@ -1136,15 +4046,161 @@ b8 Win32_ReadFile(char *filepath, void **out_bytes, u64 *out_byte_count) {
 	return true;
 }
 
-void *MyAlloc(u64 size) {
-	return VirtualAlloc(0, size, MEM_RESERVE|MEM_COMMIT, PAGE_READWRITE);
-}
+b8 Win32_WriteFile(char *filepath, void *bytes, u64 byte_count) {
+	HANDLE file_handle = CreateFileA(
+		filepath, GENERIC_WRITE, 0,
+		0, CREATE_ALWAYS, 0, 0);
 
-void MyFree(void *ptr) {
-	VirtualFree(ptr, 0, MEM_RELEASE);
+	if (file_handle == INVALID_HANDLE_VALUE) {
+		wchar_t message[256] = {0};
+		wsprintfW(message, L"CreateFileA(%s) failed with error: %d\n", filepath, GetLastError());
+		OutputDebugStringW(message);
+		return false;
+	}
+
+	DWORD bytes_written = 0;
+	BOOL write_file = WriteFile(file_handle, bytes, (DWORD)byte_count, &bytes_written, NULL);
+	CloseHandle(file_handle);
+
+	if (!write_file || bytes_written != byte_count) {
+		OutputDebugStringW(L"Failed to write file!\n");
+		return false;
+	}
+
+	return true;
 }
 
+#endif
+
 #define CHARACTER_COUNT 93
+#define INPUT_RECORDING_FILENAME "asteroids.rec"
+
+#if _WIN32
+// NOTE: The main thread pumps messages and runs the simulation, the render
+//       thread draws the snapshots it publishes, uploads them and presents.
+//       After the render thread starts it is the only thread that touches
+//       the D3D11 device context, the swap chain and the pixels.
+typedef struct {
+	RenderSnapshotBuffer snapshots;
+	HANDLE snapshot_published; // semaphore, released for every snapshot
+	HANDLE snapshot_acquired; // semaphore, released when the renderer takes one
+	volatile u32 stop;
+	HANDLE thread;
+	JobSystem *jobs; // helps the render thread draw tiles
+	RenderTileBins tile_bins;
+	DirtyTracker dirty; // pixels is the only buffer, one tracker covers it
+
+	IDXGISwapChain *swap_chain;
+	ID3D11Device *device;
+	ID3D11DeviceContext *device_context;
+	ID3D11Texture2D *gpubuffer;
+	ID3D11Texture2D *cpubuffer;
+	u32 *pixels;
+	u32 cpu_buffer_width;
+	i32 width;
+	i32 height;
+} Win32_RenderThread;
+
+static void Win32_PresentSnapshot(Win32_RenderThread *render_thread, RenderCommandBuffer *snapshot) {
+	HRESULT hResult = 0;
+
+	b8 window_visible = render_thread->pixels && render_thread->width && render_thread->height;
+	if (window_visible) {
+		DrawSurface ds = MakeDrawSurface(render_thread->pixels, render_thread->cpu_buffer_width, render_thread->height);
+		DirtyTracker *dirty = &render_thread->dirty;
+		if (render_thread->jobs->worker_count) {
+			ExecuteRenderCommandsTiled(&ds, snapshot, render_thread->jobs, &render_thread->tile_bins, RENDER_TILE_SIZE, dirty);
+		} else {
+			// tiles only cost extra on a single core
+			ExecuteRenderCommandsDirty(&ds, snapshot, dirty);
+		}
+
+		// NOTE: cpubuffer keeps its contents between frames, so only the dirty
+		// rectangles go over the bus. Without them the whole frame does.
+		u32 row_bytes = render_thread->cpu_buffer_width * sizeof(u32);
+		if (dirty->valid) {
+			for (i32 i = 0; i < dirty->rect_count; i++) {
+				DirtyRect *rect = dirty->rects + i;
+				D3D11_BOX box = { (UINT)rect->min_x, (UINT)rect->min_y, 0, (UINT)rect->max_x, (UINT)rect->max_y, 1 };
+				u32 *source = render_thread->pixels + ((u64)rect->min_y * render_thread->cpu_buffer_width) + rect->min_x;
+				ID3D11DeviceContext_UpdateSubresource(render_thread->device_context, (ID3D11Resource*)render_thread->cpubuffer, 0,
+					&box, source, row_bytes, 0);
+			}
+		} else {
+			ID3D11DeviceContext_UpdateSubresource(render_thread->device_context, (ID3D11Resource*)render_thread->cpubuffer, 0,
+				0, render_thread->pixels, row_bytes, 0);
+		}
+
+		ID3D11DeviceContext_CopyResource(render_thread->device_context, (ID3D11Resource*)render_thread->gpubuffer, 
+			(ID3D11Resource*)render_thread->cpubuffer);
+	}
+
+	hResult = IDXGISwapChain_Present(render_thread->swap_chain, 0, 0);
+	if (hResult == DXGI_STATUS_OCCLUDED) {
+		// window is not visible
+		Sleep(10);
+	} else if (!SUCCEEDED(hResult)) {
+		hResult = ID3D11Device_GetDeviceRemovedReason(render_thread->device);
+		Assert(false);
+	}
+}
+
+static DWORD WINAPI Win32_RenderThreadProc(LPVOID parameter) {
+	Win32_RenderThread *render_thread = (Win32_RenderThread*)parameter;
+	for (;;) {
+		WaitForSingleObject(render_thread->snapshot_published, INFINITE);
+		if (!RenderSnapshotBuffer_HasNew(&render_thread->snapshots)) {
+			if (AtomicLoadU32(&render_thread->stop)) {
+				break;
+			}
+			continue;
+		}
+
+		RenderCommandBuffer *snapshot = RenderSnapshotBuffer_AcquireLatest(&render_thread->snapshots);
+		ReleaseSemaphore(render_thread->snapshot_acquired, 1, 0);
+		Win32_PresentSnapshot(render_thread, snapshot);
+	}
+	return 0;
+}
+
+static b8 Win32_StartRenderThread(Win32_RenderThread *render_thread) {
+	if (!RenderSnapshotBuffer_Init(&render_thread->snapshots)) {
+		return 0;
+	}
+	render_thread->snapshot_published = CreateSemaphoreA(0, 0, MAXLONG, 0);
+	render_thread->snapshot_acquired = CreateSemaphoreA(0, 0, MAXLONG, 0);
+	if (!render_thread->snapshot_published || !render_thread->snapshot_acquired) {
+		return 0;
+	}
+	// the main thread and the render thread are already busy
+	if (!JobSystem_Start(&gJobs, Platform_ProcessorCount() - 2)) {
+		return 0;
+	}
+	render_thread->jobs = &gJobs;
+	render_thread->thread = CreateThread(0, 0, Win32_RenderThreadProc, render_thread, 0, 0);
+	return render_thread->thread != 0;
+}
+
+// Called by the main thread after the simulation steps of a frame. The
+// simulation stays at most one frame ahead of the renderer, so it overlaps
+// the next frame's simulation with this frame's drawing and Present.
+static void Win32_PublishSnapshot(Win32_RenderThread *render_thread, f32 alpha, i32 width, i32 height, b8 first_frame) {
+	if (!first_frame) {
+		WaitForSingleObject(render_thread->snapshot_acquired, INFINITE);
+	}
+	BuildRenderCommands(RenderSnapshotBuffer_BeginWrite(&render_thread->snapshots), alpha, width, height);
+	RenderSnapshotBuffer_Publish(&render_thread->snapshots);
+	ReleaseSemaphore(render_thread->snapshot_published, 1, 0);
+}
+
+static void Win32_StopRenderThread(Win32_RenderThread *render_thread) {
+	AtomicExchangeU32(&render_thread->stop, 1);
+	ReleaseSemaphore(render_thread->snapshot_published, 1, 0);
+	WaitForSingleObject(render_thread->thread, INFINITE);
+	JobSystem_Stop(render_thread->jobs);
+	RenderTileBins_Free(&render_thread->tile_bins);
+	DirtyTracker_Free(&render_thread->dirty);
+}
 
 int WinMainCRTStartup() {
 	void *font_file_contents = 0;
@@ -1154,7 +4210,7 @@ int WinMainCRTStartup() {
 		ExitProcess(1);
 	}
 	
-	char character_set[CHARACTER_COUNT] = {0};
+	char character_set[CHARACTER_COUNT + 1] = {0}; // NUL terminated for KDTF_AllocateFont
 	for (i32 i = 0; i < CHARACTER_COUNT; i++) {
 		character_set[i] = '!' + (char)i;
 	}
@@ -1168,6 +4224,10 @@ int WinMainCRTStartup() {
 		MessageBox(NULL, "Failed to parse font file!", "Font Error", MB_OK);
 		ExitProcess(1);
 	}
+
+	if (!Sprites_Init()) {
+		Platform_WriteConsole("Failed to build the sprite atlas, drawing without sprites\n");
+	}
 	
 	HINSTANCE hInstance = GetModuleHandle(0);
 
@@ -1300,7 +4360,7 @@ int WinMainCRTStartup() {
 	LARGE_INTEGER now = {0};
 	LARGE_INTEGER performance_freq = {0};
 	QueryPerformanceFrequency(&performance_freq);
-//	i64 ticks_per_second = performance_freq.QuadPart;
+	i64 ticks_per_second = performance_freq.QuadPart;
 
 
 #define TARGET_FRAME_TIME_MICROS (1000000/60)
@@ -1313,10 +4373,23 @@ int WinMainCRTStartup() {
 	u32 *pixels = 0;
 	u32 cpu_buffer_width = WindowWidth;
 	
-	srand((u32)now.QuadPart);
+	SeedRandom((u32)now.QuadPart);
+
+	// F5 starts recording from a fresh game, pressing it again saves the
+	// recording to INPUT_RECORDING_FILENAME
+	InputRecording recording = {0};
+	b8 recording_input = 0;
+
+	Win32_RenderThread render_thread = {0};
+	b8 render_thread_started = 0;
+	b8 first_frame = 1;
 
 	MSG msg = {0};
 	while (!gShouldCloseWindow) {
+		QueryPerformanceCounter(&now);
+		i64 frame_timer_begin_tick = now.QuadPart;
+		Profile_BeginFrame();
+
 		while (PeekMessageA(&msg, window, 0, 0, PM_REMOVE)) {
 			TranslateMessage(&msg);
 			DispatchMessage(&msg);
@@ -1356,21 +4429,17 @@ int WinMainCRTStartup() {
 					.ArraySize = 1,
 					.Format = DXGI_FORMAT_B8G8R8A8_UNORM,
 					.SampleDesc = { 1, 0 },
-					.Usage = D3D11_USAGE_DYNAMIC,
+					// NOTE: UpdateSubresource instead of Map, a mapped dynamic texture
+					// has to be rewritten in full every frame
+					.Usage = D3D11_USAGE_DEFAULT,
 					.BindFlags = D3D11_BIND_SHADER_RESOURCE,
-					.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE
+					.CPUAccessFlags = 0
 				};
 
 				hResult = ID3D11Device_CreateTexture2D(d3d11_device, &cpu_buffer_description, NULL, &cpubuffer);
 				Assert(SUCCEEDED(hResult));
 				
-				D3D11_MAPPED_SUBRESOURCE cpu_buffer_subresource = {0};
-				hResult = ID3D11DeviceContext_Map(d3d11_device_context, (ID3D11Resource*)cpubuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &cpu_buffer_subresource);
-				Assert(SUCCEEDED(hResult));
-				
-				cpu_buffer_width = cpu_buffer_subresource.RowPitch / sizeof(u32);
-				
-				ID3D11DeviceContext_Unmap(d3d11_device_context, (ID3D11Resource*)cpubuffer, 0);
+				cpu_buffer_width = WindowWidth;
 				
 				pixels = VirtualAlloc(0, cpu_buffer_width * WindowHeight * sizeof(u32), MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
 				Assert(pixels);
@@ -1382,10 +4451,8 @@ int WinMainCRTStartup() {
 		QueryPerformanceCounter(&now);
 		i64 current_tick_count = now.QuadPart;
 
-//		i64 elapsed_ticks_since_last_frame = current_tick_count - last_tick_count;
-//#pragma warning(disable: 4189)
-//		f32 time_since_last_frame = (f32)(elapsed_ticks_since_last_frame) / ticks_per_second;
-//#pragma warning(default: 4189)
+		i64 elapsed_ticks_since_last_frame = current_tick_count - last_tick_count;
+		f32 time_since_last_frame = (f32)(elapsed_ticks_since_last_frame) / ticks_per_second;
 		
 //		char time_since_last_frame_msg[256] = {0};
 //		snprintf(time_since_last_frame_msg, sizeof(time_since_last_frame_msg),
@@ -1403,51 +4470,55 @@ int WinMainCRTStartup() {
 		
 		Platform_WriteConsole("Mouse: x=%d y=%d\n", MouseX, MouseY);
 
-		DrawSurface ds = {0};
-		ds.pixels = pixels;
-		ds.width = cpu_buffer_width;
-		ds.height = WindowHeight;
-
-		UpdateAndRender(0.003f, &ds);
-
-		b8 window_visible = WindowWidth && WindowHeight;
-		if (window_visible) {
-			D3D11_MAPPED_SUBRESOURCE mapped_resource = {0};
-			hResult = ID3D11DeviceContext_Map(d3d11_device_context, (ID3D11Resource*)cpubuffer, 0,
-				D3D11_MAP_WRITE_DISCARD, 0, &mapped_resource);
-			Assert(SUCCEEDED(hResult));
-
-			for (u32 i = 0; i < (cpu_buffer_width * WindowHeight); i++) {
-				((u32*)mapped_resource.pData)[i] = pixels[i];
-			}			
-
-			ID3D11DeviceContext_Unmap(d3d11_device_context, (ID3D11Resource*)cpubuffer, 0);
-			ID3D11DeviceContext_CopyResource(d3d11_device_context, (ID3D11Resource*)gpubuffer, 
-				(ID3D11Resource*)cpubuffer);
+		if (!render_thread_started) {
+			render_thread.swap_chain = swap_chain;
+			render_thread.device = d3d11_device;
+			render_thread.device_context = d3d11_device_context;
+			render_thread.gpubuffer = gpubuffer;
+			render_thread.cpubuffer = cpubuffer;
+			render_thread.pixels = pixels;
+			render_thread.cpu_buffer_width = cpu_buffer_width;
+			render_thread.width = WindowWidth;
+			render_thread.height = WindowHeight;
+			if (!Win32_StartRenderThread(&render_thread)) {
+				Platform_Quit("Failed to start the render thread!");
+				break;
+			}
+			render_thread_started = 1;
 		}
-			
-		hResult = IDXGISwapChain_Present(swap_chain, 0, 0);
-		if (hResult == DXGI_STATUS_OCCLUDED) {
-			// window is not visible
-			Sleep(10);
-		} else if (!SUCCEEDED(hResult)) {
-			hResult = ID3D11Device_GetDeviceRemovedReason(d3d11_device);
-			Assert(false);
+
+		if (gToggleInputRecording) {
+			gToggleInputRecording = 0;
+			if (recording_input) {
+				recording_input = 0;
+				InputRecording_End();
+				Win32_WriteFile(INPUT_RECORDING_FILENAME, recording.data, recording.size);
+				Platform_WriteConsole("Saved %u steps of input to %s\n",
+					InputRecording_Header(&recording)->step_count, INPUT_RECORDING_FILENAME);
+			} else {
+				recording_input = 1;
+				InputRecording_BeginRecording(&recording, (u32)current_tick_count, cpu_buffer_width, WindowHeight);
+			}
 		}
 
-//		QueryPerformanceCounter(&now);
-//		i64 frame_timer_end_tick = now.QuadPart;
+		f32 alpha = SimulateFrame(time_since_last_frame, cpu_buffer_width, WindowHeight);
+		Win32_PublishSnapshot(&render_thread, alpha, cpu_buffer_width, WindowHeight, first_frame);
+		first_frame = 0;
+
+		QueryPerformanceCounter(&now);
+		i64 frame_timer_end_tick = now.QuadPart;
 		
-//		i64 elapsed_ticks = (frame_timer_end_tick - frame_timer_begin_tick);
-//		f32 frame_elapsed_time_micros = (elapsed_ticks * 1000000.0f) / ticks_per_second;
-//		f32 frame_elapsed_time_millis = (frame_elapsed_time_micros / 1000.0f);
-//		char frame_time_msg[256] = {0};
-//		snprintf(frame_time_msg, sizeof(frame_time_msg), "Frame: %fms (%fus)\n", 
-//			frame_elapsed_time_millis, frame_elapsed_time_micros);
-//		OutputDebugStringA(frame_time_msg);
+		i64 elapsed_ticks = (frame_timer_end_tick - frame_timer_begin_tick);
+		f32 frame_elapsed_time_seconds = (f32)elapsed_ticks / (f32)ticks_per_second;
+		Profile_EndFrame(frame_elapsed_time_seconds);
 	}
 	
+	if (render_thread_started) {
+		Win32_StopRenderThread(&render_thread);
+	}
+
 	// CRT not present, so have to manually exit process here
 	ExitProcess(0);
 }
+#endif
 
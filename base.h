@@ -2,15 +2,26 @@
 #define EDIT_BASE_H
 
 #include <math.h>
-#include <intrin.h>
 #include <stdbool.h>
 
+#if _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+
 #define PI 3.141592654f
 
 #define DEBUG 1
 
+#if _MSC_VER
+#define DebugBreakpoint() __debugbreak()
+#else
+#define DebugBreakpoint() __builtin_trap()
+#endif
+
 #if DEBUG
-#define Assert(Expression) if(!(Expression)) { __debugbreak(); }
+#define Assert(Expression) if(!(Expression)) { DebugBreakpoint(); }
 #else
 #define Assert(Expression) if(!(Expression)) { *(int*)0 = 0; }
 #endif
@@ -82,19 +93,94 @@ i64 Abs(i64 value) {
 	return ((value < 0) * (-1 * value)) + ((value >= 0) * value);
 }
 
-f32 ArcTangent(f32 y, f32 x) {
-	__m128 operand_y = _mm_load1_ps(&y);
-	__m128 operand_x = _mm_load1_ps(&x);
-	__m128 arctan_2 = _mm_atan2_ps(operand_y, operand_x);
-	f32 result = *arctan_2.m128_f32;
-	return result;
+// Full barrier, RETURNS: the previous value
+u32 AtomicExchangeU32(volatile u32 *target, u32 value) {
+#if _MSC_VER
+	return (u32)_InterlockedExchange((volatile long*)target, (long)value);
+#else
+	return __atomic_exchange_n(target, value, __ATOMIC_SEQ_CST);
+#endif
 }
 
-f32 SquareRoot(f32 value) {
-	__m128 operand = _mm_load1_ps(&value);
-	__m128 square_root = _mm_sqrt_ps(operand);
-	f32 result = *square_root.m128_f32;
-	return result;
+// Full barrier, RETURNS: the value before the add
+u32 AtomicFetchAddU32(volatile u32 *target, u32 value) {
+#if _MSC_VER
+	return (u32)_InterlockedExchangeAdd((volatile long*)target, (long)value);
+#else
+	return __atomic_fetch_add(target, value, __ATOMIC_SEQ_CST);
+#endif
+}
+
+// Full barrier, RETURNS: 1 if target held expected and now holds desired
+b8 AtomicCompareExchangeU32(volatile u32 *target, u32 expected, u32 desired) {
+#if _MSC_VER
+	return (u32)_InterlockedCompareExchange((volatile long*)target, (long)desired, (long)expected) == expected;
+#else
+	return __atomic_compare_exchange_n(target, &expected, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+#endif
+}
+
+u32 AtomicLoadU32(volatile u32 *target) {
+#if _MSC_VER
+	// NOTE: volatile reads are acquire loads on x86/x64 (/volatile:ms)
+	return *target;
+#else
+	return __atomic_load_n(target, __ATOMIC_ACQUIRE);
+#endif
+}
+
+// Full barrier, RETURNS: the previous value
+u64 AtomicExchangeU64(volatile u64 *target, u64 value) {
+#if _MSC_VER
+	return (u64)_InterlockedExchange64((volatile long long*)target, (long long)value);
+#else
+	return __atomic_exchange_n(target, value, __ATOMIC_SEQ_CST);
+#endif
+}
+
+u64 AtomicLoadU64(volatile u64 *target) {
+#if _MSC_VER
+	// NOTE: aligned 64-bit volatile reads are atomic on x64
+	return *target;
+#else
+	return __atomic_load_n(target, __ATOMIC_ACQUIRE);
+#endif
+}
+
+void AtomicStoreU64(volatile u64 *target, u64 value) {
+#if _MSC_VER
+	// NOTE: volatile writes are release stores on x86/x64 (/volatile:ms)
+	*target = value;
+#else
+	__atomic_store_n(target, value, __ATOMIC_RELEASE);
+#endif
+}
+
+// Full barrier, RETURNS: 1 if target held expected and now holds desired
+b8 AtomicCompareExchangeU64(volatile u64 *target, u64 expected, u64 desired) {
+#if _MSC_VER
+	return (u64)_InterlockedCompareExchange64((volatile long long*)target, (long long)desired, (long long)expected) == expected;
+#else
+	return __atomic_compare_exchange_n(target, &expected, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+#endif
+}
+
+// Orders every load and store before it against every one after it,
+// including a store followed by a load
+void AtomicFence() {
+#if _MSC_VER
+	_mm_mfence();
+#else
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+#endif
+}
+
+void AtomicAddU64(volatile u64 *target, u64 value) {
+#if _MSC_VER
+	_InterlockedExchangeAdd64((volatile long long*)target, (long long)value);
+#else
+	__atomic_fetch_add(target, value, __ATOMIC_RELAXED);
+#endif
 }
 
 b8 is_whitespace(i32 character) {
@@ -12,6 +12,7 @@ REM /W3 /WX - Warnings
 REM /GS- - don't add buffer check code that requires CRT
 REM /O1 or /O2 - Optimizations
 REM /Od - Disable Optimizations
+REM /fp:precise - never fuse a multiply and an add, simd_math.h and the input recordings rely on every build rounding the same
 REM /Zi - produce debug info generations(passes /debug to linker)
 REM /RTC1 - produce extra run-time error checks for variables and arrays on stack
 REM === LINKER OPTIONS ===
@@ -24,11 +25,11 @@ REM /subsystem:windows - create "gui" executable without console attached
 
 IF "%1" == "release" ( 
     echo ===== Building Release Executable =====
-    set CompilerFlags=/nologo /W4 /WX /GS- /MT /Oi /O2 /FC
+    set CompilerFlags=/nologo /W4 /WX /GS- /MT /Oi /O2 /fp:precise /FC
 ) ELSE (
     echo ===== Building Debug Executable =====
     REM /fsanitize=address
-    set CompilerFlags=/nologo /W4 /WX /GS- /MTd /Zi /DDEBUG
+    set CompilerFlags=/nologo /W4 /WX /GS- /MTd /Zi /fp:precise /DDEBUG
 )
 
 set LIBS=kernel32.lib user32.lib ucrt.lib d3d11.lib dxguid.lib dxgi.lib
@@ -0,0 +1,33 @@
+#!/bin/sh
+# Builds the headless Linux platform layer (linux_headless.c).
+#
+# === COMPILER OPTIONS ===
+# -msse4.1 - _mm_floor_ps/_mm_ceil_ps/_mm_round_ps are SSE4.1
+# -O2 - Optimizations
+# -O0 -g - Disable Optimizations, produce debug info
+# -Wall -Werror - Warnings
+# -ffp-contract=off - never fuse a multiply and an add, simd_math.h and the
+#                     input recordings rely on every build rounding the same
+# -pthread - linux_frame_capture.h writes frames on a thread
+#
+# Extra flags come from $CFLAGS, e.g. CFLAGS=-mavx2 ./build.sh release turns
+# on the 8 wide AVX2 paths in simd_math.h
+
+set -e
+
+cd "$(dirname "$0")"
+mkdir -p build
+
+CC=${CC:-cc}
+WARNINGS="-Wall -Werror -Wno-unused-function -Wno-unused-variable -Wno-unused-but-set-variable -Wno-missing-braces"
+
+if [ "$1" = "release" ]; then
+    echo "===== Building Release Executable ====="
+    CompilerFlags="-O2 -msse4.1 -ffp-contract=off $WARNINGS"
+else
+    echo "===== Building Debug Executable ====="
+    CompilerFlags="-O0 -g -msse4.1 -ffp-contract=off -DDEBUG $WARNINGS"
+fi
+
+$CC linux_headless.c $CompilerFlags $CFLAGS -o build/asteroids_headless -lm -pthread
+mv build/asteroids_headless .
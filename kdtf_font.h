@@ -3,11 +3,13 @@
 
 #if _WIN32
 #include <Windows.h>
+#else
+#include <stdio.h>
+#include <stdlib.h>
 #endif
 
-#include "intrin.h"
-
 #include "base.h"
+#include "simd_math.h"
 
 typedef void *(*KDTF_fn_alloc)(u64);
 typedef void (*KDTF_fn_free)(void*);
@@ -31,6 +33,7 @@ typedef struct {
 	i32 character_count;
 	u32 glyph_color;
 	b8 anti_aliasing;
+	i32 glyph_x_offsets[256]; // by character, -1 when it isn't in the atlas
 } KDTF_GlyphAtlas;
 
 typedef struct {
@@ -1417,7 +1420,35 @@ KDTF_Font KDTF_CreateFontFromFile(char *filepath) {
 
 	font_file_bytes = file_contents;
 #else
-Assert(false); // support reading file for platform
+	FILE *file_handle = fopen(filepath, "rb");
+	if (!file_handle) {
+		fprintf(stderr, "KDTF: fopen(%s) failed!\n", filepath);
+		return KDTF_CreateFont(0);
+	}
+
+	fseek(file_handle, 0, SEEK_END);
+	long file_size = ftell(file_handle);
+	fseek(file_handle, 0, SEEK_SET);
+
+	if (file_size <= 0) {
+		fclose(file_handle);
+		fprintf(stderr, "KDTF: File is empty!\n");
+		return KDTF_CreateFont(0);
+	}
+
+	u8 *file_contents = (u8*)malloc(file_size);
+	Assert(file_contents != NULL);
+
+	size_t bytes_read = fread(file_contents, 1, file_size, file_handle);
+	fclose(file_handle);
+
+	if (bytes_read != (size_t)file_size) {
+		fprintf(stderr, "KDTF: Failed to read file!\n");
+		free(file_contents);
+		return KDTF_CreateFont(0);
+	}
+
+	font_file_bytes = file_contents;
 #endif
 
 	return KDTF_CreateFont(font_file_bytes);
@@ -1780,6 +1811,14 @@ void KDTF_FreeGlyphAtlas(KDTF_GlyphAtlas *atlas, KDTF_fn_free free_fn) {
 //  - atlas_memory needs to be glyph height by (glyph advance width * character count)
 //  - calculation_memory needs to be experimented with, not sure how much is going to be needed per font
 void KDTF_InitializeGlyphAtlas(KDTF_GlyphAtlas *atlas, KDTF_Font *font, KDTF_fn_alloc calculations_memory_allocator) {
+	for (i32 i = 0; i < 256; i++) {
+		atlas->glyph_x_offsets[i] = -1;
+	}
+	// the first entry wins if a character is in the set twice
+	for (i32 i = atlas->character_count - 1; i >= 0; i--) {
+		atlas->glyph_x_offsets[(u8)atlas->characters[i]] = i * atlas->glyph_width;
+	}
+
 	i32 x_offset = 0;
 	i32 y_offset = (i32)((f32)(-1 * font->descender) * font->design_units_to_pixels);
 
@@ -1807,15 +1846,7 @@ void KDTF_InitializeGlyphAtlas(KDTF_GlyphAtlas *atlas, KDTF_Font *font, KDTF_fn_
 }
 
 i32 KDTF_GetXOffsetForGlyph(KDTF_GlyphAtlas *atlas, char character) {
-	i32 result = -1;
-	for (i32 i = 0; i < atlas->character_count; i++) {
-		char c = atlas->characters[i];
-		if (c == character) {
-			result = i * atlas->glyph_width;
-			break;
-		}
-	}
-	return result;
+	return atlas->glyph_x_offsets[(u8)character];
 }
 
 KDTF_Font KDTF_AllocateFont(
@@ -1848,21 +1879,34 @@ KDTF_Font KDTF_AllocateFont(
 	return font;
 }
 
-void KDTF_DrawCharacter(KDTF_Font *font, char character, u32 color,
+// Only writes pixels inside [clip_min_x, clip_max_x) x [clip_min_y, clip_max_y),
+// the clip rectangle has to be inside the surface
+void KDTF_DrawCharacterClipped(KDTF_Font *font, char character, u32 color,
 	i32 *xPos, i32 *yPos,
-	u32 *surface, u32 surface_width, u32 surface_height) {
+	u32 *surface, u32 surface_width, u32 surface_height,
+	i32 clip_min_x, i32 clip_min_y, i32 clip_max_x, i32 clip_max_y) {
 
 	KDTF_GlyphAtlas *atlas = &font->atlas;
 
 	if (character == ' ') {
-		// do nothing
+		// nothing to draw, but still take up the space
+		*xPos += font->atlas.glyph_width;
 		return;
 	}
 
+	// rows the glyph covers on the surface, flipped glyphs are drawn upwards from yPos + glyph_height
+	i32 glyph_min_y = font->flip_y ? *yPos + 1 : *yPos;
+	i32 glyph_max_y = glyph_min_y + atlas->glyph_height;
+	i32 min_x = KDTF_Max2i(0, clip_min_x - *xPos);
+	i32 max_x = KDTF_Min2i(atlas->glyph_width, clip_max_x - *xPos);
 	i32 glyph_x_offset = KDTF_GetXOffsetForGlyph(atlas, character);
 	if (glyph_x_offset == -1) {
 		return;
 	}
+	if (min_x >= max_x || glyph_max_y <= clip_min_y || glyph_min_y >= clip_max_y) {
+		*xPos += font->atlas.glyph_width;
+		return;
+	}
 
 	for (i32 y = 0; y < atlas->glyph_height; y++) {
 		i32 source_y = y;
@@ -1872,11 +1916,14 @@ void KDTF_DrawCharacter(KDTF_Font *font, char character, u32 color,
 		} else {
 			dest_y = *yPos + y;
 		}
+		if (dest_y < clip_min_y || dest_y >= clip_max_y) {
+			continue;
+		}
 		
 		u32 *glyph_bitmap_pixels = atlas->pixels + (source_y * atlas->atlas_width);
 		u32 *destination_bitmap_pixels_row = surface + (dest_y * surface_width);
 		
-		for (i32 x = 0; x < atlas->glyph_width; x++) {
+		for (i32 x = min_x; x < max_x; x++) {
 			u32 *glyph_pixels = glyph_bitmap_pixels + x + glyph_x_offset;
 			u32 *destination_pixels = destination_bitmap_pixels_row + x + *xPos;
 
@@ -1889,6 +1936,27 @@ void KDTF_DrawCharacter(KDTF_Font *font, char character, u32 color,
 	*xPos += font->atlas.glyph_width;
 }
 
+void KDTF_DrawCharacter(KDTF_Font *font, char character, u32 color,
+	i32 *xPos, i32 *yPos,
+	u32 *surface, u32 surface_width, u32 surface_height) {
+	KDTF_DrawCharacterClipped(font, character, color, xPos, yPos, surface, surface_width, surface_height,
+		0, 0, (i32)surface_width, (i32)surface_height);
+}
+
+void KDTF_DrawTextClipped(
+	KDTF_Font *font, 
+	char *text, i32 text_length, 
+	u32 color, i32 *xPos, i32 *yPos, 
+	u32 *surface, u32 surface_width, u32 surface_height,
+	i32 clip_min_x, i32 clip_min_y, i32 clip_max_x, i32 clip_max_y) {
+	
+	for (i32 i = 0; i < text_length; i++) {
+		char character = text[i];
+		KDTF_DrawCharacterClipped(font, character, color, xPos, yPos, surface, surface_width, surface_height,
+			clip_min_x, clip_min_y, clip_max_x, clip_max_y);
+	}
+}
+
 void KDTF_DrawText(
 	KDTF_Font *font, 
 	char *text, i32 text_length, 
@@ -1901,14 +1969,16 @@ void KDTF_DrawText(
 	}
 }
 
-void KDTF_DrawNumber(
+void KDTF_DrawNumberClipped(
 	KDTF_Font *font, 
 	i32 number,
 	u32 color, i32 *xPos, i32 *yPos, 
-	u32 *surface, u32 surface_width, u32 surface_height) {
+	u32 *surface, u32 surface_width, u32 surface_height,
+	i32 clip_min_x, i32 clip_min_y, i32 clip_max_x, i32 clip_max_y) {
 	
 	if (number == 0) {
-		KDTF_DrawCharacter(font, '0', color, xPos, yPos, surface, surface_width, surface_height);
+		KDTF_DrawCharacterClipped(font, '0', color, xPos, yPos, surface, surface_width, surface_height,
+			clip_min_x, clip_min_y, clip_max_x, clip_max_y);
 		return;
 	}
 	
@@ -1929,14 +1999,25 @@ void KDTF_DrawNumber(
 		if (tmp > 0) {
 			number -= (tmp * digit_count_to_power_of_ten);
 			char code = (char)(tmp + '0');
-			KDTF_DrawCharacter(font, code, color, xPos, yPos, surface, surface_width, surface_height);
+			KDTF_DrawCharacterClipped(font, code, color, xPos, yPos, surface, surface_width, surface_height,
+				clip_min_x, clip_min_y, clip_max_x, clip_max_y);
 			did_draw_number = true;
 		} else if (tmp == 0 && did_draw_number) {
-			KDTF_DrawCharacter(font, '0', color, xPos, yPos, surface, surface_width, surface_height);
+			KDTF_DrawCharacterClipped(font, '0', color, xPos, yPos, surface, surface_width, surface_height,
+				clip_min_x, clip_min_y, clip_max_x, clip_max_y);
 		}
 
 		digit_count_to_power_of_ten /= 10;
 	}	
 }
 
+void KDTF_DrawNumber(
+	KDTF_Font *font, 
+	i32 number,
+	u32 color, i32 *xPos, i32 *yPos, 
+	u32 *surface, u32 surface_width, u32 surface_height) {
+	KDTF_DrawNumberClipped(font, number, color, xPos, yPos, surface, surface_width, surface_height,
+		0, 0, (i32)surface_width, (i32)surface_height);
+}
+
 #endif
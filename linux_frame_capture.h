@@ -0,0 +1,291 @@
+#ifndef LINUX_FRAME_CAPTURE_H
+#define LINUX_FRAME_CAPTURE_H
+
+// Frame capture on a background writer thread.
+//
+// The game thread copies each finished frame into a free slot of a ring of
+// preallocated frame buffers and moves on. A writer thread takes the frames
+// out in order, converts them if needed and writes them to a file or pipe.
+// The game thread never waits on the writer or on disk I/O: if every slot is
+// still waiting to be written the frame is dropped and counted.
+//
+// Formats:
+//   FrameCaptureFormat_Y4M  - YUV4MPEG2, 4:2:0 full range (C420jpeg), readable
+//                             by ffmpeg, mpv, x264 etc.
+//   FrameCaptureFormat_BGRA - raw frames of width * height * 4 bytes, in
+//                             the same byte order as DrawSurface pixels
+//
+//   FrameCapture capture = {0};
+//   FrameCapture_Open(&capture, "out.y4m", FrameCaptureFormat_Y4M, width, height, 60, 1, 8);
+//   each frame: FrameCapture_Submit(&capture, pixels);
+//   FrameCapture_Close(&capture); // writes out every frame still in the ring
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "base.h"
+
+typedef enum {
+	FrameCaptureFormat_Y4M,
+	FrameCaptureFormat_BGRA,
+} FrameCaptureFormat;
+
+typedef struct {
+	i32 fd;
+	FrameCaptureFormat format;
+	u32 width;
+	u32 height;
+
+	u32 slot_count;
+	u32 **slots; // slot_count frames of width * height pixels
+
+	// single producer (game thread), single consumer (writer thread)
+	// slots [read_index, write_index) hold frames waiting to be written,
+	// both only ever increase and are taken modulo slot_count
+	u64 write_index;
+	u64 read_index;
+	sem_t frames_ready;
+	b8 stop;
+	b8 write_failed;
+
+	u8 *converted; // Y4M planes, only touched by the writer thread
+	u64 converted_size;
+
+	pthread_t writer_thread;
+
+	// written by the game thread
+	u64 frames_submitted;
+	u64 frames_dropped;
+	// written by the writer thread, read after FrameCapture_Close
+	u64 frames_written;
+	u64 bytes_written;
+} FrameCapture;
+
+static b8 FrameCapture_WriteAll(FrameCapture *capture, void *bytes, u64 byte_count) {
+	u8 *at = (u8*)bytes;
+	while (byte_count) {
+		ssize_t written = write(capture->fd, at, byte_count);
+		if (written < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return 0;
+		}
+		at += written;
+		byte_count -= (u64)written;
+		capture->bytes_written += (u64)written;
+	}
+	return 1;
+}
+
+static u8 FrameCapture_ClampByte(i32 value) {
+	return (u8)(value < 0 ? 0 : (value > 255 ? 255 : value));
+}
+
+// BT.601 full range, as in JPEG. Chroma is the average of each 2x2 block,
+// odd widths and heights repeat the last column or row.
+static void FrameCapture_ConvertToY4M(FrameCapture *capture, u32 *pixels) {
+	u32 width = capture->width;
+	u32 height = capture->height;
+	u32 chroma_width = (width + 1) / 2;
+	u32 chroma_height = (height + 1) / 2;
+	u8 *y_plane = capture->converted;
+	u8 *u_plane = y_plane + (u64)width * height;
+	u8 *v_plane = u_plane + (u64)chroma_width * chroma_height;
+
+	for (u32 y = 0; y < height; y++) {
+		u32 *row = pixels + ((u64)y * width);
+		u8 *out = y_plane + ((u64)y * width);
+		for (u32 x = 0; x < width; x++) {
+			u32 pixel = row[x];
+			i32 r = (pixel >> 16) & 0xFF;
+			i32 g = (pixel >> 8) & 0xFF;
+			i32 b = pixel & 0xFF;
+			// fixed point 16.16 weights
+			out[x] = (u8)(((19595 * r) + (38470 * g) + (7471 * b) + 32768) >> 16);
+		}
+	}
+
+	for (u32 cy = 0; cy < chroma_height; cy++) {
+		u32 y0 = cy * 2;
+		u32 y1 = (y0 + 1) < height ? (y0 + 1) : y0;
+		u32 *row0 = pixels + ((u64)y0 * width);
+		u32 *row1 = pixels + ((u64)y1 * width);
+		for (u32 cx = 0; cx < chroma_width; cx++) {
+			u32 x0 = cx * 2;
+			u32 x1 = (x0 + 1) < width ? (x0 + 1) : x0;
+			u32 block[4] = { row0[x0], row0[x1], row1[x0], row1[x1] };
+			i32 r = 0;
+			i32 g = 0;
+			i32 b = 0;
+			for (i32 i = 0; i < 4; i++) {
+				r += (block[i] >> 16) & 0xFF;
+				g += (block[i] >> 8) & 0xFF;
+				b += block[i] & 0xFF;
+			}
+			// sums of 4 pixels, so the weights are divided by 4 as well
+			i32 u = ((-11059 * r) - (21709 * g) + (32768 * b) + (1 << 17)) >> 18;
+			i32 v = ((32768 * r) - (27439 * g) - (5329 * b) + (1 << 17)) >> 18;
+			u_plane[((u64)cy * chroma_width) + cx] = FrameCapture_ClampByte(u + 128);
+			v_plane[((u64)cy * chroma_width) + cx] = FrameCapture_ClampByte(v + 128);
+		}
+	}
+}
+
+static b8 FrameCapture_WriteFrame(FrameCapture *capture, u32 *pixels) {
+	if (capture->format == FrameCaptureFormat_Y4M) {
+		FrameCapture_ConvertToY4M(capture, pixels);
+		char frame_header[] = "FRAME\n";
+		return FrameCapture_WriteAll(capture, frame_header, sizeof(frame_header) - 1) &&
+			FrameCapture_WriteAll(capture, capture->converted, capture->converted_size);
+	}
+	return FrameCapture_WriteAll(capture, pixels, (u64)capture->width * capture->height * sizeof(u32));
+}
+
+static void *FrameCapture_WriterThread(void *parameter) {
+	FrameCapture *capture = (FrameCapture*)parameter;
+	for (;;) {
+		while (sem_wait(&capture->frames_ready) != 0) {
+			// EINTR, try again
+		}
+
+		u64 read_index = capture->read_index;
+		u64 write_index = __atomic_load_n(&capture->write_index, __ATOMIC_ACQUIRE);
+		if (read_index == write_index) {
+			// woken up with nothing left to write, only happens when stopping
+			if (__atomic_load_n(&capture->stop, __ATOMIC_ACQUIRE)) {
+				break;
+			}
+			continue;
+		}
+
+		if (!capture->write_failed) {
+			u32 *pixels = capture->slots[read_index % capture->slot_count];
+			if (FrameCapture_WriteFrame(capture, pixels)) {
+				capture->frames_written += 1;
+			} else {
+				// the file is full or the other end of the pipe went away, keep
+				// draining the ring so the game doesn't notice
+				__atomic_store_n(&capture->write_failed, 1, __ATOMIC_RELEASE);
+			}
+		}
+		__atomic_store_n(&capture->read_index, read_index + 1, __ATOMIC_RELEASE);
+	}
+	return 0;
+}
+
+// path is truncated or created, it can also be a FIFO or /dev/fd/N
+// frames_per_second is frame_rate_numerator / frame_rate_denominator, it
+// only goes into the Y4M header
+// RETURNS: 1 on success
+b8 FrameCapture_Open(FrameCapture *capture, char *path, FrameCaptureFormat format, u32 width, u32 height,
+	u32 frame_rate_numerator, u32 frame_rate_denominator, u32 slot_count) {
+	memset(capture, 0, sizeof(*capture));
+	capture->format = format;
+	capture->width = width;
+	capture->height = height;
+	capture->slot_count = slot_count;
+
+	capture->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (capture->fd < 0) {
+		return 0;
+	}
+	// a closed pipe should fail the write, not kill the game
+	signal(SIGPIPE, SIG_IGN);
+
+	capture->slots = (u32**)calloc(slot_count, sizeof(u32*));
+	if (!capture->slots) {
+		close(capture->fd);
+		return 0;
+	}
+	u64 frame_size = (u64)width * height * sizeof(u32);
+	for (u32 i = 0; i < slot_count; i++) {
+		capture->slots[i] = (u32*)malloc(frame_size);
+		if (!capture->slots[i]) {
+			goto failed;
+		}
+	}
+
+	if (format == FrameCaptureFormat_Y4M) {
+		u64 chroma_size = (u64)((width + 1) / 2) * ((height + 1) / 2);
+		capture->converted_size = ((u64)width * height) + (chroma_size * 2);
+		capture->converted = (u8*)malloc(capture->converted_size);
+		if (!capture->converted) {
+			goto failed;
+		}
+
+		char header[128];
+		i32 header_length = snprintf(header, sizeof(header), "YUV4MPEG2 W%u H%u F%u:%u Ip A1:1 C420jpeg\n",
+			width, height, frame_rate_numerator, frame_rate_denominator);
+		if (!FrameCapture_WriteAll(capture, header, (u64)header_length)) {
+			goto failed;
+		}
+	}
+
+	if (sem_init(&capture->frames_ready, 0, 0) != 0) {
+		goto failed;
+	}
+	if (pthread_create(&capture->writer_thread, 0, FrameCapture_WriterThread, capture) != 0) {
+		sem_destroy(&capture->frames_ready);
+		goto failed;
+	}
+	return 1;
+
+failed:
+	for (u32 i = 0; i < slot_count; i++) {
+		free(capture->slots[i]);
+	}
+	free(capture->slots);
+	free(capture->converted);
+	close(capture->fd);
+	capture->slots = 0;
+	capture->converted = 0;
+	return 0;
+}
+
+// Copies a width * height frame into the ring, never blocks
+// RETURNS: 0 if the frame was dropped because the ring was full
+b8 FrameCapture_Submit(FrameCapture *capture, u32 *pixels) {
+	capture->frames_submitted += 1;
+
+	u64 write_index = capture->write_index;
+	u64 read_index = __atomic_load_n(&capture->read_index, __ATOMIC_ACQUIRE);
+	if ((write_index - read_index) >= capture->slot_count) {
+		capture->frames_dropped += 1;
+		return 0;
+	}
+
+	memcpy(capture->slots[write_index % capture->slot_count], pixels,
+		(u64)capture->width * capture->height * sizeof(u32));
+	__atomic_store_n(&capture->write_index, write_index + 1, __ATOMIC_RELEASE);
+	sem_post(&capture->frames_ready);
+	return 1;
+}
+
+// Waits for the writer thread to write out every submitted frame
+// RETURNS: 1 if every frame that wasn't dropped made it to the file
+b8 FrameCapture_Close(FrameCapture *capture) {
+	__atomic_store_n(&capture->stop, 1, __ATOMIC_RELEASE);
+	sem_post(&capture->frames_ready);
+	pthread_join(capture->writer_thread, 0);
+	sem_destroy(&capture->frames_ready);
+
+	for (u32 i = 0; i < capture->slot_count; i++) {
+		free(capture->slots[i]);
+	}
+	free(capture->slots);
+	free(capture->converted);
+	b8 closed = close(capture->fd) == 0;
+	capture->slots = 0;
+	capture->converted = 0;
+	return closed && !capture->write_failed;
+}
+
+#endif
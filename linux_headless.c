@@ -0,0 +1,2593 @@
+// Headless Linux platform layer.
+//
+// Drives the simulation and the renderer into an offscreen DrawSurface with synthetic input
+// for a fixed number of frames, as fast as possible, and reports frame
+// timings. There is no window, no GPU and no presentation, so this runs on
+// CI machines without a display.
+//
+// Every frame hands the simulation the same --frame-time (milliseconds of
+// game time) instead of the real elapsed time, so a run always does the
+// same number of simulation steps no matter how fast the machine is.
+//
+// Usage: asteroids_headless [--frames N] [--width W] [--height H]
+//                           [--seed S] [--frame-time MS]
+//                           [--verbose] [--overlay] [--fill-ship] [--no-sprites]
+//                           [--record FILE | --replay FILE]
+//                           [--shm NAME]
+//                           [--capture FILE] [--capture-format y4m|bgra]
+//                           [--capture-ring N] [--pipeline]
+//                           [--render-threads N] [--tile-size PX]
+//                           [--meteors N] [--meteor-capacity N]
+//                           [--missile-capacity N] [--meteor-bounce]
+//                           [--full-redraw] [--bench-tiles] [--bench-lines]
+//                           [--bench-circles] [--bench-missiles] [--bench-math]
+//                           [--bench-transform] [--bench-entities]
+//                           [--bench-pools] [--bench-broadphase]
+//                           [--bench-bounce] [--bench-swept] [--bench-points]
+//                           [--bench-ship]
+//
+// --record saves the scripted input as an input recording, --replay runs a
+// recording (from either platform layer) instead of the scripted input. A
+// replay takes its surface size, seed, meteor count, pool sizes and
+// --meteor-bounce from the recording and runs until every recorded step has
+// been simulated.
+// --overlay draws the profile overlay every frame, so its cost is included.
+// --fill-ship draws the ship filled instead of as an outline.
+// --no-sprites rasterizes the ship, missiles and meteors every frame instead
+// of blitting them from the pre-rotated sprite atlas.
+// --shm renders every frame straight into a double buffered shared memory
+// segment (see linux_shared_framebuffer.h) for viewers and capture tools.
+// --capture streams every frame to FILE (or a pipe) on a writer thread (see
+// linux_frame_capture.h). Frames are dropped, not waited for, when all
+// --capture-ring slots are still waiting to be written.
+// --pipeline renders on a second thread, so the simulation of frame N+1 runs
+// while frame N is being drawn. Snapshots go through a triple buffer and the
+// simulation stays at most one frame ahead, so every frame is still drawn.
+// --render-threads draws every frame with the tiled renderer on N threads.
+// --meteors starts the game with N meteors, for stress runs. The meteor pool
+// holds a third more than that unless --meteor-capacity says otherwise, and
+// --missile-capacity sizes the missile pool. Both are made once at startup.
+// --meteor-bounce makes meteors bounce off each other. A replay takes it from
+// the recording.
+// --full-redraw clears and draws the whole surface every frame instead of
+// only the regions that changed since the last frame in the same buffer.
+// --bench-tiles times the tiled renderer on the same frames for 1, 2, 4 ...
+// threads up to the core count and the dirty rectangle renderer, checks every
+// frame is identical to the single threaded renderer and exits.
+// --bench-lines times the line rasterizer against the float one it replaced
+// on random segments, checks its clipping and exits.
+// --bench-circles times the midpoint circle and disc against the trig circle
+// they replaced for a range of radii, checks their clipping and exits.
+// --bench-missiles compares the scanline polygon filler with the missile
+// rasterizer it replaced on random missiles, times both and exits.
+// --bench-math times the batched math in simd_math.h against libm, checks
+// its error and that the batched and scalar versions agree, and exits.
+// --bench-transform times the matrix vertex transform against the per point
+// trig rotation it replaced, checks they agree and exits.
+// --bench-entities times the meteor and missile pools against the arrays of
+// structs they replaced for up to 100k meteors, checks they agree and exits.
+// --bench-pools spawns and despawns meteors in waves in the dense pool and in
+// the slot pool it replaced, times both, checks they agree and exits.
+// --bench-broadphase finds the missile and ship overlaps for up to 100k
+// meteors through the collision grid and by testing every pair, times both,
+// checks they agree and exits.
+// --bench-bounce times meteor bounces for up to 100k meteors, keeping the
+// sweep order from step to step against sorting it every step, checks they
+// agree and exits.
+// --bench-swept times the swept missile test against the point test it
+// replaced for a range of missile speeds, checks it finds every hit the point
+// test does and agrees with its scalar version, and exits.
+// --bench-points checks the squared distance point test against the floored
+// square root it replaced on every squared distance up to 4096 pixels and on
+// random points, times both and exits.
+// --bench-ship checks the ship's triangle against meteors crossing it at
+// random, against the distance to the triangle in doubles, times it against
+// the corner test it replaced and exits.
+
+#include "asteroids.c"
+#include "linux_shared_framebuffer.h"
+#include "linux_frame_capture.h"
+
+#define HEADLESS_DEFAULT_FRAME_COUNT 10000
+#define HEADLESS_DEFAULT_FRAME_TIME_MS (1000.0f / 60.0f)
+#define HEADLESS_DEFAULT_CAPTURE_SLOTS 8
+
+typedef struct {
+	i32 frame_count;
+	i32 width;
+	i32 height;
+	u32 seed;
+	f32 frame_time_ms;
+	b8 verbose;
+	b8 overlay;
+	b8 fill_ship;
+	b8 no_sprites;
+	char *record_path;
+	char *replay_path;
+	char *shm_name;
+	char *capture_path;
+	FrameCaptureFormat capture_format;
+	i32 capture_slots;
+	b8 pipeline;
+	i32 render_threads; // 0 draws without tiles
+	i32 tile_size;
+	i32 meteor_count; // at the start of the game
+	i32 meteor_capacity; // 0 makes room for meteor_count and their splits
+	i32 missile_capacity;
+	b8 meteor_bounce;
+	b8 full_redraw;
+	b8 bench_tiles;
+	b8 bench_lines;
+	b8 bench_circles;
+	b8 bench_missiles;
+	b8 bench_math;
+	b8 bench_transform;
+	b8 bench_entities;
+	b8 bench_pools;
+	b8 bench_broadphase;
+	b8 bench_bounce;
+	b8 bench_swept;
+	b8 bench_points;
+	b8 bench_ship;
+} Linux_HeadlessOptions;
+
+// Where a rendered frame goes
+typedef struct {
+	DrawSurface surface;
+	SharedFramebuffer *shared_framebuffer; // 0 unless --shm
+	FrameCapture *capture; // 0 unless --capture
+	JobSystem *jobs; // 0 unless --render-threads
+	RenderTileBins tile_bins;
+	i32 tile_size;
+	// one per shared framebuffer buffer, the offscreen surface only uses the first
+	DirtyTracker dirty[SHARED_FRAMEBUFFER_BUFFER_COUNT];
+	b8 full_redraw;
+} Linux_FrameOutput;
+
+typedef struct {
+	RenderSnapshotBuffer snapshots;
+	sem_t snapshot_published; // posted by the simulation thread for every snapshot
+	sem_t snapshot_acquired; // posted by the render thread when it takes one
+	b8 stop;
+	Linux_FrameOutput *output;
+	pthread_t thread;
+	u64 frames_rendered;
+} Linux_RenderThread;
+
+static u64 Linux_GetNanoseconds(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((u64)ts.tv_sec * 1000000000ull) + (u64)ts.tv_nsec;
+}
+
+static b8 Linux_ParseOptions(i32 argc, char **argv, Linux_HeadlessOptions *options) {
+	for (i32 i = 1; i < argc; i++) {
+		char *arg = argv[i];
+		b8 has_value = (i + 1) < argc;
+		if (strcmp(arg, "--frames") == 0 && has_value) {
+			options->frame_count = atoi(argv[++i]);
+		} else if (strcmp(arg, "--width") == 0 && has_value) {
+			options->width = atoi(argv[++i]);
+		} else if (strcmp(arg, "--height") == 0 && has_value) {
+			options->height = atoi(argv[++i]);
+		} else if (strcmp(arg, "--seed") == 0 && has_value) {
+			options->seed = (u32)strtoul(argv[++i], 0, 10);
+		} else if (strcmp(arg, "--frame-time") == 0 && has_value) {
+			options->frame_time_ms = (f32)atof(argv[++i]);
+		} else if (strcmp(arg, "--record") == 0 && has_value) {
+			options->record_path = argv[++i];
+		} else if (strcmp(arg, "--replay") == 0 && has_value) {
+			options->replay_path = argv[++i];
+		} else if (strcmp(arg, "--shm") == 0 && has_value) {
+			options->shm_name = argv[++i];
+		} else if (strcmp(arg, "--capture") == 0 && has_value) {
+			options->capture_path = argv[++i];
+		} else if (strcmp(arg, "--capture-format") == 0 && has_value) {
+			char *format = argv[++i];
+			if (strcmp(format, "y4m") == 0) {
+				options->capture_format = FrameCaptureFormat_Y4M;
+			} else if (strcmp(format, "bgra") == 0) {
+				options->capture_format = FrameCaptureFormat_BGRA;
+			} else {
+				fprintf(stderr, "Unknown capture format: %s\n", format);
+				return 0;
+			}
+		} else if (strcmp(arg, "--capture-ring") == 0 && has_value) {
+			options->capture_slots = atoi(argv[++i]);
+		} else if (strcmp(arg, "--verbose") == 0) {
+			options->verbose = 1;
+		} else if (strcmp(arg, "--overlay") == 0) {
+			options->overlay = 1;
+		} else if (strcmp(arg, "--fill-ship") == 0) {
+			options->fill_ship = 1;
+		} else if (strcmp(arg, "--no-sprites") == 0) {
+			options->no_sprites = 1;
+		} else if (strcmp(arg, "--pipeline") == 0) {
+			options->pipeline = 1;
+		} else if (strcmp(arg, "--render-threads") == 0 && has_value) {
+			options->render_threads = atoi(argv[++i]);
+		} else if (strcmp(arg, "--tile-size") == 0 && has_value) {
+			options->tile_size = atoi(argv[++i]);
+		} else if (strcmp(arg, "--meteors") == 0 && has_value) {
+			options->meteor_count = atoi(argv[++i]);
+		} else if (strcmp(arg, "--meteor-capacity") == 0 && has_value) {
+			options->meteor_capacity = atoi(argv[++i]);
+		} else if (strcmp(arg, "--missile-capacity") == 0 && has_value) {
+			options->missile_capacity = atoi(argv[++i]);
+		} else if (strcmp(arg, "--meteor-bounce") == 0) {
+			options->meteor_bounce = 1;
+		} else if (strcmp(arg, "--full-redraw") == 0) {
+			options->full_redraw = 1;
+		} else if (strcmp(arg, "--bench-tiles") == 0) {
+			options->bench_tiles = 1;
+		} else if (strcmp(arg, "--bench-lines") == 0) {
+			options->bench_lines = 1;
+		} else if (strcmp(arg, "--bench-circles") == 0) {
+			options->bench_circles = 1;
+		} else if (strcmp(arg, "--bench-missiles") == 0) {
+			options->bench_missiles = 1;
+		} else if (strcmp(arg, "--bench-math") == 0) {
+			options->bench_math = 1;
+		} else if (strcmp(arg, "--bench-transform") == 0) {
+			options->bench_transform = 1;
+		} else if (strcmp(arg, "--bench-entities") == 0) {
+			options->bench_entities = 1;
+		} else if (strcmp(arg, "--bench-pools") == 0) {
+			options->bench_pools = 1;
+		} else if (strcmp(arg, "--bench-broadphase") == 0) {
+			options->bench_broadphase = 1;
+		} else if (strcmp(arg, "--bench-bounce") == 0) {
+			options->bench_bounce = 1;
+		} else if (strcmp(arg, "--bench-swept") == 0) {
+			options->bench_swept = 1;
+		} else if (strcmp(arg, "--bench-points") == 0) {
+			options->bench_points = 1;
+		} else if (strcmp(arg, "--bench-ship") == 0) {
+			options->bench_ship = 1;
+		} else {
+			fprintf(stderr, "Unknown or incomplete argument: %s\n", arg);
+			return 0;
+		}
+	}
+
+	if (options->frame_count <= 0 || options->width <= 0 || options->height <= 0 || options->frame_time_ms <= 0.0f) {
+		fprintf(stderr, "--frames, --width, --height and --frame-time must be positive\n");
+		return 0;
+	}
+
+	if (options->render_threads < 0 || options->tile_size <= 0) {
+		fprintf(stderr, "--render-threads can't be negative and --tile-size must be positive\n");
+		return 0;
+	}
+
+	if (options->capture_slots <= 0) {
+		fprintf(stderr, "--capture-ring must be positive\n");
+		return 0;
+	}
+
+	if (options->record_path && options->replay_path) {
+		fprintf(stderr, "--record and --replay can't be used together\n");
+		return 0;
+	}
+
+	return 1;
+}
+
+static b8 Linux_ReadEntireFile(char *filepath, void **out_bytes, u64 *out_byte_count) {
+	FILE *file = fopen(filepath, "rb");
+	if (!file) {
+		fprintf(stderr, "fopen(%s) failed!\n", filepath);
+		return 0;
+	}
+
+	fseek(file, 0, SEEK_END);
+	long file_size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	if (file_size <= 0) {
+		fclose(file);
+		fprintf(stderr, "%s is empty!\n", filepath);
+		return 0;
+	}
+
+	void *bytes = MyAlloc((u64)file_size);
+	size_t bytes_read = fread(bytes, 1, (size_t)file_size, file);
+	fclose(file);
+	if (bytes_read != (size_t)file_size) {
+		fprintf(stderr, "Failed to read %s!\n", filepath);
+		MyFree(bytes);
+		return 0;
+	}
+
+	*out_bytes = bytes;
+	*out_byte_count = (u64)file_size;
+	return 1;
+}
+
+static b8 Linux_WriteEntireFile(char *filepath, void *bytes, u64 byte_count) {
+	FILE *file = fopen(filepath, "wb");
+	if (!file) {
+		fprintf(stderr, "fopen(%s) failed!\n", filepath);
+		return 0;
+	}
+
+	size_t bytes_written = fwrite(bytes, 1, (size_t)byte_count, file);
+	fclose(file);
+	if (bytes_written != (size_t)byte_count) {
+		fprintf(stderr, "Failed to write %s!\n", filepath);
+		return 0;
+	}
+	return 1;
+}
+
+// Scripted input so every run exercises rotation, thrust and firing the same way
+static void Linux_SynthesizeInput(i32 frame_index) {
+	i32 phase = frame_index % 600;
+	gRotateShipLeft = phase < 150;
+	gRotateShipRight = phase >= 300 && phase < 400;
+	gMoveShipForward = (phase >= 100 && phase < 250) || phase >= 450;
+	if ((frame_index % 20) == 0) {
+		gShootMissile = 1;
+	}
+}
+
+// FNV-1a over the last frame, equal checksums mean a replay reproduced the run
+static u32 Linux_ChecksumSurface(DrawSurface *surface) {
+	u32 hash = 2166136261u;
+	u64 pixel_count = (u64)surface->width * surface->height;
+	for (u64 i = 0; i < pixel_count; i++) {
+		hash ^= surface->pixels[i];
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+static void Linux_RenderFrame(Linux_FrameOutput *output, RenderCommandBuffer *snapshot) {
+	DirtyTracker *dirty = output->full_redraw ? 0 : output->dirty;
+	if (output->shared_framebuffer) {
+		// the back buffer still holds the frame before last
+		if (dirty) {
+			dirty += output->shared_framebuffer->back_buffer;
+		}
+		output->surface.pixels = SharedFramebuffer_BeginFrame(output->shared_framebuffer);
+	}
+	if (output->jobs) {
+		ExecuteRenderCommandsTiled(&output->surface, snapshot, output->jobs, &output->tile_bins, output->tile_size, dirty);
+	} else if (dirty) {
+		ExecuteRenderCommandsDirty(&output->surface, snapshot, dirty);
+	} else {
+		ExecuteRenderCommands(&output->surface, snapshot);
+	}
+	if (output->shared_framebuffer) {
+		SharedFramebuffer_PublishFrame(output->shared_framebuffer);
+	}
+	if (output->capture) {
+		FrameCapture_Submit(output->capture, output->surface.pixels);
+	}
+}
+
+static void *Linux_RenderThreadProc(void *parameter) {
+	Linux_RenderThread *render_thread = (Linux_RenderThread*)parameter;
+	for (;;) {
+		while (sem_wait(&render_thread->snapshot_published) != 0) {
+			// EINTR, try again
+		}
+		if (!RenderSnapshotBuffer_HasNew(&render_thread->snapshots)) {
+			if (__atomic_load_n(&render_thread->stop, __ATOMIC_ACQUIRE)) {
+				break;
+			}
+			continue;
+		}
+
+		RenderCommandBuffer *snapshot = RenderSnapshotBuffer_AcquireLatest(&render_thread->snapshots);
+		sem_post(&render_thread->snapshot_acquired);
+		Linux_RenderFrame(render_thread->output, snapshot);
+		render_thread->frames_rendered += 1;
+	}
+	return 0;
+}
+
+static b8 Linux_StartRenderThread(Linux_RenderThread *render_thread, Linux_FrameOutput *output) {
+	if (!RenderSnapshotBuffer_Init(&render_thread->snapshots)) {
+		return 0;
+	}
+	render_thread->output = output;
+	if (sem_init(&render_thread->snapshot_published, 0, 0) != 0) {
+		return 0;
+	}
+	if (sem_init(&render_thread->snapshot_acquired, 0, 0) != 0) {
+		sem_destroy(&render_thread->snapshot_published);
+		return 0;
+	}
+	if (pthread_create(&render_thread->thread, 0, Linux_RenderThreadProc, render_thread) != 0) {
+		sem_destroy(&render_thread->snapshot_published);
+		sem_destroy(&render_thread->snapshot_acquired);
+		return 0;
+	}
+	return 1;
+}
+
+// Called by the simulation thread after the simulation steps of a frame
+static void Linux_PublishSnapshot(Linux_RenderThread *render_thread, f32 alpha, b8 first_frame) {
+	// the triple buffer never makes the simulation wait, but without this the
+	// simulation would run ahead and the renderer would skip frames
+	if (!first_frame) {
+		while (sem_wait(&render_thread->snapshot_acquired) != 0) {
+			// EINTR, try again
+		}
+	}
+	BuildRenderCommands(RenderSnapshotBuffer_BeginWrite(&render_thread->snapshots), alpha,
+		render_thread->output->surface.width, render_thread->output->surface.height);
+	RenderSnapshotBuffer_Publish(&render_thread->snapshots);
+	sem_post(&render_thread->snapshot_published);
+}
+
+// Waits for the last published snapshot to be drawn
+static void Linux_StopRenderThread(Linux_RenderThread *render_thread) {
+	__atomic_store_n(&render_thread->stop, 1, __ATOMIC_RELEASE);
+	sem_post(&render_thread->snapshot_published);
+	pthread_join(render_thread->thread, 0);
+	sem_destroy(&render_thread->snapshot_published);
+	sem_destroy(&render_thread->snapshot_acquired);
+}
+
+// Times ExecuteRenderCommandsTiled for 1, 2, 4 ... threads up to the core
+// count on the same frames, and checks every frame against ExecuteRenderCommands
+static b8 Linux_BenchmarkTiles(Linux_HeadlessOptions *options) {
+	i32 processor_count = Platform_ProcessorCount();
+	i32 thread_counts[JOB_SYSTEM_MAX_WORKERS + 1] = {0};
+	i32 thread_count_count = 0;
+	thread_counts[thread_count_count++] = 1;
+	for (i32 threads = 2; threads < processor_count; threads *= 2) {
+		thread_counts[thread_count_count++] = threads;
+	}
+	thread_counts[thread_count_count++] = Max2(processor_count, 2);
+
+	u64 pixel_count = (u64)options->width * options->height;
+	u32 *reference_pixels = (u32*)MyAlloc(pixel_count * sizeof(u32));
+	u32 *tiled_pixels = (u32*)MyAlloc(pixel_count * sizeof(u32));
+	u32 *dirty_pixels = (u32*)MyAlloc(pixel_count * sizeof(u32));
+	if (!reference_pixels || !tiled_pixels || !dirty_pixels) {
+		fprintf(stderr, "Failed to allocate the draw surfaces!\n");
+		return 0;
+	}
+	DrawSurface reference = MakeDrawSurface(reference_pixels, options->width, options->height);
+	DrawSurface tiled = MakeDrawSurface(tiled_pixels, options->width, options->height);
+	RenderTileBins tile_bins = {0};
+	DrawSurface dirty_surface = MakeDrawSurface(dirty_pixels, options->width, options->height);
+	DirtyTracker dirty = {0};
+	static RenderCommandBuffer commands;
+	if (!RenderCommandBuffer_Register(&commands)) {
+		fprintf(stderr, "Failed to register the command buffer!\n");
+		return 0;
+	}
+
+	printf("tiled renderer: %d frames, %dx%d, %dpx tiles, %d cores\n", options->frame_count,
+		options->width, options->height, options->tile_size, processor_count);
+	printf("  threads  ms/frame  speedup  identical\n");
+
+	b8 all_identical = 1;
+	f64 untiled_ms = 0.0;
+	for (i32 i = 0; i < thread_count_count; i++) {
+		if (!JobSystem_Start(&gJobs, thread_counts[i] - 1)) {
+			fprintf(stderr, "Failed to start %d threads!\n", thread_counts[i]);
+			return 0;
+		}
+
+		// the first pass also times the dirty rectangle renderer, without threads
+		b8 dirty_pass = i == 0;
+		InputRecording_BeginSession(options->seed);
+		u64 untiled_ns = 0;
+		u64 tiled_ns = 0;
+		u64 dirty_ns = 0;
+		b8 identical = 1;
+		b8 dirty_identical = 1;
+		for (i32 frame = 0; frame < options->frame_count; frame++) {
+			Linux_SynthesizeInput(frame);
+			f32 alpha = SimulateFrame(options->frame_time_ms / 1000.0f, options->width, options->height);
+			BuildRenderCommands(&commands, alpha, options->width, options->height);
+
+			u64 begin = Linux_GetNanoseconds();
+			ExecuteRenderCommands(&reference, &commands);
+			u64 middle = Linux_GetNanoseconds();
+			ExecuteRenderCommandsTiled(&tiled, &commands, &gJobs, &tile_bins, options->tile_size, 0);
+			u64 end = Linux_GetNanoseconds();
+
+			untiled_ns += middle - begin;
+			tiled_ns += end - middle;
+			if (memcmp(reference_pixels, tiled_pixels, pixel_count * sizeof(u32)) != 0) {
+				identical = 0;
+			}
+
+			if (dirty_pass) {
+				begin = Linux_GetNanoseconds();
+				ExecuteRenderCommandsDirty(&dirty_surface, &commands, &dirty);
+				dirty_ns += Linux_GetNanoseconds() - begin;
+				if (memcmp(reference_pixels, dirty_pixels, pixel_count * sizeof(u32)) != 0) {
+					dirty_identical = 0;
+				}
+			}
+		}
+		JobSystem_Stop(&gJobs);
+
+		f64 tiled_ms = ((f64)tiled_ns / options->frame_count) / 1e6;
+		if (i == 0) {
+			untiled_ms = ((f64)untiled_ns / options->frame_count) / 1e6;
+			printf("  untiled  %8.3f    1.00x\n", untiled_ms);
+			f64 dirty_ms = ((f64)dirty_ns / options->frame_count) / 1e6;
+			printf("    dirty  %8.3f  %6.2fx  %s  (%.1f%% of pixels redrawn)\n", dirty_ms, untiled_ms / dirty_ms,
+				dirty_identical ? "yes" : "NO",
+				(100.0 * dirty.pixels_redrawn) / ((f64)dirty.frames * pixel_count));
+			all_identical = all_identical && dirty_identical;
+		}
+		printf("  %7d  %8.3f  %6.2fx  %s\n", thread_counts[i], tiled_ms, untiled_ms / tiled_ms,
+			identical ? "yes" : "NO");
+		all_identical = all_identical && identical;
+	}
+
+	RenderTileBins_Free(&tile_bins);
+	DirtyTracker_Free(&dirty);
+	MyFree(reference_pixels);
+	MyFree(tiled_pixels);
+	MyFree(dirty_pixels);
+	return all_identical;
+}
+
+// The float DrawLine that DrawLinePixels replaced, only kept so
+// --bench-lines has something to compare against
+static void Linux_DrawLineFloat(DrawSurface *surface, Point p1, Point p2, u32 color) {
+	f32 min_x = my_min(p2.x, p1.x);
+	f32 max_x = my_max(p2.x, p1.x);
+	f32 min_y = my_min(p2.y, p1.y);
+	f32 max_y = my_max(p2.y, p1.y);
+
+	if (p1.x == p2.x) {
+		i32 x = RoundNearest(p1.x);
+		for (i32 y = my_floor(min_y); y < my_ceil(max_y); y++) {
+			if (y <= 0 || y < surface->clip_min_y || y >= surface->clip_max_y ||
+				x < surface->clip_min_x || x >= surface->clip_max_x) {
+				continue;
+			}
+			surface->pixels[x + (y * surface->width)] = color;
+		}
+	} else if (p1.y == p2.y) {
+		i32 y = RoundNearest(p2.y);
+		for (i32 x = RoundNearest(min_x); x <= RoundNearest(max_x); x++) {
+			if (x < surface->clip_min_x || x >= surface->clip_max_x ||
+				y < surface->clip_min_y || y >= surface->clip_max_y) {
+				continue;
+			}
+			surface->pixels[x + (y * surface->width)] = color;
+		}
+	} else {
+		f32 m = (p1.y - p2.y) / (p1.x - p2.x);
+		f32 b = p2.y - m * p2.x;
+		f32 height = (f32)surface->height;
+		for (f32 y = min_y; y <= max_y; y += 1.0f) {
+			f32 x = (y - b) / m;
+			if (x < min_x || x > max_x) {
+				continue;
+			}
+			i32 actual_x = RoundNearest(x);
+			i32 actual_y = RoundNearest(y < 0.0f ? 0.0f : (y > height ? height : y));
+			if (actual_x < surface->clip_min_x || actual_x >= surface->clip_max_x ||
+				actual_y < surface->clip_min_y || actual_y >= surface->clip_max_y) {
+				continue;
+			}
+			surface->pixels[actual_x + (actual_y * surface->width)] = color;
+		}
+		for (f32 x = min_x; x <= max_x; x += 1.0f) {
+			f32 y = (m * x) + b;
+			if (y < min_y || y > max_y) {
+				continue;
+			}
+			i32 actual_x = RoundNearest(x);
+			i32 actual_y = RoundNearest(y < 0.0f ? 0.0f : (y > height ? height : y));
+			if (actual_x < surface->clip_min_x || actual_x >= surface->clip_max_x ||
+				actual_y < surface->clip_min_y || actual_y >= surface->clip_max_y) {
+				continue;
+			}
+			surface->pixels[actual_x + (actual_y * surface->width)] = color;
+		}
+	}
+}
+
+#define LINE_BENCH_SEGMENT_COUNT 20000
+#define LINE_BENCH_CHECKED_SEGMENT_COUNT 500 // each check redraws whole surfaces
+
+// Times DrawLine against the float line it replaced on random segments, a
+// quarter of the surface past every edge so most of them need clipping.
+// Then checks clipping: every segment drawn with a clip rectangle has to
+// match the same segment drawn on a bigger surface without one, and tiles
+// have to add up to the whole surface.
+static b8 Linux_BenchmarkLines(Linux_HeadlessOptions *options) {
+	i32 width = options->width;
+	i32 height = options->height;
+	i32 margin = (Max2(width, height) / 4) + 1;
+	i32 padded_width = width + (2 * margin);
+	i32 padded_height = height + (2 * margin);
+	u64 pixel_count = (u64)width * height;
+	u64 padded_pixel_count = (u64)padded_width * padded_height;
+
+	Point *segments = (Point*)MyAlloc(LINE_BENCH_SEGMENT_COUNT * 2 * sizeof(Point));
+	u32 *pixels = (u32*)MyAlloc(pixel_count * sizeof(u32));
+	u32 *tiled_pixels = (u32*)MyAlloc(pixel_count * sizeof(u32));
+	u32 *unclipped_pixels = (u32*)MyAlloc(padded_pixel_count * sizeof(u32));
+	u32 *clipped_pixels = (u32*)MyAlloc(padded_pixel_count * sizeof(u32));
+	if (!segments || !pixels || !tiled_pixels || !unclipped_pixels || !clipped_pixels) {
+		fprintf(stderr, "Failed to allocate the line benchmark!\n");
+		return 0;
+	}
+
+	SeedRandom(options->seed);
+	for (i32 i = 0; i < LINE_BENCH_SEGMENT_COUNT * 2; i++) {
+		// sub pixel end points, with some exactly horizontal and vertical lines
+		segments[i].x = (f32)GenerateRandomNumber(-margin * 8, (width + margin) * 8) / 8.0f;
+		segments[i].y = (f32)GenerateRandomNumber(-margin * 8, (height + margin) * 8) / 8.0f;
+		if ((i & 1) && GenerateRandomNumber(0, 9) == 0) {
+			segments[i].x = segments[i - 1].x;
+		} else if ((i & 1) && GenerateRandomNumber(0, 9) == 0) {
+			segments[i].y = segments[i - 1].y;
+		}
+	}
+
+	DrawSurface surface = MakeDrawSurface(pixels, width, height);
+	i32 passes = Max2(options->frame_count / 100, 1);
+	u64 float_ns = 0;
+	u64 integer_ns = 0;
+	for (i32 pass = 0; pass < passes; pass++) {
+		u64 begin = Linux_GetNanoseconds();
+		for (i32 i = 0; i < LINE_BENCH_SEGMENT_COUNT; i++) {
+			Linux_DrawLineFloat(&surface, segments[i * 2], segments[(i * 2) + 1], (u32)i);
+		}
+		u64 middle = Linux_GetNanoseconds();
+		for (i32 i = 0; i < LINE_BENCH_SEGMENT_COUNT; i++) {
+			DrawLine(&surface, segments[i * 2], segments[(i * 2) + 1], (u32)i);
+		}
+		u64 end = Linux_GetNanoseconds();
+		float_ns += middle - begin;
+		integer_ns += end - middle;
+	}
+
+	// clipped against the surface and against tiles, same pixels as unclipped
+	b8 clipped_identical = 1;
+	DrawSurface unclipped = MakeDrawSurface(unclipped_pixels, padded_width, padded_height);
+	DrawSurface clipped = MakeDrawSurface(clipped_pixels, padded_width, padded_height);
+	clipped.clip_min_x = margin;
+	clipped.clip_min_y = margin;
+	clipped.clip_max_x = margin + width;
+	clipped.clip_max_y = margin + height;
+	for (i32 i = 0; i < LINE_BENCH_CHECKED_SEGMENT_COUNT && clipped_identical; i++) {
+		Point p1 = segments[i * 2];
+		Point p2 = segments[(i * 2) + 1];
+		Point padded_p1 = { p1.x + margin, p1.y + margin };
+		Point padded_p2 = { p2.x + margin, p2.y + margin };
+		memset(unclipped_pixels, 0, padded_pixel_count * sizeof(u32));
+		memset(clipped_pixels, 0, padded_pixel_count * sizeof(u32));
+		DrawLine(&unclipped, padded_p1, padded_p2, 0xFFFFFFFF);
+		DrawLine(&clipped, padded_p1, padded_p2, 0xFFFFFFFF);
+		for (i32 y = 0; y < padded_height && clipped_identical; y++) {
+			for (i32 x = 0; x < padded_width; x++) {
+				b8 inside = x >= margin && x < margin + width && y >= margin && y < margin + height;
+				u32 expected = inside ? unclipped_pixels[x + (y * padded_width)] : 0;
+				if (clipped_pixels[x + (y * padded_width)] != expected) {
+					clipped_identical = 0;
+					break;
+				}
+			}
+		}
+
+		DrawSurface tiled = MakeDrawSurface(tiled_pixels, width, height);
+		memset(pixels, 0, pixel_count * sizeof(u32));
+		memset(tiled_pixels, 0, pixel_count * sizeof(u32));
+		DrawLine(&surface, p1, p2, 0xFFFFFFFF);
+		for (i32 tile_y = 0; tile_y < height; tile_y += options->tile_size) {
+			for (i32 tile_x = 0; tile_x < width; tile_x += options->tile_size) {
+				tiled.clip_min_x = tile_x;
+				tiled.clip_min_y = tile_y;
+				tiled.clip_max_x = Min2(tile_x + options->tile_size, width);
+				tiled.clip_max_y = Min2(tile_y + options->tile_size, height);
+				DrawLine(&tiled, p1, p2, 0xFFFFFFFF);
+			}
+		}
+		if (memcmp(pixels, tiled_pixels, pixel_count * sizeof(u32)) != 0) {
+			clipped_identical = 0;
+		}
+	}
+
+	f64 segment_count = (f64)LINE_BENCH_SEGMENT_COUNT * passes;
+	f64 float_segment_ns = (f64)float_ns / segment_count;
+	f64 integer_segment_ns = (f64)integer_ns / segment_count;
+	printf("line rasterizer: %d random segments x %d passes, %dx%d, %dpx past every edge\n",
+		LINE_BENCH_SEGMENT_COUNT, passes, width, height, margin);
+	printf("  float    %8.1f ns/segment\n", float_segment_ns);
+	printf("  integer  %8.1f ns/segment  %.2fx\n", integer_segment_ns, float_segment_ns / integer_segment_ns);
+	printf("  clipping matches unclipped lines and %dpx tiles: %s (first %d segments)\n", options->tile_size,
+		clipped_identical ? "yes" : "NO", LINE_BENCH_CHECKED_SEGMENT_COUNT);
+
+	MyFree(segments);
+	MyFree(pixels);
+	MyFree(tiled_pixels);
+	MyFree(unclipped_pixels);
+	MyFree(clipped_pixels);
+	return clipped_identical;
+}
+
+// The trig DrawCircle that the midpoint circle replaced, only kept so
+// --bench-circles has something to compare against
+static void Linux_DrawCircleTrig(DrawSurface *surface, i32 radius, f32 pos_x, f32 pos_y, u32 color) {
+	if (!OverlapsClip(surface, my_floor(pos_x) - radius - 1, my_floor(pos_y) - radius - 1,
+		my_ceil(pos_x) + radius + 1, my_ceil(pos_y) + radius + 1)) {
+		return;
+	}
+	for (f32 angle = 0; angle <= 2 * PI; angle += 0.01f) {
+		i32 x = my_ceil(pos_x + (radius * my_cos(angle)));
+		i32 y = my_ceil(pos_y + (radius * my_sin(angle)));
+		if (x < surface->clip_min_x || x >= surface->clip_max_x || y < surface->clip_min_y || y >= surface->clip_max_y) {
+			continue;
+		}
+		surface->pixels[x + (y * surface->width)] = color;
+	}
+}
+
+#define CIRCLE_BENCH_CIRCLE_COUNT 2000
+
+typedef void Linux_CircleFunction(DrawSurface *surface, i32 radius, f32 pos_x, f32 pos_y, u32 color);
+
+static u64 Linux_TimeCircles(Linux_CircleFunction *draw, DrawSurface *surface, Point *centers, i32 radius, i32 passes) {
+	u64 begin = Linux_GetNanoseconds();
+	for (i32 pass = 0; pass < passes; pass++) {
+		for (i32 i = 0; i < CIRCLE_BENCH_CIRCLE_COUNT; i++) {
+			draw(surface, radius, centers[i].x, centers[i].y, (u32)i);
+		}
+	}
+	return Linux_GetNanoseconds() - begin;
+}
+
+// RETURNS: 1 if drawing tile by tile gives the same pixels as drawing the whole surface at once
+static b8 Linux_CircleMatchesTiles(Linux_CircleFunction *draw, DrawSurface *surface, DrawSurface *tiled,
+	i32 tile_size, i32 radius, Point center) {
+	u64 pixel_count = (u64)surface->width * surface->height;
+	memset(surface->pixels, 0, pixel_count * sizeof(u32));
+	memset(tiled->pixels, 0, pixel_count * sizeof(u32));
+	draw(surface, radius, center.x, center.y, 0xFFFFFFFF);
+	for (i32 tile_y = 0; tile_y < surface->height; tile_y += tile_size) {
+		for (i32 tile_x = 0; tile_x < surface->width; tile_x += tile_size) {
+			tiled->clip_min_x = tile_x;
+			tiled->clip_min_y = tile_y;
+			tiled->clip_max_x = Min2(tile_x + tile_size, surface->width);
+			tiled->clip_max_y = Min2(tile_y + tile_size, surface->height);
+			draw(tiled, radius, center.x, center.y, 0xFFFFFFFF);
+		}
+	}
+	return memcmp(surface->pixels, tiled->pixels, pixel_count * sizeof(u32)) == 0;
+}
+
+// Times the trig circle, the midpoint circle and the filled disc per circle
+// for a range of radii, on random centers including partly off screen ones.
+// Checks that circles and discs come out the same drawn tile by tile, and
+// that every circle pixel is inside the disc of the same radius.
+static b8 Linux_BenchmarkCircles(Linux_HeadlessOptions *options) {
+	i32 radii[] = { 2, 4, 8, 16, 32, 64, 128, 256 };
+	i32 width = options->width;
+	i32 height = options->height;
+	u64 pixel_count = (u64)width * height;
+
+	Point *centers = (Point*)MyAlloc(CIRCLE_BENCH_CIRCLE_COUNT * sizeof(Point));
+	u32 *pixels = (u32*)MyAlloc(pixel_count * sizeof(u32));
+	u32 *tiled_pixels = (u32*)MyAlloc(pixel_count * sizeof(u32));
+	if (!centers || !pixels || !tiled_pixels) {
+		fprintf(stderr, "Failed to allocate the circle benchmark!\n");
+		return 0;
+	}
+	DrawSurface surface = MakeDrawSurface(pixels, width, height);
+	DrawSurface tiled = MakeDrawSurface(tiled_pixels, width, height);
+	i32 passes = Max2(options->frame_count / 100, 1);
+
+	printf("circle rasterizer: %d random circles x %d passes, %dx%d\n", CIRCLE_BENCH_CIRCLE_COUNT, passes, width, height);
+	printf("  radius  trig ns  midpoint ns  speedup  disc ns  tiles match\n");
+	b8 all_correct = 1;
+	for (i32 r = 0; r < (i32)(sizeof(radii) / sizeof(radii[0])); r++) {
+		i32 radius = radii[r];
+		SeedRandom(options->seed + (u32)radius);
+		for (i32 i = 0; i < CIRCLE_BENCH_CIRCLE_COUNT; i++) {
+			centers[i].x = (f32)GenerateRandomNumber(-radius * 8, (width + radius) * 8) / 8.0f;
+			centers[i].y = (f32)GenerateRandomNumber(-radius * 8, (height + radius) * 8) / 8.0f;
+		}
+
+		f64 circle_count = (f64)CIRCLE_BENCH_CIRCLE_COUNT * passes;
+		f64 trig_ns = (f64)Linux_TimeCircles(Linux_DrawCircleTrig, &surface, centers, radius, passes) / circle_count;
+		f64 midpoint_ns = (f64)Linux_TimeCircles(DrawCircle, &surface, centers, radius, passes) / circle_count;
+		f64 disc_ns = (f64)Linux_TimeCircles(DrawDisc, &surface, centers, radius, passes) / circle_count;
+
+		b8 correct = 1;
+		for (i32 i = 0; i < 20 && correct; i++) {
+			correct = Linux_CircleMatchesTiles(DrawCircle, &surface, &tiled, options->tile_size, radius, centers[i]) &&
+				Linux_CircleMatchesTiles(DrawDisc, &surface, &tiled, options->tile_size, radius, centers[i]);
+			if (correct) {
+				// surface holds the disc, the circle must not add any pixels
+				DrawCircle(&surface, radius, centers[i].x, centers[i].y, 0xFFFFFFFF);
+				correct = memcmp(pixels, tiled_pixels, pixel_count * sizeof(u32)) == 0;
+			}
+		}
+		all_correct = all_correct && correct;
+
+		printf("  %6d  %7.1f  %11.1f  %6.2fx  %7.1f  %s\n", radius, trig_ns, midpoint_ns, trig_ns / midpoint_ns, disc_ns,
+			correct ? "yes" : "NO");
+	}
+
+	MyFree(centers);
+	MyFree(pixels);
+	MyFree(tiled_pixels);
+	return all_correct;
+}
+
+// The missile rasterizer that DrawConvexPolygon replaced: every pixel of
+// the bounding box is projected onto two sides of the parallelogram. Only
+// kept so --bench-missiles can check and time against it.
+static void Linux_DrawQuadProjected(DrawSurface *surface, Point *points, u32 color) {
+	Extents e = CalculateExtents(points, 4);
+	e.min_x = max_i32(e.min_x, surface->clip_min_x);
+	e.max_x = min_i32(e.max_x, surface->clip_max_x);
+	e.min_y = max_i32(e.min_y, surface->clip_min_y);
+	e.max_y = min_i32(e.max_y, surface->clip_max_y);
+
+	Vec2 ab = { points[1].x - points[0].x, points[1].y - points[0].y };
+	Vec2 ad = { points[3].x - points[0].x, points[3].y - points[0].y };
+	f32 dot_ab_ab = VectorLength(ab);
+	f32 dot_ad_ad = VectorLength(ad);
+	for (i32 y = e.min_y; y < e.max_y; y++) {
+		for (i32 x = e.min_x; x < e.max_x; x++) {
+			Vec2 am = { .x = (x - points[0].x), .y = (y - points[0].y) };
+			f32 dot_am_ab = DotProduct(am, ab);
+			if (dot_am_ab < 0 || dot_am_ab > dot_ab_ab) {
+				continue;
+			}
+			f32 dot_am_ad = DotProduct(am, ad);
+			if (dot_am_ad < 0 || dot_am_ad > dot_ad_ad) {
+				continue;
+			}
+			surface->pixels[x + (y * surface->width)] = color;
+		}
+	}
+}
+
+#define MISSILE_BENCH_QUAD_COUNT 2000
+
+// Random missiles (the game's missile rectangle at a random angle and sub
+// pixel position), and rectangles 4 and 16 times as big
+static void Linux_MakeBenchQuads(Point *quads, f32 scale, i32 width, i32 height) {
+	for (i32 i = 0; i < MISSILE_BENCH_QUAD_COUNT; i++) {
+		Point *quad = quads + (i * 4);
+		quad[0].x = 0.0f;
+		quad[0].y = 0.0f;
+		quad[1].x = 0.0f;
+		quad[1].y = MISSILE_HEIGHT * scale;
+		quad[2].x = MISSILE_WIDTH * scale;
+		quad[2].y = MISSILE_HEIGHT * scale;
+		quad[3].x = MISSILE_WIDTH * scale;
+		quad[3].y = 0.0f;
+		Point center = { MISSILE_WIDTH * scale * 0.5f, MISSILE_HEIGHT * scale * 0.5f };
+		f32 rotation = (f32)GenerateRandomNumber(0, 62831) / 10000.0f;
+		f32 x = (f32)GenerateRandomNumber(-16 * 8, (width + 16) * 8) / 8.0f;
+		f32 y = (f32)GenerateRandomNumber(-16 * 8, (height + 16) * 8) / 8.0f;
+		Transform2D transform = MakeTransform(rotation, center, x, y);
+		TransformPoints(&transform, quad, 4);
+	}
+}
+
+// Checks DrawConvexPolygon against the projection rasterizer on random
+// missiles, and tiles against the whole surface, then times both
+static b8 Linux_BenchmarkMissiles(Linux_HeadlessOptions *options) {
+	f32 scales[] = { 1.0f, 4.0f, 16.0f };
+	i32 width = options->width;
+	i32 height = options->height;
+	u64 pixel_count = (u64)width * height;
+
+	Point *quads = (Point*)MyAlloc(MISSILE_BENCH_QUAD_COUNT * 4 * sizeof(Point));
+	u32 *projected_pixels = (u32*)MyAlloc(pixel_count * sizeof(u32));
+	u32 *scanline_pixels = (u32*)MyAlloc(pixel_count * sizeof(u32));
+	u32 *tiled_pixels = (u32*)MyAlloc(pixel_count * sizeof(u32));
+	if (!quads || !projected_pixels || !scanline_pixels || !tiled_pixels) {
+		fprintf(stderr, "Failed to allocate the missile benchmark!\n");
+		return 0;
+	}
+	DrawSurface projected = MakeDrawSurface(projected_pixels, width, height);
+	DrawSurface scanline = MakeDrawSurface(scanline_pixels, width, height);
+	DrawSurface tiled = MakeDrawSurface(tiled_pixels, width, height);
+	i32 passes = Max2(options->frame_count / 100, 1);
+
+	printf("missile rasterizer: %d random quads x %d passes, %dx%d\n", MISSILE_BENCH_QUAD_COUNT, passes, width, height);
+	printf("  size     projected ns  scanline ns  speedup  pixels differ  tiles match\n");
+	b8 all_correct = 1;
+	for (i32 s = 0; s < (i32)(sizeof(scales) / sizeof(scales[0])); s++) {
+		SeedRandom(options->seed + (u32)s);
+		Linux_MakeBenchQuads(quads, scales[s], width, height);
+
+		// every quad in its own color, so overlaps don't hide differences
+		memset(projected_pixels, 0, pixel_count * sizeof(u32));
+		memset(scanline_pixels, 0, pixel_count * sizeof(u32));
+		memset(tiled_pixels, 0, pixel_count * sizeof(u32));
+		u64 projected_ns = 0;
+		u64 scanline_ns = 0;
+		for (i32 pass = 0; pass < passes; pass++) {
+			u64 begin = Linux_GetNanoseconds();
+			for (i32 i = 0; i < MISSILE_BENCH_QUAD_COUNT; i++) {
+				Linux_DrawQuadProjected(&projected, quads + (i * 4), (u32)i + 1);
+			}
+			u64 middle = Linux_GetNanoseconds();
+			for (i32 i = 0; i < MISSILE_BENCH_QUAD_COUNT; i++) {
+				DrawConvexPolygon(&scanline, quads + (i * 4), 4, (u32)i + 1);
+			}
+			u64 end = Linux_GetNanoseconds();
+			projected_ns += middle - begin;
+			scanline_ns += end - middle;
+		}
+
+		for (i32 tile_y = 0; tile_y < height; tile_y += options->tile_size) {
+			for (i32 tile_x = 0; tile_x < width; tile_x += options->tile_size) {
+				tiled.clip_min_x = tile_x;
+				tiled.clip_min_y = tile_y;
+				tiled.clip_max_x = Min2(tile_x + options->tile_size, width);
+				tiled.clip_max_y = Min2(tile_y + options->tile_size, height);
+				for (i32 i = 0; i < MISSILE_BENCH_QUAD_COUNT; i++) {
+					DrawConvexPolygon(&tiled, quads + (i * 4), 4, (u32)i + 1);
+				}
+			}
+		}
+		b8 tiles_match = memcmp(scanline_pixels, tiled_pixels, pixel_count * sizeof(u32)) == 0;
+
+		u64 filled = 0;
+		u64 differ = 0;
+		for (u64 i = 0; i < pixel_count; i++) {
+			filled += projected_pixels[i] != 0;
+			differ += projected_pixels[i] != scanline_pixels[i];
+		}
+
+		f64 quad_count = (f64)MISSILE_BENCH_QUAD_COUNT * passes;
+		f64 projected_quad_ns = (f64)projected_ns / quad_count;
+		f64 scanline_quad_ns = (f64)scanline_ns / quad_count;
+		printf("  %4.0fx%-4.0f %12.1f  %11.1f  %6.2fx  %6llu of %-6llu %s\n", MISSILE_WIDTH * scales[s],
+			MISSILE_HEIGHT * scales[s], projected_quad_ns, scanline_quad_ns, projected_quad_ns / scanline_quad_ns,
+			differ, filled, tiles_match ? "yes" : "NO");
+		all_correct = all_correct && tiles_match;
+	}
+
+	MyFree(quads);
+	MyFree(projected_pixels);
+	MyFree(scanline_pixels);
+	MyFree(tiled_pixels);
+	return all_correct;
+}
+
+// RotatePoints and TranslatePoints, which the transforms replaced: a radius,
+// an angle and its sine and cosine per point. Only kept so
+// --bench-transform can check and time against them.
+static void Linux_RotatePointsTrig(Point *points, i32 point_count, Point center_of_rotation, f32 rotation_amount) {
+	for (i32 i = 0; i < point_count; i++) {
+		Point *p = points + i;
+		Point reoriented = { p->x - center_of_rotation.x, p->y - center_of_rotation.y };
+		f32 radius = my_sqrt(((reoriented.x * reoriented.x) + (reoriented.y * reoriented.y)));
+		f32 theta = my_atan2(reoriented.y, reoriented.x);
+		p->x = (radius * my_cos(theta + rotation_amount)) + center_of_rotation.x;
+		p->y = (radius * my_sin(theta + rotation_amount)) + center_of_rotation.y;
+	}
+}
+
+static void Linux_TranslatePoints(Point *points, i32 point_count, f32 translation_x, f32 translation_y) {
+	for (i32 i = 0; i < point_count; i++) {
+		points[i].x += translation_x;
+		points[i].y += translation_y;
+	}
+}
+
+#define TRANSFORM_BENCH_SHAPE_COUNT 4096
+#define TRANSFORM_BENCH_MAX_POINTS 8
+// in pixels, for shapes anywhere on a 4k surface
+#define TRANSFORM_BENCH_TOLERANCE 1e-3
+
+// Puts shape_count copies of model at random rotations and positions with
+// the old rotate then translate and with one transform per shape, times
+// both, and checks they agree within TRANSFORM_BENCH_TOLERANCE. The same
+// points as separate x and y arrays must come out of TransformVertices with
+// the same bits as TransformPoints.
+static b8 Linux_BenchmarkTransform(Linux_HeadlessOptions *options) {
+	Point ship[] = { { 0, 0 }, { 15, 45 }, { 30, 0 } };
+	Point missile[] = { { 0, 0 }, { 0, MISSILE_HEIGHT }, { MISSILE_WIDTH, MISSILE_HEIGHT }, { MISSILE_WIDTH, 0 } };
+	Point octagon[TRANSFORM_BENCH_MAX_POINTS];
+	for (i32 i = 0; i < TRANSFORM_BENCH_MAX_POINTS; i++) {
+		octagon[i].x = 20.0f * my_cos((f32)i * (PI / 4.0f));
+		octagon[i].y = 20.0f * my_sin((f32)i * (PI / 4.0f));
+	}
+	struct { char *name; Point *model; i32 point_count; } shapes[] = {
+		{ "ship", ship, 3 },
+		{ "missile", missile, 4 },
+		{ "octagon", octagon, 8 },
+	};
+
+	u64 point_capacity = (u64)TRANSFORM_BENCH_SHAPE_COUNT * TRANSFORM_BENCH_MAX_POINTS;
+	f32 *rotations = (f32*)MyAlloc(TRANSFORM_BENCH_SHAPE_COUNT * sizeof(f32));
+	Point *positions = (Point*)MyAlloc(TRANSFORM_BENCH_SHAPE_COUNT * sizeof(Point));
+	Point *trig_points = (Point*)MyAlloc(point_capacity * sizeof(Point));
+	Point *matrix_points = (Point*)MyAlloc(point_capacity * sizeof(Point));
+	f32 *xs = (f32*)MyAlloc(point_capacity * sizeof(f32));
+	f32 *ys = (f32*)MyAlloc(point_capacity * sizeof(f32));
+	if (!rotations || !positions || !trig_points || !matrix_points || !xs || !ys) {
+		fprintf(stderr, "Failed to allocate the transform benchmark!\n");
+		return 0;
+	}
+	i32 passes = Max2(options->frame_count / 100, 1);
+
+	printf("vertex transform: %d random shapes x %d passes\n", TRANSFORM_BENCH_SHAPE_COUNT, passes);
+	printf("  shape    points  trig ns  matrix ns  speedup  soa ns  max difference  match\n");
+	b8 all_correct = 1;
+	for (i32 s = 0; s < (i32)(sizeof(shapes) / sizeof(shapes[0])); s++) {
+		Point *model = shapes[s].model;
+		i32 point_count = shapes[s].point_count;
+		Point center = {0};
+		for (i32 k = 0; k < point_count; k++) {
+			center.x += model[k].x / (f32)point_count;
+			center.y += model[k].y / (f32)point_count;
+		}
+
+		SeedRandom(options->seed + (u32)s);
+		for (i32 i = 0; i < TRANSFORM_BENCH_SHAPE_COUNT; i++) {
+			rotations[i] = (f32)GenerateRandomNumber(-62831, 62831) / 10000.0f;
+			positions[i].x = (f32)GenerateRandomNumber(0, 3840 * 8) / 8.0f;
+			positions[i].y = (f32)GenerateRandomNumber(0, 2160 * 8) / 8.0f;
+		}
+
+		u64 trig_ns = 0;
+		u64 matrix_ns = 0;
+		u64 soa_ns = 0;
+		for (i32 pass = 0; pass < passes; pass++) {
+			for (i32 i = 0; i < TRANSFORM_BENCH_SHAPE_COUNT; i++) {
+				memcpy(trig_points + (i * point_count), model, point_count * sizeof(Point));
+				memcpy(matrix_points + (i * point_count), model, point_count * sizeof(Point));
+				for (i32 k = 0; k < point_count; k++) {
+					xs[(i * point_count) + k] = model[k].x;
+					ys[(i * point_count) + k] = model[k].y;
+				}
+			}
+
+			u64 begin = Linux_GetNanoseconds();
+			for (i32 i = 0; i < TRANSFORM_BENCH_SHAPE_COUNT; i++) {
+				Point *points = trig_points + (i * point_count);
+				Linux_RotatePointsTrig(points, point_count, center, rotations[i]);
+				Linux_TranslatePoints(points, point_count, positions[i].x, positions[i].y);
+			}
+			u64 trig_end = Linux_GetNanoseconds();
+			for (i32 i = 0; i < TRANSFORM_BENCH_SHAPE_COUNT; i++) {
+				Transform2D transform = MakeTransform(rotations[i], center, positions[i].x, positions[i].y);
+				TransformPoints(&transform, matrix_points + (i * point_count), point_count);
+			}
+			u64 matrix_end = Linux_GetNanoseconds();
+			for (i32 i = 0; i < TRANSFORM_BENCH_SHAPE_COUNT; i++) {
+				Transform2D transform = MakeTransform(rotations[i], center, positions[i].x, positions[i].y);
+				TransformVertices(&transform, xs + (i * point_count), ys + (i * point_count), point_count);
+			}
+			u64 soa_end = Linux_GetNanoseconds();
+			trig_ns += trig_end - begin;
+			matrix_ns += matrix_end - trig_end;
+			soa_ns += soa_end - matrix_end;
+		}
+
+		f64 max_difference = 0.0;
+		b8 soa_match = 1;
+		for (i32 i = 0; i < TRANSFORM_BENCH_SHAPE_COUNT * point_count; i++) {
+			f64 dx = fabs((f64)trig_points[i].x - (f64)matrix_points[i].x);
+			f64 dy = fabs((f64)trig_points[i].y - (f64)matrix_points[i].y);
+			max_difference = dx > max_difference ? dx : max_difference;
+			max_difference = dy > max_difference ? dy : max_difference;
+			soa_match = soa_match && memcmp(&xs[i], &matrix_points[i].x, sizeof(f32)) == 0 &&
+				memcmp(&ys[i], &matrix_points[i].y, sizeof(f32)) == 0;
+		}
+
+		b8 correct = soa_match && max_difference <= TRANSFORM_BENCH_TOLERANCE;
+		all_correct = all_correct && correct;
+		f64 shape_count = (f64)TRANSFORM_BENCH_SHAPE_COUNT * passes;
+		f64 trig_shape_ns = (f64)trig_ns / shape_count;
+		f64 matrix_shape_ns = (f64)matrix_ns / shape_count;
+		printf("  %-7s  %6d  %7.1f  %9.1f  %6.2fx  %6.1f  %14.1e  %s\n", shapes[s].name, point_count,
+			trig_shape_ns, matrix_shape_ns, trig_shape_ns / matrix_shape_ns, (f64)soa_ns / shape_count, max_difference,
+			correct ? "yes" : "NO");
+	}
+
+	MyFree(rotations);
+	MyFree(positions);
+	MyFree(trig_points);
+	MyFree(matrix_points);
+	MyFree(xs);
+	MyFree(ys);
+	return all_correct;
+}
+
+// The array of structs meteors and missiles that MeteorPool and MissilePool
+// replaced, only kept so --bench-entities can check and time against them
+typedef struct {
+	Vec2 pos;
+	Vec2 previous_pos;
+	Vec2 direction;
+	i32 speed;
+	i32 radius;
+	b8 active;
+} Linux_AosMeteor;
+
+typedef struct {
+	Point points[4];
+	Point previous_points[4];
+	Vec2 direction;
+	f32 rotation;
+	i32 live;
+} Linux_AosMissile;
+
+static void Linux_UpdateAosEntities(Linux_AosMeteor *meteors, i32 meteor_count, Linux_AosMissile *missiles, i32 missile_count,
+	f32 delta_time, i32 width, i32 height) {
+	for (i32 i = 0; i < missile_count; i++) {
+		Linux_AosMissile *missile = missiles + i;
+		for (i32 k = 0; k < 4; k++) {
+			missile->previous_points[k] = missile->points[k];
+		}
+	}
+	for (i32 i = 0; i < meteor_count; i++) {
+		Linux_AosMeteor *meteor = meteors + i;
+		meteor->previous_pos = meteor->pos;
+	}
+
+	for (i32 i = 0; i < missile_count; i++) {
+		Linux_AosMissile *missile = missiles + i;
+		if (!missile->live) continue;
+		f32 speed = delta_time * MISSILE_SPEED;
+		for (i32 k = 0; k < 4; k++) {
+			missile->points[k].x += speed * missile->direction.x;
+			missile->points[k].y += speed * missile->direction.y;
+		}
+		Extents e = CalculateExtents(missile->points, 4);
+		if ((e.min_x < 0 && e.max_x < 0) ||
+			(e.min_x > width || e.max_x > width) ||
+			(e.min_y < 0 && e.max_y < 0) ||
+			(e.min_y > height || e.max_y > height)) {
+			missile->live = 0;
+		}
+	}
+
+	for (i32 i = 0; i < meteor_count; i++) {
+		Linux_AosMeteor *meteor = meteors + i;
+		if (!meteor->active) continue;
+		meteor->pos.x += meteor->direction.x * (delta_time * meteor->speed);
+		meteor->pos.y += meteor->direction.y * (delta_time * meteor->speed);
+		if ((meteor->pos.x + meteor->radius) <= 0) {
+			meteor->pos.x = (f32)(width + meteor->radius);
+		} else if ((meteor->pos.x - meteor->radius) >= width) {
+			meteor->pos.x = (f32)(-1 * meteor->radius);
+		}
+		if ((meteor->pos.y + meteor->radius) <= 0) {
+			meteor->pos.y = (f32)(height + meteor->radius);
+		} else if ((meteor->pos.y - meteor->radius) >= height) {
+			meteor->pos.y = (f32)(-1 * meteor->radius);
+		}
+	}
+}
+
+// One simulation step of the pools, as UpdateGame does it
+static void Linux_UpdatePools(MeteorPool *meteors, MissilePool *missiles, f32 delta_time, i32 width, i32 height) {
+	MissilePool_SavePrevious(missiles);
+	MeteorPool_SavePrevious(meteors);
+	MissilePool_Integrate(missiles, delta_time, width, height);
+	for (i32 missile = missiles->count - 1; missile >= 0; missile--) {
+		if (missiles->off_screen[missile]) {
+			MissilePool_Remove(missiles, missile);
+		}
+	}
+	MeteorPool_Integrate(meteors, delta_time, width, height);
+}
+
+// Runs the same random meteors and missiles (half as many missiles) through
+// simulation steps as arrays of structs and as pools, times both and checks
+// every live entity ends up in the same place with the same bits. Removing
+// missiles reorders the pool, so each one carries its struct index in
+// rotation, which the update never reads.
+static b8 Linux_BenchmarkEntities(Linux_HeadlessOptions *options) {
+	i32 counts[] = { 32, 1024, 10240, 102400 };
+	i32 width = options->width;
+	i32 height = options->height;
+	i32 steps = Max2(options->frame_count / 100, 1);
+	f32 delta_time = SIMULATION_TIMESTEP;
+
+#if __AVX2__
+	char *lanes = "AVX2, 8 wide";
+#else
+	char *lanes = "SSE, 4 wide";
+#endif
+	printf("entity update: random meteors and half as many missiles x %d steps, %s\n", steps, lanes);
+	printf("  meteors  structs ns  pools ns  speedup  match\n");
+	b8 all_correct = 1;
+	for (i32 c = 0; c < (i32)(sizeof(counts) / sizeof(counts[0])); c++) {
+		i32 meteor_count = counts[c];
+		i32 missile_count = meteor_count / 2;
+		Linux_AosMeteor *aos_meteors = (Linux_AosMeteor*)MyAlloc((u64)meteor_count * sizeof(Linux_AosMeteor));
+		Linux_AosMissile *aos_missiles = (Linux_AosMissile*)MyAlloc((u64)missile_count * sizeof(Linux_AosMissile));
+		MeteorPool meteors;
+		MissilePool missiles;
+		void *pool_memory = EntityPools_Create(&meteors, meteor_count, &missiles, missile_count);
+		if (!aos_meteors || !aos_missiles || !pool_memory) {
+			fprintf(stderr, "Failed to allocate the entity benchmark!\n");
+			return 0;
+		}
+
+		SeedRandom(options->seed + (u32)c);
+		for (i32 i = 0; i < meteor_count; i++) {
+			Linux_AosMeteor *meteor = aos_meteors + i;
+			meteor->pos.x = (f32)GenerateRandomNumber(0, width - 1);
+			meteor->pos.y = (f32)GenerateRandomNumber(0, height - 1);
+			f32 angle = (f32)GenerateRandomNumber(0, 62831) / 10000.0f;
+			meteor->direction.x = my_cos(angle);
+			meteor->direction.y = my_sin(angle);
+			meteor->speed = GenerateRandomNumber(150, 249);
+			meteor->radius = GenerateRandomNumber(15, 49);
+			meteor->active = 1;
+
+			meteors.x[i] = meteor->pos.x;
+			meteors.y[i] = meteor->pos.y;
+			meteors.dx[i] = meteor->direction.x;
+			meteors.dy[i] = meteor->direction.y;
+			meteors.speed[i] = (f32)meteor->speed;
+			meteors.radius[i] = (f32)meteor->radius;
+		}
+		meteors.count = meteor_count;
+		for (i32 i = 0; i < missile_count; i++) {
+			Linux_AosMissile *missile = aos_missiles + i;
+			Point points[4] = { { 0, 0 }, { 0, MISSILE_HEIGHT }, { MISSILE_WIDTH, MISSILE_HEIGHT }, { MISSILE_WIDTH, 0 } };
+			Point center = { MISSILE_WIDTH / 2.0f, MISSILE_HEIGHT / 2.0f };
+			f32 angle = (f32)GenerateRandomNumber(0, 62831) / 10000.0f;
+			Transform2D transform = MakeTransform(angle, center, (f32)GenerateRandomNumber(0, width - 1),
+				(f32)GenerateRandomNumber(0, height - 1));
+			TransformPoints(&transform, points, 4);
+			for (i32 k = 0; k < 4; k++) {
+				missile->points[k] = points[k];
+				missiles.x[k][i] = points[k].x;
+				missiles.y[k][i] = points[k].y;
+			}
+			missile->direction.x = my_cos(angle);
+			missile->direction.y = my_sin(angle);
+			missile->live = 1;
+			missiles.dx[i] = missile->direction.x;
+			missiles.dy[i] = missile->direction.y;
+			missiles.rotation[i] = (f32)i;
+		}
+		missiles.count = missile_count;
+
+		u64 begin = Linux_GetNanoseconds();
+		for (i32 step = 0; step < steps; step++) {
+			Linux_UpdateAosEntities(aos_meteors, meteor_count, aos_missiles, missile_count, delta_time, width, height);
+		}
+		u64 middle = Linux_GetNanoseconds();
+		for (i32 step = 0; step < steps; step++) {
+			Linux_UpdatePools(&meteors, &missiles, delta_time, width, height);
+		}
+		u64 end = Linux_GetNanoseconds();
+
+		b8 match = 1;
+		for (i32 i = 0; i < meteor_count && match; i++) {
+			match = memcmp(&aos_meteors[i].pos.x, &meteors.x[i], sizeof(f32)) == 0 &&
+				memcmp(&aos_meteors[i].pos.y, &meteors.y[i], sizeof(f32)) == 0;
+		}
+		i32 aos_live = 0;
+		for (i32 i = 0; i < missile_count; i++) {
+			aos_live += aos_missiles[i].live;
+		}
+		match = match && aos_live == missiles.count;
+		for (i32 i = 0; i < missiles.count && match; i++) {
+			Linux_AosMissile *missile = aos_missiles + (i32)missiles.rotation[i];
+			match = missile->live;
+			for (i32 k = 0; k < 4 && match; k++) {
+				match = memcmp(&missile->points[k].x, &missiles.x[k][i], sizeof(f32)) == 0 &&
+					memcmp(&missile->points[k].y, &missiles.y[k][i], sizeof(f32)) == 0;
+			}
+		}
+		all_correct = all_correct && match;
+
+		f64 aos_ns = (f64)(middle - begin) / steps;
+		f64 pool_ns = (f64)(end - middle) / steps;
+		printf("  %7d  %10.0f  %8.0f  %6.2fx  %s\n", meteor_count, aos_ns, pool_ns, aos_ns / pool_ns, match ? "yes" : "NO");
+
+		MyFree(aos_meteors);
+		MyFree(aos_missiles);
+		EntityPools_Destroy(&meteors, &missiles, pool_memory);
+	}
+	return all_correct;
+}
+
+// The meteor pool before it was kept dense: entities stay in their slot, a
+// list of the live slots sits next to the arrays, spawning scans for the
+// lowest free slot and the kernels run over every slot below the highest
+// one used. Only kept so --bench-pools can check and time against it.
+typedef struct {
+	MeteorPool arrays; // arrays.count is the slot count
+	i32 *slots; // the live slots, live_count of them
+	i32 *positions; // slot -> its index in slots, -1 for a free slot
+	i32 live_count;
+} Linux_SlotMeteorPool;
+
+// RETURNS: the slot to fill in, or -1 if the pool is full
+static i32 Linux_SlotMeteorPool_Add(Linux_SlotMeteorPool *pool) {
+	for (i32 slot = 0; slot < pool->arrays.capacity; slot++) {
+		if (pool->positions[slot] < 0) {
+			pool->positions[slot] = pool->live_count;
+			pool->slots[pool->live_count] = slot;
+			pool->live_count += 1;
+			pool->arrays.count = Max2(pool->arrays.count, slot + 1);
+			return slot;
+		}
+	}
+	return -1;
+}
+
+// Frees the live_index'th live slot, the last live slot takes its place in the list
+static void Linux_SlotMeteorPool_Remove(Linux_SlotMeteorPool *pool, i32 live_index) {
+	i32 slot = pool->slots[live_index];
+	i32 last = pool->slots[pool->live_count - 1];
+	pool->slots[live_index] = last;
+	pool->positions[last] = live_index;
+	pool->positions[slot] = -1;
+	pool->live_count -= 1;
+}
+
+#define POOL_BENCH_CYCLES 2
+
+// Spawns and despawns meteors in waves: a 64th of the pool at a time until
+// an eighth is left, then back up to full, with a simulation step after each
+// batch. Despawns pick a random live meteor. Runs the same waves on the
+// dense pool and on the slot pool it replaced, times both and checks the
+// live meteors come out the same, in the same order.
+static b8 Linux_BenchmarkPools(Linux_HeadlessOptions *options) {
+	i32 capacities[] = { 1024, 10240, 102400 };
+	i32 width = options->width;
+	i32 height = options->height;
+	f32 delta_time = SIMULATION_TIMESTEP;
+
+	printf("meteor churn: %d cycles of draining to 1/8 and refilling, 1/64 of the pool per step\n", POOL_BENCH_CYCLES);
+	printf("  capacity   steps  slots ns/op  dense ns/op  speedup  match\n");
+	b8 all_correct = 1;
+	for (i32 c = 0; c < (i32)(sizeof(capacities) / sizeof(capacities[0])); c++) {
+		i32 capacity = capacities[c];
+		i32 batch = capacity / 64;
+		MeteorPool dense;
+		Linux_SlotMeteorPool slotted;
+		MissilePool unused_missiles;
+		void *dense_memory = EntityPools_Create(&dense, capacity, &unused_missiles, 1);
+		void *slotted_memory = EntityPools_Create(&slotted.arrays, capacity, &unused_missiles, 1);
+		slotted.slots = (i32*)MyAlloc((u64)capacity * sizeof(i32));
+		slotted.positions = (i32*)MyAlloc((u64)capacity * sizeof(i32));
+		slotted.live_count = 0;
+		if (!dense_memory || !slotted_memory || !slotted.slots || !slotted.positions) {
+			fprintf(stderr, "Failed to allocate the pool benchmark!\n");
+			return 0;
+		}
+		for (i32 slot = 0; slot < capacity; slot++) {
+			slotted.positions[slot] = -1;
+		}
+
+		u64 times[2] = {0};
+		i32 steps = 0;
+		i32 operations = 0;
+		for (i32 run = 0; run < 2; run++) {
+			b8 run_dense = run == 1;
+			SeedRandom(options->seed + (u32)c);
+			u64 begin = Linux_GetNanoseconds();
+			steps = 0;
+			operations = 0;
+			for (i32 cycle = 0; cycle < POOL_BENCH_CYCLES; cycle++) {
+				for (i32 filling = 1; filling >= 0; filling--) {
+					for (;;) {
+						i32 count = run_dense ? dense.count : slotted.live_count;
+						if (filling ? count == capacity : count <= capacity / 8) {
+							break;
+						}
+						for (i32 i = 0; i < batch; i++) {
+							if (filling) {
+								f32 x = (f32)GenerateRandomNumber(0, width - 1);
+								f32 y = (f32)GenerateRandomNumber(0, height - 1);
+								f32 angle = (f32)GenerateRandomNumber(0, 62831) / 10000.0f;
+								f32 speed = (f32)GenerateRandomNumber(150, 249);
+								f32 radius = (f32)GenerateRandomNumber(15, 49);
+								MeteorPool *arrays = &dense;
+								i32 meteor = 0;
+								if (run_dense) {
+									meteor = MeteorPool_Add(&dense);
+								} else {
+									arrays = &slotted.arrays;
+									meteor = Linux_SlotMeteorPool_Add(&slotted);
+								}
+								arrays->x[meteor] = x;
+								arrays->y[meteor] = y;
+								arrays->dx[meteor] = my_cos(angle);
+								arrays->dy[meteor] = my_sin(angle);
+								arrays->speed[meteor] = speed;
+								arrays->radius[meteor] = radius;
+							} else {
+								i32 live_count = run_dense ? dense.count : slotted.live_count;
+								i32 index = GenerateRandomNumber(0, live_count - 1);
+								if (run_dense) {
+									MeteorPool_Remove(&dense, index);
+								} else {
+									Linux_SlotMeteorPool_Remove(&slotted, index);
+								}
+							}
+							operations += 1;
+						}
+						MeteorPool *arrays = run_dense ? &dense : &slotted.arrays;
+						MeteorPool_SavePrevious(arrays);
+						MeteorPool_Integrate(arrays, delta_time, width, height);
+						steps += 1;
+					}
+				}
+			}
+			times[run] = Linux_GetNanoseconds() - begin;
+		}
+
+		b8 match = dense.count == slotted.live_count;
+		for (i32 i = 0; i < dense.count && match; i++) {
+			i32 slot = slotted.slots[i];
+			match = memcmp(&dense.x[i], &slotted.arrays.x[slot], sizeof(f32)) == 0 &&
+				memcmp(&dense.y[i], &slotted.arrays.y[slot], sizeof(f32)) == 0 &&
+				dense.radius[i] == slotted.arrays.radius[slot];
+		}
+		all_correct = all_correct && match;
+
+		f64 slotted_ns = (f64)times[0] / operations;
+		f64 dense_ns = (f64)times[1] / operations;
+		printf("  %8d  %6d  %12.1f  %11.1f  %6.2fx  %s\n", capacity, steps, slotted_ns, dense_ns,
+			slotted_ns / dense_ns, match ? "yes" : "NO");
+
+		EntityPools_Destroy(&dense, &unused_missiles, dense_memory);
+		EntityPools_Destroy(&slotted.arrays, &unused_missiles, slotted_memory);
+		MyFree(slotted.slots);
+		MyFree(slotted.positions);
+	}
+	return all_correct;
+}
+
+// The point test the game used before PointsInsideCircles, a floored square
+// root per point, kept so the benchmarks can check and time against it.
+static b8 Linux_AnyPointsInsideCircle(i32 circle_radius, Vec2 circle_position, Point *points, i32 point_count) {
+	for (i32 i = 0; i < point_count; i++) {
+		Point p = points[i];
+		
+		Vec2 testpoint = {0};
+		testpoint.x = p.x;
+		testpoint.y = p.y;
+		
+		Vec2 d = Subtract(circle_position, testpoint); // displacement from center
+		i32 distance_from_center = my_floor(my_sqrt((f32)(d.x*d.x)+(f32)(d.y*d.y)));
+		if (distance_from_center <= circle_radius) {
+			return 1;
+		}
+	}
+	
+	return 0;
+}
+
+#define BROADPHASE_BENCH_MISSILES MISSILE_POOL_SIZE
+
+// Scatters meteors of the game's sizes over the surface, plus a pool's worth
+// of missiles and a ship, and finds every missile-meteor and ship-meteor
+// overlap both by testing every pair and through the grid, as UpdateGame
+// does. Times both and checks they find the same overlaps.
+static b8 Linux_BenchmarkBroadphase(Linux_HeadlessOptions *options) {
+	i32 counts[] = { 32, 1024, 10240, 102400 };
+	i32 width = options->width;
+	i32 height = options->height;
+	i32 passes = Max2(options->frame_count / 100, 1);
+
+	printf("collision broadphase: %d missiles and a ship against the meteors x %d passes\n",
+		BROADPHASE_BENCH_MISSILES, passes);
+	printf("  meteors   overlaps  pairs ns   grid ns  speedup  match\n");
+	b8 all_correct = 1;
+	for (i32 c = 0; c < (i32)(sizeof(counts) / sizeof(counts[0])); c++) {
+		i32 meteor_count = counts[c];
+		MeteorPool meteors;
+		MissilePool missiles;
+		void *pool_memory = EntityPools_Create(&meteors, meteor_count, &missiles, BROADPHASE_BENCH_MISSILES);
+		if (!pool_memory) {
+			fprintf(stderr, "Failed to allocate the broadphase benchmark!\n");
+			return 0;
+		}
+
+		SeedRandom(options->seed + (u32)c);
+		for (i32 i = 0; i < meteor_count; i++) {
+			i32 meteor = MeteorPool_Add(&meteors);
+			meteors.x[meteor] = (f32)GenerateRandomNumber(0, width - 1);
+			meteors.y[meteor] = (f32)GenerateRandomNumber(0, height - 1);
+			meteors.radius[meteor] = (f32)GenerateRandomNumber(15, 49);
+		}
+		for (i32 i = 0; i < BROADPHASE_BENCH_MISSILES; i++) {
+			i32 missile = MissilePool_Add(&missiles);
+			Point points[MISSILE_CORNER_COUNT] = { { 0, 0 }, { 0, MISSILE_HEIGHT }, { MISSILE_WIDTH, MISSILE_HEIGHT }, { MISSILE_WIDTH, 0 } };
+			Point center = { MISSILE_WIDTH / 2.0f, MISSILE_HEIGHT / 2.0f };
+			Transform2D transform = MakeTransform((f32)GenerateRandomNumber(0, 62831) / 10000.0f, center,
+				(f32)GenerateRandomNumber(0, width - 1), (f32)GenerateRandomNumber(0, height - 1));
+			TransformPoints(&transform, points, MISSILE_CORNER_COUNT);
+			for (i32 k = 0; k < MISSILE_CORNER_COUNT; k++) {
+				missiles.x[k][missile] = points[k].x;
+				missiles.y[k][missile] = points[k].y;
+			}
+		}
+		Triangle ship = MakeShipTriangle(1.0f, width / 2.0f, height / 2.0f);
+		Point *ship_points = (Point*)&ship;
+
+		// sums of (meteor + 1) * (missile + 1), the ship is missile -1
+		u64 pair_sums[2] = {0};
+		i32 overlaps[2] = {0};
+		u64 times[2] = {0};
+		for (i32 run = 0; run < 2; run++) {
+			b8 use_grid = run == 1;
+			u64 begin = Linux_GetNanoseconds();
+			for (i32 pass = 0; pass < passes; pass++) {
+				u64 pair_sum = 0;
+				i32 overlap_count = 0;
+				if (use_grid) {
+					MeteorGrid_Build(&meteors.grid, &meteors);
+				}
+				for (i32 missile = -1; missile < missiles.count; missile++) {
+					Point missile_points[MISSILE_CORNER_COUNT];
+					Point *points = ship_points;
+					i32 point_count = 3;
+					if (missile >= 0) {
+						for (i32 k = 0; k < MISSILE_CORNER_COUNT; k++) {
+							missile_points[k].x = missiles.x[k][missile];
+							missile_points[k].y = missiles.y[k][missile];
+						}
+						points = missile_points;
+						point_count = MISSILE_CORNER_COUNT;
+					}
+
+					i32 candidate_count = meteors.count;
+					i32 *candidates = 0;
+					if (use_grid) {
+						Extents extents = CalculateExtents(points, point_count);
+						candidate_count = MeteorGrid_Gather(&meteors.grid, (f32)extents.min_x, (f32)extents.min_y,
+							(f32)extents.max_x, (f32)extents.max_y);
+						candidates = meteors.grid.candidates;
+					}
+					for (i32 i = 0; i < candidate_count; i++) {
+						i32 meteor = candidates ? candidates[i] : i;
+						Vec2 position = { meteors.x[meteor], meteors.y[meteor] };
+						if (Linux_AnyPointsInsideCircle((i32)meteors.radius[meteor], position, points, point_count)) {
+							pair_sum += (u64)(meteor + 1) * (u64)(missile + 2);
+							overlap_count += 1;
+						}
+					}
+				}
+				pair_sums[run] = pair_sum;
+				overlaps[run] = overlap_count;
+			}
+			times[run] = Linux_GetNanoseconds() - begin;
+		}
+
+		b8 match = pair_sums[0] == pair_sums[1] && overlaps[0] == overlaps[1];
+		all_correct = all_correct && match;
+		f64 pairs_ns = (f64)times[0] / passes;
+		f64 grid_ns = (f64)times[1] / passes;
+		printf("  %7d  %9d  %8.0f  %8.0f  %6.2fx  %s\n", meteor_count, overlaps[0], pairs_ns, grid_ns,
+			pairs_ns / grid_ns, match ? "yes" : "NO");
+
+		EntityPools_Destroy(&meteors, &missiles, pool_memory);
+	}
+	return all_correct;
+}
+
+// The default game is 24 meteors, about 35 pixels across on average, on a
+// 1280x960 surface, about 7.5% of which they cover
+#define BOUNCE_BENCH_COVERAGE 0.075f
+#define BOUNCE_BENCH_WARMUP_STEPS 200
+
+// Bounces meteors around a world sized to keep them as crowded as in the
+// default game, once keeping the sweep order from step to step and once
+// sorting it from scratch every step. Both give the same order, so they
+// must end up with the same bits. Times the steps after a warm up.
+static b8 Linux_BenchmarkBounce(Linux_HeadlessOptions *options) {
+	i32 counts[] = { 1000, 5000, 20000, 100000 };
+	i32 steps = Max2(options->frame_count / 100, 1);
+	f32 delta_time = SIMULATION_TIMESTEP;
+
+	printf("meteor bounce: %d steps after %d warm up steps, %.1f%% of the world covered\n",
+		steps, BOUNCE_BENCH_WARMUP_STEPS, BOUNCE_BENCH_COVERAGE * 100.0f);
+	printf("  meteors   world px  insertion us  sort us  speedup  match\n");
+	b8 all_correct = 1;
+	for (i32 c = 0; c < (i32)(sizeof(counts) / sizeof(counts[0])); c++) {
+		i32 meteor_count = counts[c];
+		// mean area of the radii SpawnMeteor is given, 20 to 49
+		f32 mean_area = 3.14159265f * 1216.0f;
+		i32 world_size = (i32)my_sqrt((f32)meteor_count * mean_area / BOUNCE_BENCH_COVERAGE);
+
+		MeteorPool runs[2];
+		MissilePool unused_missiles;
+		void *memory[2];
+		u64 times[2] = {0};
+		for (i32 run = 0; run < 2; run++) {
+			MeteorPool *meteors = runs + run;
+			memory[run] = EntityPools_Create(meteors, meteor_count, &unused_missiles, 1);
+			if (!memory[run]) {
+				fprintf(stderr, "Failed to allocate the bounce benchmark!\n");
+				return 0;
+			}
+			SeedRandom(options->seed + (u32)c);
+			for (i32 i = 0; i < meteor_count; i++) {
+				i32 meteor = MeteorPool_Add(meteors);
+				meteors->x[meteor] = (f32)GenerateRandomNumber(0, world_size - 1);
+				meteors->y[meteor] = (f32)GenerateRandomNumber(0, world_size - 1);
+				f32 angle = (f32)GenerateRandomNumber(0, 62831) / 10000.0f;
+				meteors->dx[meteor] = my_cos(angle);
+				meteors->dy[meteor] = my_sin(angle);
+				meteors->speed[meteor] = (f32)GenerateRandomNumber(150, 249);
+				meteors->radius[meteor] = (f32)GenerateRandomNumber(20, 49);
+			}
+
+			b8 sort_every_step = run == 1;
+			for (i32 step = 0; step < BOUNCE_BENCH_WARMUP_STEPS + steps; step++) {
+				MeteorPool_Integrate(meteors, delta_time, world_size, world_size);
+				if (sort_every_step) {
+					meteors->sweep_added = meteor_count;
+				}
+				u64 begin = Linux_GetNanoseconds();
+				MeteorPool_Bounce(meteors);
+				if (step >= BOUNCE_BENCH_WARMUP_STEPS) {
+					times[run] += Linux_GetNanoseconds() - begin;
+				}
+			}
+		}
+
+		b8 match = memcmp(runs[0].x, runs[1].x, (u64)meteor_count * sizeof(f32)) == 0 &&
+			memcmp(runs[0].y, runs[1].y, (u64)meteor_count * sizeof(f32)) == 0 &&
+			memcmp(runs[0].speed, runs[1].speed, (u64)meteor_count * sizeof(f32)) == 0;
+		all_correct = all_correct && match;
+		f64 insertion_us = (f64)times[0] / steps / 1000.0;
+		f64 sort_us = (f64)times[1] / steps / 1000.0;
+		printf("  %7d  %9d  %12.1f  %7.1f  %6.2fx  %s\n", meteor_count, world_size, insertion_us, sort_us,
+			sort_us / insertion_us, match ? "yes" : "NO");
+
+		for (i32 run = 0; run < 2; run++) {
+			EntityPools_Destroy(runs + run, &unused_missiles, memory[run]);
+		}
+	}
+	return all_correct;
+}
+
+// One circle at a time with the same operations in the same order as
+// SweepPointsAgainstCircles, kept so --bench-swept can check the SSE and
+// AVX2 paths against it bit for bit.
+static void Linux_SweepPointsAgainstCirclesScalar(Point *from, Point *to, i32 point_count, f32 *circle_x,
+	f32 *circle_y, f32 *circle_radius, i32 circle_count, f32 *times) {
+	for (i32 i = 0; i < circle_count; i++) {
+		f32 best = F32_MAX;
+		for (i32 k = 0; k < point_count; k++) {
+			f32 move_x = to[k].x - from[k].x;
+			f32 move_y = to[k].y - from[k].y;
+			f32 a = (move_x * move_x) + (move_y * move_y);
+			f32 inverse_a = (a > 0.0f) ? (1.0f / a) : 0.0f;
+			f32 offset_x = from[k].x - circle_x[i];
+			f32 offset_y = from[k].y - circle_y[i];
+			f32 reach = circle_radius[i] + 1.0f;
+			f32 c = ((offset_x * offset_x) + (offset_y * offset_y)) - (reach * reach);
+			f32 b = (move_x * offset_x) + (move_y * offset_y);
+			f32 discriminant = (b * b) - (a * c);
+			f32 numerator = (0.0f - b) - my_sqrt(my_max(discriminant, 0.0f));
+			f32 time = F32_MAX;
+			if ((b < 0.0f) && (discriminant >= 0.0f) && (numerator <= a)) {
+				time = numerator * inverse_a;
+			}
+			if (c <= 0.0f) {
+				time = 0.0f;
+			}
+			best = my_min(best, time);
+		}
+		times[i] = best;
+	}
+}
+
+// Scatters meteors over the surface and a pool's worth of missiles that
+// moved a given distance since the last step, and tests every missile
+// against every meteor both with the point test UpdateGame used to do and
+// with the swept test. Times both, counts the hits the point test misses
+// and checks the swept times against the scalar reference.
+static b8 Linux_BenchmarkSwept(Linux_HeadlessOptions *options) {
+	i32 counts[] = { 24, 1024, 10240 };
+	// a missile moves 15 pixels a step at 60Hz, 1.5 and 60 are 10 and 1/4 of a step
+	f32 travels[] = { 1.5f, 15.0f, 60.0f };
+	i32 width = options->width;
+	i32 height = options->height;
+	i32 passes = Max2(options->frame_count / 100, 1);
+
+	printf("swept missiles: %d missiles against every meteor x %d passes\n", BROADPHASE_BENCH_MISSILES, passes);
+	printf("  meteors  travel  point hits  swept hits  missed  point ns/pair  swept ns/pair  speedup  match\n");
+	b8 all_correct = 1;
+	for (i32 c = 0; c < (i32)(sizeof(counts) / sizeof(counts[0])); c++) {
+		for (i32 t = 0; t < (i32)(sizeof(travels) / sizeof(travels[0])); t++) {
+			i32 meteor_count = counts[c];
+			MeteorPool meteors;
+			MissilePool missiles;
+			void *pool_memory = EntityPools_Create(&meteors, meteor_count, &missiles, BROADPHASE_BENCH_MISSILES);
+			f32 *times = (f32*)MyAlloc((u64)meteor_count * sizeof(f32));
+			f32 *reference_times = (f32*)MyAlloc((u64)meteor_count * sizeof(f32));
+			if (!pool_memory || !times || !reference_times) {
+				fprintf(stderr, "Failed to allocate the swept missile benchmark!\n");
+				return 0;
+			}
+
+			SeedRandom(options->seed + (u32)c);
+			for (i32 i = 0; i < meteor_count; i++) {
+				i32 meteor = MeteorPool_Add(&meteors);
+				meteors.x[meteor] = (f32)GenerateRandomNumber(0, width - 1);
+				meteors.y[meteor] = (f32)GenerateRandomNumber(0, height - 1);
+				meteors.radius[meteor] = (f32)GenerateRandomNumber(15, 49);
+			}
+			for (i32 i = 0; i < BROADPHASE_BENCH_MISSILES; i++) {
+				i32 missile = MissilePool_Add(&missiles);
+				Point points[MISSILE_CORNER_COUNT] = { { 0, 0 }, { 0, MISSILE_HEIGHT }, { MISSILE_WIDTH, MISSILE_HEIGHT }, { MISSILE_WIDTH, 0 } };
+				Point center = { MISSILE_WIDTH / 2.0f, MISSILE_HEIGHT / 2.0f };
+				f32 angle = (f32)GenerateRandomNumber(0, 62831) / 10000.0f;
+				Transform2D transform = MakeTransform(angle, center,
+					(f32)GenerateRandomNumber(0, width - 1), (f32)GenerateRandomNumber(0, height - 1));
+				TransformPoints(&transform, points, MISSILE_CORNER_COUNT);
+				for (i32 k = 0; k < MISSILE_CORNER_COUNT; k++) {
+					missiles.x[k][missile] = points[k].x;
+					missiles.y[k][missile] = points[k].y;
+					missiles.previous_x[k][missile] = points[k].x - (my_sin(angle) * travels[t]);
+					missiles.previous_y[k][missile] = points[k].y + (my_cos(angle) * travels[t]);
+				}
+			}
+
+			i32 point_hits = 0;
+			i32 swept_hits = 0;
+			i32 missed = 0;
+			b8 match = 1;
+			u64 elapsed[2] = {0};
+			for (i32 run = 0; run < 2; run++) {
+				b8 swept = run == 1;
+				u64 begin = Linux_GetNanoseconds();
+				for (i32 pass = 0; pass < passes; pass++) {
+					i32 hit_count = 0;
+					for (i32 missile = 0; missile < missiles.count; missile++) {
+						Point from[MISSILE_CORNER_COUNT];
+						Point to[MISSILE_CORNER_COUNT];
+						for (i32 k = 0; k < MISSILE_CORNER_COUNT; k++) {
+							from[k].x = missiles.previous_x[k][missile];
+							from[k].y = missiles.previous_y[k][missile];
+							to[k].x = missiles.x[k][missile];
+							to[k].y = missiles.y[k][missile];
+						}
+						if (swept) {
+							SweepPointsAgainstCircles(from, to, MISSILE_CORNER_COUNT, meteors.x, meteors.y,
+								meteors.radius, meteors.count, times);
+							for (i32 meteor = 0; meteor < meteors.count; meteor++) {
+								hit_count += times[meteor] < F32_MAX;
+							}
+						} else {
+							for (i32 meteor = 0; meteor < meteors.count; meteor++) {
+								Vec2 position = { meteors.x[meteor], meteors.y[meteor] };
+								hit_count += Linux_AnyPointsInsideCircle((i32)meteors.radius[meteor], position, to,
+									MISSILE_CORNER_COUNT);
+							}
+						}
+					}
+					if (swept) {
+						swept_hits = hit_count;
+					} else {
+						point_hits = hit_count;
+					}
+				}
+				elapsed[run] = Linux_GetNanoseconds() - begin;
+			}
+
+			// every hit the point test finds at the end of the way must be found
+			// by the swept test too
+			for (i32 missile = 0; missile < missiles.count; missile++) {
+				Point from[MISSILE_CORNER_COUNT];
+				Point to[MISSILE_CORNER_COUNT];
+				for (i32 k = 0; k < MISSILE_CORNER_COUNT; k++) {
+					from[k].x = missiles.previous_x[k][missile];
+					from[k].y = missiles.previous_y[k][missile];
+					to[k].x = missiles.x[k][missile];
+					to[k].y = missiles.y[k][missile];
+				}
+				SweepPointsAgainstCircles(from, to, MISSILE_CORNER_COUNT, meteors.x, meteors.y, meteors.radius,
+					meteors.count, times);
+				Linux_SweepPointsAgainstCirclesScalar(from, to, MISSILE_CORNER_COUNT, meteors.x, meteors.y,
+					meteors.radius, meteors.count, reference_times);
+				match = match && memcmp(times, reference_times, (u64)meteors.count * sizeof(f32)) == 0;
+				for (i32 meteor = 0; meteor < meteors.count; meteor++) {
+					Vec2 position = { meteors.x[meteor], meteors.y[meteor] };
+					if (Linux_AnyPointsInsideCircle((i32)meteors.radius[meteor], position, to, MISSILE_CORNER_COUNT) &&
+						!(times[meteor] <= 1.0f)) {
+						missed += 1;
+					}
+				}
+			}
+			match = match && missed == 0;
+			all_correct = all_correct && match;
+
+			f64 pairs = (f64)passes * missiles.count * meteors.count;
+			f64 point_ns = (f64)elapsed[0] / pairs;
+			f64 swept_ns = (f64)elapsed[1] / pairs;
+			printf("  %7d  %6.1f  %10d  %10d  %6d  %13.2f  %13.2f  %6.2fx  %s\n", meteor_count, travels[t],
+				point_hits, swept_hits, missed, point_ns, swept_ns, point_ns / swept_ns, match ? "yes" : "NO");
+
+			MyFree(times);
+			MyFree(reference_times);
+			EntityPools_Destroy(&meteors, &missiles, pool_memory);
+		}
+	}
+	return all_correct;
+}
+
+// Every float squared distance from 0.5 up to 4096^2 is checked against the
+// radii either side of its floored square root. Below 0.5 every point is
+// inside any circle, and inside only ever gets harder further out.
+#define POINTS_BENCH_MAX_RADIUS 4095
+#define POINTS_BENCH_RANDOM_CIRCLES 1031
+#define POINTS_BENCH_RANDOM_ROUNDS 1000
+
+// Checks CircleReachSquared against the floored square root on every float
+// squared distance in range, then PointsInsideCircles against
+// Linux_AnyPointsInsideCircle on random points, many of them within a hair
+// of the edge, and times both for the ship's 3 points and a missile's 4.
+static b8 Linux_BenchmarkPoints(Linux_HeadlessOptions *options) {
+	f32 *limits = (f32*)MyAlloc((POINTS_BENCH_MAX_RADIUS + 1) * sizeof(f32));
+	if (!limits) {
+		fprintf(stderr, "Failed to allocate the point benchmark!\n");
+		return 0;
+	}
+	for (i32 radius = 0; radius <= POINTS_BENCH_MAX_RADIUS; radius++) {
+		limits[radius] = CircleReachSquared((f32)radius);
+	}
+	f32 first = 0.5f;
+	f32 last = (f32)(POINTS_BENCH_MAX_RADIUS + 1) * (f32)(POINTS_BENCH_MAX_RADIUS + 1);
+	u32 first_bits;
+	u32 last_bits;
+	memcpy(&first_bits, &first, sizeof(first_bits));
+	memcpy(&last_bits, &last, sizeof(last_bits));
+	u64 wrong = 0;
+	for (u32 bits = first_bits; bits < last_bits; bits++) {
+		f32 distance_squared;
+		memcpy(&distance_squared, &bits, sizeof(distance_squared));
+		i32 distance = my_floor(my_sqrt(distance_squared));
+		// inside the circle of its own floored distance, not the one under it
+		if (!(distance_squared <= limits[distance]) || ((distance > 0) && (distance_squared <= limits[distance - 1]))) {
+			wrong += 1;
+		}
+	}
+	printf("squared distances: %u checked for radii 0 to %d, %llu wrong\n", last_bits - first_bits,
+		POINTS_BENCH_MAX_RADIUS, (unsigned long long)wrong);
+	b8 all_correct = wrong == 0;
+	MyFree(limits);
+
+	MeteorPool meteors;
+	MissilePool unused_missiles;
+	void *pool_memory = EntityPools_Create(&meteors, Max2(POINTS_BENCH_RANDOM_CIRCLES, 10240), &unused_missiles, 1);
+	u32 *hit_masks = (u32*)MyAlloc(((meteors.capacity + 31) / 32) * sizeof(u32));
+	if (!pool_memory || !hit_masks) {
+		fprintf(stderr, "Failed to allocate the point benchmark!\n");
+		return 0;
+	}
+
+	SeedRandom(options->seed);
+	u64 tested = 0;
+	u64 mismatches = 0;
+	for (i32 round = 0; round < POINTS_BENCH_RANDOM_ROUNDS; round++) {
+		MeteorPool_Clear(&meteors);
+		for (i32 i = 0; i < POINTS_BENCH_RANDOM_CIRCLES; i++) {
+			i32 meteor = MeteorPool_Add(&meteors);
+			meteors.x[meteor] = (f32)GenerateRandomNumber(0, 1279999) / 1000.0f;
+			meteors.y[meteor] = (f32)GenerateRandomNumber(0, 959999) / 1000.0f;
+			meteors.radius[meteor] = (f32)GenerateRandomNumber(0, 63);
+		}
+		// one circle's edge, give or take a few thousandths of a pixel
+		i32 target = GenerateRandomNumber(0, POINTS_BENCH_RANDOM_CIRCLES - 1);
+		Point points[MISSILE_CORNER_COUNT];
+		for (i32 k = 0; k < MISSILE_CORNER_COUNT; k++) {
+			f32 angle = (f32)GenerateRandomNumber(0, 62831) / 10000.0f;
+			f32 distance = meteors.radius[target] + 1.0f + ((f32)GenerateRandomNumber(-3000, 3000) / 1000000.0f);
+			points[k].x = meteors.x[target] + (my_cos(angle) * distance);
+			points[k].y = meteors.y[target] + (my_sin(angle) * distance);
+		}
+		for (i32 point_count = 1; point_count <= MISSILE_CORNER_COUNT; point_count++) {
+			PointsInsideCircles(points, point_count, meteors.x, meteors.y, meteors.radius, meteors.count, hit_masks);
+			for (i32 i = 0; i < meteors.count; i++) {
+				Vec2 position = { meteors.x[i], meteors.y[i] };
+				b8 expected = Linux_AnyPointsInsideCircle((i32)meteors.radius[i], position, points, point_count);
+				b8 got = (hit_masks[i / 32] >> (i % 32)) & 1;
+				mismatches += expected != got;
+				tested += 1;
+			}
+		}
+	}
+	printf("random circles: %llu tested, %llu mismatches\n", (unsigned long long)tested,
+		(unsigned long long)mismatches);
+	all_correct = all_correct && mismatches == 0;
+
+	i32 counts[] = { 24, 1024, 10240 };
+	i32 point_counts[] = { 3, MISSILE_CORNER_COUNT };
+	i32 passes = Max2(options->frame_count / 10, 1);
+	printf("points inside circles: x %d passes\n", passes);
+	printf("  circles  points  hits  floor ns/pair  squared ns/pair  speedup  match\n");
+	for (i32 c = 0; c < (i32)(sizeof(counts) / sizeof(counts[0])); c++) {
+		SeedRandom(options->seed + (u32)c);
+		MeteorPool_Clear(&meteors);
+		for (i32 i = 0; i < counts[c]; i++) {
+			i32 meteor = MeteorPool_Add(&meteors);
+			meteors.x[meteor] = (f32)GenerateRandomNumber(0, options->width - 1);
+			meteors.y[meteor] = (f32)GenerateRandomNumber(0, options->height - 1);
+			meteors.radius[meteor] = (f32)GenerateRandomNumber(15, 49);
+		}
+		for (i32 p = 0; p < (i32)(sizeof(point_counts) / sizeof(point_counts[0])); p++) {
+			i32 point_count = point_counts[p];
+			Point points[MISSILE_CORNER_COUNT];
+			for (i32 k = 0; k < point_count; k++) {
+				points[k].x = (f32)GenerateRandomNumber(0, options->width - 1);
+				points[k].y = (f32)GenerateRandomNumber(0, options->height - 1);
+			}
+
+			i32 hits[2] = {0};
+			u64 times[2] = {0};
+			for (i32 run = 0; run < 2; run++) {
+				b8 squared = run == 1;
+				u64 begin = Linux_GetNanoseconds();
+				for (i32 pass = 0; pass < passes; pass++) {
+					i32 hit_count = 0;
+					if (squared) {
+						PointsInsideCircles(points, point_count, meteors.x, meteors.y, meteors.radius, meteors.count,
+							hit_masks);
+						for (i32 word = 0; word < (meteors.count + 31) / 32; word++) {
+							hit_count += __builtin_popcount(hit_masks[word]);
+						}
+					} else {
+						for (i32 i = 0; i < meteors.count; i++) {
+							Vec2 position = { meteors.x[i], meteors.y[i] };
+							hit_count += Linux_AnyPointsInsideCircle((i32)meteors.radius[i], position, points, point_count);
+						}
+					}
+					hits[run] = hit_count;
+				}
+				times[run] = Linux_GetNanoseconds() - begin;
+			}
+
+			b8 match = hits[0] == hits[1];
+			all_correct = all_correct && match;
+			f64 pairs = (f64)passes * meteors.count;
+			f64 floor_ns = (f64)times[0] / pairs;
+			f64 squared_ns = (f64)times[1] / pairs;
+			printf("  %7d  %6d  %4d  %13.2f  %15.2f  %6.2fx  %s\n", meteors.count, point_count, hits[0], floor_ns,
+				squared_ns, floor_ns / squared_ns, match ? "yes" : "NO");
+		}
+	}
+
+	MyFree(hit_masks);
+	EntityPools_Destroy(&meteors, &unused_missiles, pool_memory);
+	return all_correct;
+}
+
+#define SHIP_BENCH_ROUNDS 2000
+#define SHIP_BENCH_CIRCLES 1031
+// how close to the edge of reach a circle is let off disagreeing with the
+// double precision answer, in pixels
+#define SHIP_BENCH_EDGE 0.001
+
+// Distance from (x, y) to the triangle, 0 inside it, in doubles
+static f64 Linux_TriangleDistance(Triangle *triangle, f64 x, f64 y) {
+	Point *corners = (Point*)triangle;
+	f64 closest = 1.0e300;
+	i32 positive = 0;
+	i32 negative = 0;
+	for (i32 k = 0; k < 3; k++) {
+		f64 start_x = corners[k].x;
+		f64 start_y = corners[k].y;
+		f64 edge_x = corners[(k + 1) % 3].x - start_x;
+		f64 edge_y = corners[(k + 1) % 3].y - start_y;
+		f64 dx = x - start_x;
+		f64 dy = y - start_y;
+		f64 along = ((dx * edge_x) + (dy * edge_y)) / ((edge_x * edge_x) + (edge_y * edge_y));
+		along = along < 0.0 ? 0.0 : (along > 1.0 ? 1.0 : along);
+		f64 off_x = dx - (along * edge_x);
+		f64 off_y = dy - (along * edge_y);
+		f64 distance = sqrt((off_x * off_x) + (off_y * off_y));
+		closest = distance < closest ? distance : closest;
+		f64 cross = (edge_x * dy) - (edge_y * dx);
+		positive += cross > 0.0;
+		negative += cross < 0.0;
+	}
+	return (positive == 0 || negative == 0) ? 0.0 : closest;
+}
+
+// Throws meteors at ships at random angles and checks TriangleTouchesCircles
+// against the distance to the triangle in doubles, against itself one circle
+// at a time, and that it finds every meteor the corner test does. Then times
+// it against the corner test it replaced in UpdateGame.
+static b8 Linux_BenchmarkShip(Linux_HeadlessOptions *options) {
+	MeteorPool meteors;
+	MissilePool unused_missiles;
+	void *pool_memory = EntityPools_Create(&meteors, 10240, &unused_missiles, 1);
+	u32 *hit_masks = (u32*)MyAlloc(((meteors.capacity + 31) / 32) * sizeof(u32));
+	u32 *corner_masks = (u32*)MyAlloc(((meteors.capacity + 31) / 32) * sizeof(u32));
+	if (!pool_memory || !hit_masks || !corner_masks) {
+		fprintf(stderr, "Failed to allocate the ship benchmark!\n");
+		return 0;
+	}
+
+	SeedRandom(options->seed);
+	u64 tested = 0;
+	u64 triangle_hits = 0;
+	u64 corner_hits = 0;
+	u64 corners_missed = 0;
+	u64 wrong = 0;
+	u64 paths_differ = 0;
+	for (i32 round = 0; round < SHIP_BENCH_ROUNDS; round++) {
+		f32 rotation = (f32)GenerateRandomNumber(0, 62831) / 10000.0f;
+		Triangle ship = MakeShipTriangle(rotation, 640.0f, 480.0f);
+		MeteorPool_Clear(&meteors);
+		for (i32 i = 0; i < SHIP_BENCH_CIRCLES; i++) {
+			i32 meteor = MeteorPool_Add(&meteors);
+			meteors.x[meteor] = 640.0f + ((f32)GenerateRandomNumber(-80000, 80000) / 1000.0f);
+			meteors.y[meteor] = 480.0f + ((f32)GenerateRandomNumber(-80000, 80000) / 1000.0f);
+			meteors.radius[meteor] = (f32)GenerateRandomNumber(0, 49);
+		}
+		TriangleTouchesCircles(&ship, meteors.x, meteors.y, meteors.radius, meteors.count, hit_masks);
+		PointsInsideCircles((Point*)&ship, 3, meteors.x, meteors.y, meteors.radius, meteors.count, corner_masks);
+		for (i32 i = 0; i < meteors.count; i++) {
+			b8 touches = (hit_masks[i / 32] >> (i % 32)) & 1;
+			b8 corner_in = (corner_masks[i / 32] >> (i % 32)) & 1;
+			u32 alone = 0;
+			TriangleTouchesCircles(&ship, meteors.x + i, meteors.y + i, meteors.radius + i, 1, &alone);
+			paths_differ += alone != (u32)touches;
+			corners_missed += corner_in && !touches;
+			triangle_hits += touches;
+			corner_hits += corner_in;
+
+			// the distance floored at most the radius, as for points
+			f64 distance = Linux_TriangleDistance(&ship, meteors.x[i], meteors.y[i]);
+			f64 reach = (f64)meteors.radius[i] + 1.0;
+			b8 expected = distance < reach;
+			if ((touches != expected) && (fabs(distance - reach) > SHIP_BENCH_EDGE)) {
+				wrong += 1;
+			}
+			tested += 1;
+		}
+	}
+	printf("ship against meteors: %llu tested, %llu touching, %llu with a corner inside\n",
+		(unsigned long long)tested, (unsigned long long)triangle_hits, (unsigned long long)corner_hits);
+	printf("  %llu wrong, %llu corner hits missed, %llu differ one at a time\n", (unsigned long long)wrong,
+		(unsigned long long)corners_missed, (unsigned long long)paths_differ);
+	b8 all_correct = (wrong == 0) && (corners_missed == 0) && (paths_differ == 0);
+
+	i32 counts[] = { 24, 1024, 10240 };
+	i32 passes = Max2(options->frame_count / 10, 1);
+	Triangle ship = MakeShipTriangle(1.0f, options->width / 2.0f, options->height / 2.0f);
+	printf("ship collision: x %d passes\n", passes);
+	printf("  meteors  corner hits  triangle hits  corners ns/meteor  triangle ns/meteor  ratio\n");
+	for (i32 c = 0; c < (i32)(sizeof(counts) / sizeof(counts[0])); c++) {
+		SeedRandom(options->seed + (u32)c);
+		MeteorPool_Clear(&meteors);
+		for (i32 i = 0; i < counts[c]; i++) {
+			i32 meteor = MeteorPool_Add(&meteors);
+			meteors.x[meteor] = (f32)GenerateRandomNumber(0, options->width - 1);
+			meteors.y[meteor] = (f32)GenerateRandomNumber(0, options->height - 1);
+			meteors.radius[meteor] = (f32)GenerateRandomNumber(15, 49);
+		}
+
+		i32 hits[2] = {0};
+		u64 times[2] = {0};
+		for (i32 run = 0; run < 2; run++) {
+			b8 whole_triangle = run == 1;
+			u64 begin = Linux_GetNanoseconds();
+			for (i32 pass = 0; pass < passes; pass++) {
+				if (whole_triangle) {
+					TriangleTouchesCircles(&ship, meteors.x, meteors.y, meteors.radius, meteors.count, hit_masks);
+				} else {
+					PointsInsideCircles((Point*)&ship, 3, meteors.x, meteors.y, meteors.radius, meteors.count,
+						hit_masks);
+				}
+				i32 hit_count = 0;
+				for (i32 word = 0; word < (meteors.count + 31) / 32; word++) {
+					hit_count += __builtin_popcount(hit_masks[word]);
+				}
+				hits[run] = hit_count;
+			}
+			times[run] = Linux_GetNanoseconds() - begin;
+		}
+
+		f64 corners_ns = (f64)times[0] / passes / meteors.count;
+		f64 triangle_ns = (f64)times[1] / passes / meteors.count;
+		printf("  %7d  %11d  %13d  %17.2f  %18.2f  %5.2fx\n", meteors.count, hits[0], hits[1], corners_ns,
+			triangle_ns, triangle_ns / corners_ns);
+	}
+
+	MyFree(hit_masks);
+	MyFree(corner_masks);
+	EntityPools_Destroy(&meteors, &unused_missiles, pool_memory);
+	return all_correct;
+}
+
+#define MATH_BENCH_VALUE_COUNT 65536
+
+typedef enum {
+	Linux_MathFunction_Sin,
+	Linux_MathFunction_Cos,
+	Linux_MathFunction_Atan2,
+	Linux_MathFunction_Acos,
+	Linux_MathFunction_Sqrt,
+
+	Linux_MathFunction_Count
+} Linux_MathFunction;
+
+static char *Linux_MathFunctionNames[Linux_MathFunction_Count] = { "sin", "cos", "atan2", "acos", "sqrt" };
+// the bounds documented in simd_math.h, relative for sqrt and absolute for the rest
+static f64 Linux_MathMaxErrors[Linux_MathFunction_Count] = { 1.0e-7, 1.0e-7, 3.0e-7, 3.0e-7, 6.0e-8 };
+
+typedef enum {
+	Linux_MathVersion_Libm,
+	Linux_MathVersion_Scalar,
+	Linux_MathVersion_Batched,
+
+	Linux_MathVersion_Count
+} Linux_MathVersion;
+
+// b is only used by atan2, as its x
+static void Linux_RunMath(Linux_MathFunction function, Linux_MathVersion version, f32 *out, f32 *a, f32 *b, i32 count) {
+	switch (function) {
+		case Linux_MathFunction_Sin: {
+			if (version == Linux_MathVersion_Libm) {
+				for (i32 i = 0; i < count; i++) { out[i] = sinf(a[i]); }
+			} else if (version == Linux_MathVersion_Scalar) {
+				for (i32 i = 0; i < count; i++) { out[i] = Math_Sin(a[i]); }
+			} else {
+				Math_SinArray(out, a, count);
+			}
+		} break;
+		case Linux_MathFunction_Cos: {
+			if (version == Linux_MathVersion_Libm) {
+				for (i32 i = 0; i < count; i++) { out[i] = cosf(a[i]); }
+			} else if (version == Linux_MathVersion_Scalar) {
+				for (i32 i = 0; i < count; i++) { out[i] = Math_Cos(a[i]); }
+			} else {
+				Math_CosArray(out, a, count);
+			}
+		} break;
+		case Linux_MathFunction_Atan2: {
+			if (version == Linux_MathVersion_Libm) {
+				for (i32 i = 0; i < count; i++) { out[i] = atan2f(a[i], b[i]); }
+			} else if (version == Linux_MathVersion_Scalar) {
+				for (i32 i = 0; i < count; i++) { out[i] = Math_Atan2(a[i], b[i]); }
+			} else {
+				Math_Atan2Array(out, a, b, count);
+			}
+		} break;
+		case Linux_MathFunction_Acos: {
+			if (version == Linux_MathVersion_Libm) {
+				for (i32 i = 0; i < count; i++) { out[i] = acosf(a[i]); }
+			} else if (version == Linux_MathVersion_Scalar) {
+				for (i32 i = 0; i < count; i++) { out[i] = Math_Acos(a[i]); }
+			} else {
+				Math_AcosArray(out, a, count);
+			}
+		} break;
+		case Linux_MathFunction_Sqrt: {
+			if (version == Linux_MathVersion_Libm) {
+				for (i32 i = 0; i < count; i++) { out[i] = sqrtf(a[i]); }
+			} else if (version == Linux_MathVersion_Scalar) {
+				for (i32 i = 0; i < count; i++) { out[i] = Math_Sqrt(a[i]); }
+			} else {
+				Math_SqrtArray(out, a, count);
+			}
+		} break;
+		default: break;
+	}
+}
+
+static f64 Linux_MathReference(Linux_MathFunction function, f32 a, f32 b) {
+	switch (function) {
+		case Linux_MathFunction_Sin: return sin((f64)a);
+		case Linux_MathFunction_Cos: return cos((f64)a);
+		case Linux_MathFunction_Atan2: return atan2((f64)a, (f64)b);
+		case Linux_MathFunction_Acos: return acos((f64)a);
+		case Linux_MathFunction_Sqrt: return sqrt((f64)a);
+		default: return 0.0;
+	}
+}
+
+// uniform in [min, max]
+static f32 Linux_RandomFloat(f32 min, f32 max) {
+	f32 t = (f32)GenerateRandomNumber(0, 1 << 24) / (f32)(1 << 24);
+	return min + ((max - min) * t);
+}
+
+// Times libm, the scalar polynomials and the batched ones on random inputs
+// over the documented ranges. Checks every batched value is bit for bit the
+// scalar one, including counts that end on the scalar tail, and that the
+// error against double precision libm stays under the documented bound.
+static b8 Linux_BenchmarkMath(Linux_HeadlessOptions *options) {
+	f32 *a = (f32*)MyAlloc(MATH_BENCH_VALUE_COUNT * sizeof(f32));
+	f32 *b = (f32*)MyAlloc(MATH_BENCH_VALUE_COUNT * sizeof(f32));
+	f32 *outputs[Linux_MathVersion_Count];
+	for (i32 v = 0; v < Linux_MathVersion_Count; v++) {
+		outputs[v] = (f32*)MyAlloc(MATH_BENCH_VALUE_COUNT * sizeof(f32));
+	}
+	if (!a || !b || !outputs[0] || !outputs[1] || !outputs[2]) {
+		fprintf(stderr, "Failed to allocate the math benchmark!\n");
+		return 0;
+	}
+	i32 passes = Max2(options->frame_count / 100, 1);
+
+#if __AVX2__
+	char *width = "AVX2, 8 wide";
+#else
+	char *width = "SSE2, 4 wide";
+#endif
+	printf("batched math: %d random values x %d passes, %s\n", MATH_BENCH_VALUE_COUNT, passes, width);
+	printf("  function  libm ns  scalar ns  batched ns  speedup  libm error  max error  lanes match\n");
+	printf("  (errors against double precision libm, relative for sqrt and absolute for the rest)\n");
+	b8 all_correct = 1;
+	for (i32 f = 0; f < Linux_MathFunction_Count; f++) {
+		Linux_MathFunction function = (Linux_MathFunction)f;
+		SeedRandom(options->seed + (u32)f);
+		for (i32 i = 0; i < MATH_BENCH_VALUE_COUNT; i++) {
+			switch (function) {
+				case Linux_MathFunction_Sin:
+				case Linux_MathFunction_Cos: a[i] = Linux_RandomFloat(-8192.0f, 8192.0f); break;
+				case Linux_MathFunction_Atan2: {
+					a[i] = Linux_RandomFloat(-1000.0f, 1000.0f);
+					b[i] = Linux_RandomFloat(-1000.0f, 1000.0f);
+				} break;
+				case Linux_MathFunction_Acos: a[i] = Linux_RandomFloat(-1.0f, 1.0f); break;
+				default: a[i] = Linux_RandomFloat(0.0f, 1000000.0f); break;
+			}
+		}
+
+		f64 version_ns[Linux_MathVersion_Count];
+		for (i32 v = 0; v < Linux_MathVersion_Count; v++) {
+			u64 begin = Linux_GetNanoseconds();
+			for (i32 pass = 0; pass < passes; pass++) {
+				Linux_RunMath(function, (Linux_MathVersion)v, outputs[v], a, b, MATH_BENCH_VALUE_COUNT);
+			}
+			version_ns[v] = (f64)(Linux_GetNanoseconds() - begin) / ((f64)MATH_BENCH_VALUE_COUNT * passes);
+		}
+
+		f64 libm_error = 0.0;
+		f64 max_error = 0.0;
+		for (i32 i = 0; i < MATH_BENCH_VALUE_COUNT; i++) {
+			f64 reference = Linux_MathReference(function, a[i], b[i]);
+			f64 scale = (function == Linux_MathFunction_Sqrt && reference > 0.0) ? reference : 1.0;
+			f64 libm_difference = fabs((f64)outputs[Linux_MathVersion_Libm][i] - reference) / scale;
+			f64 difference = fabs((f64)outputs[Linux_MathVersion_Batched][i] - reference) / scale;
+			libm_error = libm_difference > libm_error ? libm_difference : libm_error;
+			max_error = difference > max_error ? difference : max_error;
+		}
+
+		u64 value_size = MATH_BENCH_VALUE_COUNT * sizeof(f32);
+		b8 lanes_match = memcmp(outputs[Linux_MathVersion_Scalar], outputs[Linux_MathVersion_Batched], value_size) == 0;
+		// counts that aren't a multiple of the width, starting off the alignment too
+		for (i32 count = 1; count <= 19 && lanes_match; count++) {
+			f32 *batched = outputs[Linux_MathVersion_Batched];
+			Linux_RunMath(function, Linux_MathVersion_Batched, batched + count, a + count, b + count, count);
+			lanes_match = memcmp(batched + count, outputs[Linux_MathVersion_Scalar] + count, count * sizeof(f32)) == 0;
+		}
+
+		b8 correct = lanes_match && max_error <= Linux_MathMaxErrors[f];
+		all_correct = all_correct && correct;
+		printf("  %-8s  %7.2f  %9.2f  %10.2f  %6.2fx  %10.1e  %9.1e  %s\n", Linux_MathFunctionNames[f],
+			version_ns[Linux_MathVersion_Libm], version_ns[Linux_MathVersion_Scalar], version_ns[Linux_MathVersion_Batched],
+			version_ns[Linux_MathVersion_Libm] / version_ns[Linux_MathVersion_Batched], libm_error, max_error,
+			correct ? "yes" : (lanes_match ? "yes, ERROR TOO BIG" : "NO"));
+	}
+
+	MyFree(a);
+	MyFree(b);
+	for (i32 v = 0; v < Linux_MathVersion_Count; v++) {
+		MyFree(outputs[v]);
+	}
+	return all_correct;
+}
+
+static int CompareU64(const void *a, const void *b) {
+	u64 x = *(const u64*)a;
+	u64 y = *(const u64*)b;
+	return (x > y) - (x < y);
+}
+
+int main(int argc, char **argv) {
+	Linux_HeadlessOptions options = {0};
+	options.frame_count = HEADLESS_DEFAULT_FRAME_COUNT;
+	options.width = DEFAULT_WINDOW_WIDTH;
+	options.height = DEFAULT_WINDOW_HEIGHT;
+	options.seed = 1;
+	options.frame_time_ms = HEADLESS_DEFAULT_FRAME_TIME_MS;
+	options.capture_format = FrameCaptureFormat_Y4M;
+	options.capture_slots = HEADLESS_DEFAULT_CAPTURE_SLOTS;
+	options.tile_size = RENDER_TILE_SIZE;
+	options.meteor_count = INITIAL_METEOR_COUNT;
+	options.missile_capacity = MISSILE_POOL_SIZE;
+
+	if (!Linux_ParseOptions(argc, argv, &options)) {
+		return 1;
+	}
+	if (!options.meteor_capacity) {
+		// the same headroom the game has by default, 32 for 24 meteors
+		options.meteor_capacity = Max2(options.meteor_count + (options.meteor_count / 3), 1);
+	}
+	if (options.meteor_count < 0 || options.meteor_capacity < 1 || options.missile_capacity < 1) {
+		fprintf(stderr, "Meteor and missile counts must be positive!\n");
+		return 1;
+	}
+
+	gConsoleOutputEnabled = options.verbose;
+	gShowProfileOverlay = options.overlay;
+	gFillShip = options.fill_ship;
+	gInitialMeteorCount = options.meteor_count;
+	gMeteorCapacity = options.meteor_capacity;
+	gMissileCapacity = options.missile_capacity;
+	gMeteorsBounce = options.meteor_bounce;
+
+	char character_set[CHARACTER_COUNT + 1] = {0}; // NUL terminated for KDTF_AllocateFont
+	for (i32 i = 0; i < CHARACTER_COUNT; i++) {
+		character_set[i] = '!' + (char)i;
+	}
+
+	gFont = KDTF_AllocateFont(
+		"JetBrainsMono-Regular.ttf", character_set, true,
+		false, 32.0f, 32.0f, 32.0f, 1.0f,
+		MyAlloc, MyFree,
+		MyAlloc, MyFree);
+	if (gFont.load_error) {
+		fprintf(stderr, "Failed to load font file!\n");
+		return 1;
+	}
+
+	gDrawSprites = !options.no_sprites;
+	if (gDrawSprites && !Sprites_Init()) {
+		fprintf(stderr, "Failed to build the sprite atlas, drawing without sprites\n");
+	}
+
+	InputRecording recording = {0};
+	if (options.replay_path) {
+		void *file_contents = 0;
+		u64 file_size = 0;
+		if (!Linux_ReadEntireFile(options.replay_path, &file_contents, &file_size)) {
+			return 1;
+		}
+		if (!InputRecording_Load(&recording, file_contents, file_size)) {
+			fprintf(stderr, "%s is not a valid input recording!\n", options.replay_path);
+			return 1;
+		}
+
+		InputRecordingHeader *header = InputRecording_Header(&recording);
+		if (header->step_count == 0) {
+			fprintf(stderr, "%s has no steps!\n", options.replay_path);
+			return 1;
+		}
+		options.width = header->width;
+		options.height = header->height;
+		options.seed = header->seed;
+		gInitialMeteorCount = header->initial_meteor_count;
+		gMeteorCapacity = header->meteor_capacity;
+		gMissileCapacity = header->missile_capacity;
+
+		// enough frames to run every step, the replay stops itself when it's done
+		f32 replay_seconds = (f32)header->step_count * SIMULATION_TIMESTEP;
+		options.frame_count = (i32)((replay_seconds * 1000.0f) / options.frame_time_ms) + 2;
+	}
+
+	WindowWidth = options.width;
+	WindowHeight = options.height;
+
+	if (options.bench_tiles) {
+		return Linux_BenchmarkTiles(&options) ? 0 : 1;
+	}
+	if (options.bench_lines) {
+		return Linux_BenchmarkLines(&options) ? 0 : 1;
+	}
+	if (options.bench_circles) {
+		return Linux_BenchmarkCircles(&options) ? 0 : 1;
+	}
+	if (options.bench_missiles) {
+		return Linux_BenchmarkMissiles(&options) ? 0 : 1;
+	}
+	if (options.bench_math) {
+		return Linux_BenchmarkMath(&options) ? 0 : 1;
+	}
+	if (options.bench_transform) {
+		return Linux_BenchmarkTransform(&options) ? 0 : 1;
+	}
+	if (options.bench_entities) {
+		return Linux_BenchmarkEntities(&options) ? 0 : 1;
+	}
+	if (options.bench_pools) {
+		return Linux_BenchmarkPools(&options) ? 0 : 1;
+	}
+	if (options.bench_broadphase) {
+		return Linux_BenchmarkBroadphase(&options) ? 0 : 1;
+	}
+	if (options.bench_bounce) {
+		return Linux_BenchmarkBounce(&options) ? 0 : 1;
+	}
+	if (options.bench_swept) {
+		return Linux_BenchmarkSwept(&options) ? 0 : 1;
+	}
+	if (options.bench_points) {
+		return Linux_BenchmarkPoints(&options) ? 0 : 1;
+	}
+	if (options.bench_ship) {
+		return Linux_BenchmarkShip(&options) ? 0 : 1;
+	}
+
+	Linux_FrameOutput output = {0};
+	output.surface = MakeDrawSurface(0, options.width, options.height);
+
+	SharedFramebuffer shared_framebuffer = {0};
+	u32 *offscreen_pixels = 0;
+	if (options.shm_name) {
+		if (!SharedFramebuffer_Create(&shared_framebuffer, options.shm_name, output.surface.width, output.surface.height)) {
+			fprintf(stderr, "Failed to create shared framebuffer %s!\n", options.shm_name);
+			return 1;
+		}
+		output.shared_framebuffer = &shared_framebuffer;
+	} else {
+		offscreen_pixels = (u32*)MyAlloc((u64)output.surface.width * output.surface.height * sizeof(u32));
+		output.surface.pixels = offscreen_pixels;
+	}
+
+	u64 *frame_times = (u64*)MyAlloc((u64)options.frame_count * sizeof(u64));
+	if ((!options.shm_name && !offscreen_pixels) || !frame_times) {
+		fprintf(stderr, "Failed to allocate the draw surface!\n");
+		return 1;
+	}
+
+	FrameCapture capture = {0};
+	if (options.capture_path) {
+		// game time per frame as a rational frame rate, in thousandths of a frame
+		u32 frame_rate = (u32)((1000000.0f / options.frame_time_ms) + 0.5f);
+		if (!FrameCapture_Open(&capture, options.capture_path, options.capture_format, output.surface.width, output.surface.height,
+			frame_rate, 1000, (u32)options.capture_slots)) {
+			fprintf(stderr, "Failed to start capturing to %s!\n", options.capture_path);
+			return 1;
+		}
+		output.capture = &capture;
+	}
+
+	if (options.render_threads) {
+		if (!JobSystem_Start(&gJobs, options.render_threads - 1)) {
+			fprintf(stderr, "Failed to start %d render threads!\n", options.render_threads);
+			return 1;
+		}
+		output.jobs = &gJobs;
+		output.tile_size = options.tile_size;
+	}
+	output.full_redraw = options.full_redraw;
+
+	Linux_RenderThread render_thread = {0};
+	if (options.pipeline && !Linux_StartRenderThread(&render_thread, &output)) {
+		fprintf(stderr, "Failed to start the render thread!\n");
+		return 1;
+	}
+	static RenderCommandBuffer commands;
+	if (!options.pipeline && !RenderCommandBuffer_Register(&commands)) {
+		fprintf(stderr, "Failed to register the command buffer!\n");
+		return 1;
+	}
+
+	if (options.replay_path) {
+		InputRecording_BeginPlayback(&recording);
+	} else if (options.record_path) {
+		InputRecording_BeginRecording(&recording, options.seed, options.width, options.height);
+	} else {
+		InputRecording_BeginSession(options.seed);
+	}
+
+	i32 frames_run = 0;
+	u64 run_begin = Linux_GetNanoseconds();
+	for (i32 frame = 0; frame < options.frame_count && !gShouldCloseWindow; frame++) {
+		if (options.replay_path) {
+			if (InputRecording_PlaybackFinished(&recording)) {
+				break;
+			}
+		} else {
+			Linux_SynthesizeInput(frame);
+		}
+
+		u64 frame_begin = Linux_GetNanoseconds();
+		Profile_BeginFrame();
+		f32 alpha = SimulateFrame(options.frame_time_ms / 1000.0f, output.surface.width, output.surface.height);
+		if (options.pipeline) {
+			Linux_PublishSnapshot(&render_thread, alpha, frame == 0);
+		} else {
+			BuildRenderCommands(&commands, alpha, output.surface.width, output.surface.height);
+			Linux_RenderFrame(&output, &commands);
+		}
+		frame_times[frame] = Linux_GetNanoseconds() - frame_begin;
+		Profile_EndFrame((f32)frame_times[frame] / 1e9f);
+		frames_run++;
+	}
+	if (options.pipeline) {
+		Linux_StopRenderThread(&render_thread);
+	}
+	u64 run_elapsed = Linux_GetNanoseconds() - run_begin;
+
+	if (frames_run == 0) {
+		fprintf(stderr, "No frames were run!\n");
+		return 1;
+	}
+
+	u64 total = 0;
+	for (i32 i = 0; i < frames_run; i++) {
+		total += frame_times[i];
+	}
+	qsort(frame_times, frames_run, sizeof(u64), CompareU64);
+
+	f64 seconds = (f64)run_elapsed / 1e9;
+	printf("frames:    %d (%dx%d, seed %u%s)\n", frames_run, output.surface.width, output.surface.height, options.seed,
+		options.replay_path ? ", replay" : "");
+	if (options.pipeline) {
+		printf("rendered:  %llu frames on the render thread\n", render_thread.frames_rendered);
+	}
+	printf("elapsed:   %.3f s\n", seconds);
+	printf("fps:       %.1f\n", (f64)frames_run / seconds);
+	printf("frame avg: %.3f ms\n", ((f64)total / frames_run) / 1e6);
+	printf("frame min: %.3f ms\n", (f64)frame_times[0] / 1e6);
+	printf("frame p50: %.3f ms\n", (f64)frame_times[frames_run / 2] / 1e6);
+	printf("frame p99: %.3f ms\n", (f64)frame_times[(frames_run * 99) / 100] / 1e6);
+	printf("frame max: %.3f ms\n", (f64)frame_times[frames_run - 1] / 1e6);
+	printf("checksum:  %08x\n", Linux_ChecksumSurface(&output.surface));
+	if (!options.full_redraw) {
+		u64 frames_tracked = 0;
+		u64 pixels_redrawn = 0;
+		for (i32 i = 0; i < SHARED_FRAMEBUFFER_BUFFER_COUNT; i++) {
+			frames_tracked += output.dirty[i].frames;
+			pixels_redrawn += output.dirty[i].pixels_redrawn;
+		}
+		u64 pixel_count = (u64)output.surface.width * output.surface.height;
+		printf("redrawn:   %.1f%% of pixels per frame (%llu of %d frames tracked)\n",
+			frames_tracked ? (100.0 * pixels_redrawn) / ((f64)frames_tracked * pixel_count) : 100.0,
+			frames_tracked, frames_run);
+	}
+
+	f64 seconds_per_cycle = Profile_SecondsPerCycle();
+	if (seconds_per_cycle > 0.0) {
+		printf("phase averages:\n");
+		for (i32 block = 0; block < TimedBlock_Count; block++) {
+			f64 block_ms = ((f64)gProfile.total_block_cycles[block] * seconds_per_cycle * 1e3) / gProfile.total_frames;
+			printf("  %-17s %8.4f ms\n", TimedBlockNames[block], block_ms);
+		}
+	}
+
+	if (options.capture_path) {
+		u64 submitted = capture.frames_submitted;
+		u64 dropped = capture.frames_dropped;
+		b8 capture_ok = FrameCapture_Close(&capture);
+		printf("captured:  %llu of %llu frames to %s (%llu dropped, %.1f MB)\n",
+			capture.frames_written, submitted, options.capture_path, dropped,
+			(f64)capture.bytes_written / (1024.0 * 1024.0));
+		if (!capture_ok) {
+			fprintf(stderr, "Failed to write every frame to %s!\n", options.capture_path);
+			return 1;
+		}
+	}
+
+	if (options.record_path) {
+		if (!Linux_WriteEntireFile(options.record_path, recording.data, recording.size)) {
+			return 1;
+		}
+		printf("recorded:  %u steps to %s\n", InputRecording_Header(&recording)->step_count, options.record_path);
+	}
+
+	if (options.render_threads) {
+		JobSystem_Stop(&gJobs);
+		RenderTileBins_Free(&output.tile_bins);
+	}
+	for (i32 i = 0; i < SHARED_FRAMEBUFFER_BUFFER_COUNT; i++) {
+		DirtyTracker_Free(&output.dirty[i]);
+	}
+	MyFree(frame_times);
+	if (options.shm_name) {
+		SharedFramebuffer_Destroy(&shared_framebuffer);
+	} else {
+		MyFree(offscreen_pixels);
+	}
+	return 0;
+}
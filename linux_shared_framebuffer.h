@@ -0,0 +1,222 @@
+#ifndef LINUX_SHARED_FRAMEBUFFER_H
+#define LINUX_SHARED_FRAMEBUFFER_H
+
+// Double buffered framebuffer in POSIX shared memory.
+//
+// The game renders straight into one of the two buffers in the segment and
+// then publishes it, so other processes on the same host can read frames in
+// place with no copy and no syscall per frame.
+//
+// Segment layout:
+//   SharedFramebufferHeader (padded to SHARED_FRAMEBUFFER_ALIGNMENT)
+//   buffer 0: height * pitch bytes of BGRA pixels (0xAARRGGBB as u32)
+//   buffer 1: same as buffer 0, at header->buffer_offsets[1]
+//
+// Every buffer is guarded by its own sequence counter (a seqlock), which is
+// odd while the game is drawing into it. header->latest_buffer is the index
+// of the most recently published buffer and header->frame_sequence counts
+// published frames, so a reader can poll it to see if there is a new frame:
+//
+//   SharedFramebufferReader reader = {0};
+//   SharedFramebuffer_OpenReader(&reader, "/asteroids");
+//   u64 sequence;
+//   u32 *pixels = SharedFramebuffer_BeginRead(&reader, &sequence);
+//   ... use pixels ...
+//   if (!SharedFramebuffer_EndRead(&reader, sequence)) { the frame tore, drop it }
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "base.h"
+
+#define SHARED_FRAMEBUFFER_MAGIC 0x42465341 // "ASFB"
+#define SHARED_FRAMEBUFFER_VERSION 1
+#define SHARED_FRAMEBUFFER_BUFFER_COUNT 2
+#define SHARED_FRAMEBUFFER_ALIGNMENT 4096
+
+typedef struct {
+	u32 magic;
+	u32 version;
+	u32 width;
+	u32 height;
+	u32 pitch; // bytes between rows
+	u32 buffer_count;
+	u64 buffer_offsets[SHARED_FRAMEBUFFER_BUFFER_COUNT]; // from the start of the segment
+	u64 buffer_sequences[SHARED_FRAMEBUFFER_BUFFER_COUNT]; // odd while the buffer is being drawn
+	u64 frame_sequence; // number of published frames
+	u32 latest_buffer;
+} SharedFramebufferHeader;
+
+typedef struct {
+	char *name;
+	i32 fd;
+	u8 *memory;
+	u64 size;
+	SharedFramebufferHeader *header;
+	u32 back_buffer;
+} SharedFramebuffer;
+
+typedef struct {
+	i32 fd;
+	u8 *memory;
+	u64 size;
+	SharedFramebufferHeader *header;
+	u32 buffer;
+} SharedFramebufferReader;
+
+static u64 SharedFramebuffer_AlignUp(u64 value) {
+	return (value + (SHARED_FRAMEBUFFER_ALIGNMENT - 1)) & ~(u64)(SHARED_FRAMEBUFFER_ALIGNMENT - 1);
+}
+
+// name follows shm_open rules, e.g. "/asteroids"
+// RETURNS: 1 on success
+b8 SharedFramebuffer_Create(SharedFramebuffer *framebuffer, char *name, u32 width, u32 height) {
+	u64 pitch = (u64)width * sizeof(u32);
+	u64 header_size = SharedFramebuffer_AlignUp(sizeof(SharedFramebufferHeader));
+	u64 buffer_size = SharedFramebuffer_AlignUp(pitch * height);
+	u64 size = header_size + (buffer_size * SHARED_FRAMEBUFFER_BUFFER_COUNT);
+
+	i32 fd = shm_open(name, O_CREAT | O_RDWR, 0644);
+	if (fd < 0) {
+		return 0;
+	}
+	if (ftruncate(fd, (off_t)size) != 0) {
+		close(fd);
+		shm_unlink(name);
+		return 0;
+	}
+
+	u8 *memory = (u8*)mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (memory == MAP_FAILED) {
+		close(fd);
+		shm_unlink(name);
+		return 0;
+	}
+
+	SharedFramebufferHeader *header = (SharedFramebufferHeader*)memory;
+	header->width = width;
+	header->height = height;
+	header->pitch = (u32)pitch;
+	header->buffer_count = SHARED_FRAMEBUFFER_BUFFER_COUNT;
+	for (u32 i = 0; i < SHARED_FRAMEBUFFER_BUFFER_COUNT; i++) {
+		header->buffer_offsets[i] = header_size + (buffer_size * i);
+		header->buffer_sequences[i] = 0;
+	}
+	header->frame_sequence = 0;
+	header->latest_buffer = 0;
+	header->version = SHARED_FRAMEBUFFER_VERSION;
+	// readers check the magic last, so it goes in after everything else
+	__atomic_store_n(&header->magic, SHARED_FRAMEBUFFER_MAGIC, __ATOMIC_RELEASE);
+
+	framebuffer->name = name;
+	framebuffer->fd = fd;
+	framebuffer->memory = memory;
+	framebuffer->size = size;
+	framebuffer->header = header;
+	framebuffer->back_buffer = 0;
+	return 1;
+}
+
+void SharedFramebuffer_Destroy(SharedFramebuffer *framebuffer) {
+	munmap(framebuffer->memory, framebuffer->size);
+	close(framebuffer->fd);
+	shm_unlink(framebuffer->name);
+	framebuffer->memory = 0;
+	framebuffer->header = 0;
+}
+
+// RETURNS: the buffer to draw the next frame into, pitch is header->pitch
+u32 *SharedFramebuffer_BeginFrame(SharedFramebuffer *framebuffer) {
+	SharedFramebufferHeader *header = framebuffer->header;
+	u32 index = framebuffer->back_buffer;
+	// odd sequence tells readers the buffer is being overwritten
+	__atomic_add_fetch(&header->buffer_sequences[index], 1, __ATOMIC_ACQ_REL);
+	return (u32*)(framebuffer->memory + header->buffer_offsets[index]);
+}
+
+// Makes the buffer returned by SharedFramebuffer_BeginFrame the latest frame
+void SharedFramebuffer_PublishFrame(SharedFramebuffer *framebuffer) {
+	SharedFramebufferHeader *header = framebuffer->header;
+	u32 index = framebuffer->back_buffer;
+	__atomic_add_fetch(&header->buffer_sequences[index], 1, __ATOMIC_RELEASE);
+	__atomic_store_n(&header->latest_buffer, index, __ATOMIC_RELEASE);
+	__atomic_add_fetch(&header->frame_sequence, 1, __ATOMIC_RELEASE);
+	framebuffer->back_buffer = (index + 1) % SHARED_FRAMEBUFFER_BUFFER_COUNT;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////
+/// Reader side, for capture and monitoring tools
+///
+
+// RETURNS: 1 on success
+b8 SharedFramebuffer_OpenReader(SharedFramebufferReader *reader, char *name) {
+	i32 fd = shm_open(name, O_RDONLY, 0);
+	if (fd < 0) {
+		return 0;
+	}
+
+	struct stat file_info;
+	if (fstat(fd, &file_info) != 0 || (u64)file_info.st_size < sizeof(SharedFramebufferHeader)) {
+		close(fd);
+		return 0;
+	}
+
+	u64 size = (u64)file_info.st_size;
+	u8 *memory = (u8*)mmap(0, size, PROT_READ, MAP_SHARED, fd, 0);
+	if (memory == MAP_FAILED) {
+		close(fd);
+		return 0;
+	}
+
+	SharedFramebufferHeader *header = (SharedFramebufferHeader*)memory;
+	if (__atomic_load_n(&header->magic, __ATOMIC_ACQUIRE) != SHARED_FRAMEBUFFER_MAGIC ||
+		header->version != SHARED_FRAMEBUFFER_VERSION) {
+		munmap(memory, size);
+		close(fd);
+		return 0;
+	}
+
+	reader->fd = fd;
+	reader->memory = memory;
+	reader->size = size;
+	reader->header = header;
+	reader->buffer = 0;
+	return 1;
+}
+
+void SharedFramebuffer_CloseReader(SharedFramebufferReader *reader) {
+	munmap(reader->memory, reader->size);
+	close(reader->fd);
+	reader->memory = 0;
+	reader->header = 0;
+}
+
+// RETURNS: the latest published frame, or 0 if nothing has been published
+//          or the game is drawing into it right now
+u32 *SharedFramebuffer_BeginRead(SharedFramebufferReader *reader, u64 *out_sequence) {
+	SharedFramebufferHeader *header = reader->header;
+	if (__atomic_load_n(&header->frame_sequence, __ATOMIC_ACQUIRE) == 0) {
+		return 0;
+	}
+
+	u32 index = __atomic_load_n(&header->latest_buffer, __ATOMIC_ACQUIRE);
+	u64 sequence = __atomic_load_n(&header->buffer_sequences[index], __ATOMIC_ACQUIRE);
+	if (sequence & 1) {
+		return 0;
+	}
+
+	reader->buffer = index;
+	*out_sequence = sequence;
+	return (u32*)(reader->memory + header->buffer_offsets[index]);
+}
+
+// RETURNS: 1 if the game didn't touch the frame while it was being read
+b8 SharedFramebuffer_EndRead(SharedFramebufferReader *reader, u64 sequence) {
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	u64 current = __atomic_load_n(&reader->header->buffer_sequences[reader->buffer], __ATOMIC_RELAXED);
+	return current == sequence;
+}
+
+#endif
@@ -0,0 +1,535 @@
+#ifndef ASTEROIDS_PARALLEL_H
+#define ASTEROIDS_PARALLEL_H
+
+// A work stealing job system.
+//
+//   JobSystem jobs = {0}; // big, keep it in static storage
+//   JobSystem_Start(&jobs, Platform_ProcessorCount() - 1);
+//
+//   JobCounter counter = {0};
+//   Job job = { Function, data, begin, end };
+//   Job_Submit(&jobs, &job, &counter);  // Function(data, begin, end) on some thread
+//   Job_Wait(&jobs, &counter);          // helps out until every job on the counter is done
+//
+//   ParallelFor(&jobs, count, Function, data); // Function(data, i) for i in [0, count)
+//
+// Every worker thread owns a deque of jobs. A thread pushes the jobs it
+// submits onto the bottom of its own deque and takes work back from the
+// bottom, so nested jobs stay on the thread that made them. Threads that run
+// out of work steal from the top of the other deques. Threads that are not
+// workers (the main thread, the render thread) get a deque of their own the
+// first time they submit, up to JOB_SYSTEM_MAX_EXTERNAL_THREADS of them.
+//
+// A JobCounter counts unfinished jobs and Job_Wait is the fence: it runs
+// queued jobs until the counter drops to zero, so a job can submit and wait
+// on jobs of its own without tying up its thread. Idle workers sleep on a
+// semaphore and are woken one per submitted job.
+
+#if _WIN32
+// windows.h is included by asteroids.c
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <semaphore.h>
+#include <unistd.h>
+#endif
+
+#include <stdint.h>
+
+#include "base.h"
+
+#if _MSC_VER
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL __thread
+#endif
+
+#define JOB_SYSTEM_MAX_WORKERS 63
+#define JOB_SYSTEM_MAX_EXTERNAL_THREADS 4
+#define JOB_SYSTEM_MAX_QUEUES (JOB_SYSTEM_MAX_WORKERS + JOB_SYSTEM_MAX_EXTERNAL_THREADS)
+#define JOB_QUEUE_SIZE 512 // power of two, a full queue runs new jobs right away
+#define PARALLEL_FOR_MAX_JOBS 256
+
+typedef void JobFunction(void *data, i32 begin, i32 end);
+typedef void ParallelForFunction(void *data, i32 index);
+
+typedef struct {
+	volatile u32 pending; // submitted jobs that haven't finished
+} JobCounter;
+
+typedef struct {
+	JobFunction *function;
+	void *data;
+	i32 begin;
+	i32 end;
+	JobCounter *counter; // set by Job_Submit
+} Job;
+
+// Chase-Lev deque. The owner pushes and pops at bottom, thieves take from top.
+// Both only ever increase (apart from a pop that finds the deque empty) and
+// are taken modulo JOB_QUEUE_SIZE. Slots hold Job pointers.
+typedef struct {
+	volatile u64 top;
+	u8 top_padding[56]; // top and bottom go on different cache lines
+	volatile u64 bottom;
+	u8 bottom_padding[56];
+	volatile u64 slots[JOB_QUEUE_SIZE];
+} JobQueue;
+
+struct JobSystem;
+
+typedef struct {
+	struct JobSystem *system;
+	i32 queue_index;
+#if _WIN32
+	HANDLE thread;
+#else
+	pthread_t thread;
+#endif
+} JobWorker;
+
+typedef struct JobSystem {
+	u32 id;
+	i32 worker_count; // not counting the threads that submit and wait
+	volatile u32 external_thread_count;
+	volatile u32 sleeping_count; // workers about to sleep, minus wakeups handed out
+	volatile u32 stop;
+
+	JobWorker workers[JOB_SYSTEM_MAX_WORKERS];
+#if _WIN32
+	HANDLE work_available;
+#else
+	sem_t work_available;
+#endif
+
+	// [0, worker_count) belong to the workers, the rest to external threads
+	JobQueue queues[JOB_SYSTEM_MAX_QUEUES];
+} JobSystem;
+
+typedef struct {
+	u32 system_id; // 0 or a stopped system, the thread has to look up its queue
+	i32 queue_index; // -1 if there was no queue left for the thread
+	u32 random_state;
+} JobThreadContext;
+
+static THREAD_LOCAL JobThreadContext gJobThread;
+static volatile u32 gNextJobSystemId;
+
+i32 Platform_ProcessorCount() {
+#if _WIN32
+	SYSTEM_INFO system_info = {0};
+	GetSystemInfo(&system_info);
+	return (i32)system_info.dwNumberOfProcessors;
+#else
+	long count = sysconf(_SC_NPROCESSORS_ONLN);
+	return count > 0 ? (i32)count : 1;
+#endif
+}
+
+static void Platform_YieldThread() {
+#if _WIN32
+	SwitchToThread();
+#else
+	sched_yield();
+#endif
+}
+
+//////////////////////////////////////////////////////////////////////////////////////
+/// Deque
+///
+
+// Owner only
+// RETURNS: 0 if the queue is full
+static b8 JobQueue_Push(JobQueue *queue, Job *job) {
+	u64 bottom = queue->bottom;
+	u64 top = AtomicLoadU64(&queue->top);
+	if ((bottom - top) >= JOB_QUEUE_SIZE) {
+		return 0;
+	}
+	AtomicStoreU64(&queue->slots[bottom & (JOB_QUEUE_SIZE - 1)], (u64)(uintptr_t)job);
+	// publishes the slot to thieves
+	AtomicStoreU64(&queue->bottom, bottom + 1);
+	return 1;
+}
+
+// Owner only, takes the most recently pushed job
+static Job *JobQueue_Pop(JobQueue *queue) {
+	u64 bottom = queue->bottom - 1;
+	AtomicStoreU64(&queue->bottom, bottom);
+	// the store to bottom has to be visible before top is read, or a thief
+	// and the owner could both take the last job
+	AtomicFence();
+	u64 top = AtomicLoadU64(&queue->top);
+
+	if ((i64)(bottom - top) < 0) {
+		// empty
+		AtomicStoreU64(&queue->bottom, bottom + 1);
+		return 0;
+	}
+
+	Job *job = (Job*)(uintptr_t)AtomicLoadU64(&queue->slots[bottom & (JOB_QUEUE_SIZE - 1)]);
+	if (bottom == top) {
+		// the last job, race the thieves for it
+		if (!AtomicCompareExchangeU64(&queue->top, top, top + 1)) {
+			job = 0;
+		}
+		AtomicStoreU64(&queue->bottom, top + 1);
+	}
+	return job;
+}
+
+// Any thread, takes the oldest job
+// RETURNS: 0 if the queue is empty or another thread got the job first
+static Job *JobQueue_Steal(JobQueue *queue) {
+	u64 top = AtomicLoadU64(&queue->top);
+	AtomicFence();
+	u64 bottom = AtomicLoadU64(&queue->bottom);
+	if ((i64)(bottom - top) <= 0) {
+		return 0;
+	}
+
+	Job *job = (Job*)(uintptr_t)AtomicLoadU64(&queue->slots[top & (JOB_QUEUE_SIZE - 1)]);
+	if (!AtomicCompareExchangeU64(&queue->top, top, top + 1)) {
+		return 0;
+	}
+	return job;
+}
+
+static b8 JobQueue_HasWork(JobQueue *queue) {
+	return (i64)(AtomicLoadU64(&queue->bottom) - AtomicLoadU64(&queue->top)) > 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////
+/// Scheduling
+///
+
+// RETURNS: the deque of the calling thread, -1 if it doesn't have one
+static i32 JobSystem_ThreadQueue(JobSystem *system) {
+	if (gJobThread.system_id != system->id) {
+		u32 external_index = AtomicFetchAddU32(&system->external_thread_count, 1);
+		gJobThread.system_id = system->id;
+		gJobThread.queue_index = external_index < JOB_SYSTEM_MAX_EXTERNAL_THREADS ?
+			system->worker_count + (i32)external_index : -1;
+		gJobThread.random_state = 0x9E3779B9u * (u32)(gJobThread.queue_index + 2);
+	}
+	return gJobThread.queue_index;
+}
+
+static i32 JobSystem_QueueCount(JobSystem *system) {
+	u32 external_count = AtomicLoadU32(&system->external_thread_count);
+	if (external_count > JOB_SYSTEM_MAX_EXTERNAL_THREADS) {
+		external_count = JOB_SYSTEM_MAX_EXTERNAL_THREADS;
+	}
+	return system->worker_count + (i32)external_count;
+}
+
+// Own deque first, then the others starting from a random one
+static Job *JobSystem_FindJob(JobSystem *system, i32 queue_index) {
+	if (queue_index >= 0) {
+		Job *job = JobQueue_Pop(&system->queues[queue_index]);
+		if (job) {
+			return job;
+		}
+	}
+
+	i32 queue_count = JobSystem_QueueCount(system);
+	if (queue_count == 0) {
+		return 0;
+	}
+	// xorshift32
+	u32 random = gJobThread.random_state;
+	random ^= random << 13;
+	random ^= random >> 17;
+	random ^= random << 5;
+	gJobThread.random_state = random;
+
+	i32 first_victim = (i32)(random % (u32)queue_count);
+	for (i32 i = 0; i < queue_count; i++) {
+		i32 victim = (first_victim + i) % queue_count;
+		if (victim == queue_index) {
+			continue;
+		}
+		Job *job = JobQueue_Steal(&system->queues[victim]);
+		if (job) {
+			return job;
+		}
+	}
+	return 0;
+}
+
+static b8 JobSystem_HasWork(JobSystem *system) {
+	i32 queue_count = JobSystem_QueueCount(system);
+	for (i32 i = 0; i < queue_count; i++) {
+		if (JobQueue_HasWork(&system->queues[i])) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+static void JobSystem_RunJob(Job *job) {
+	// the job can go away as soon as the counter drops, read it first
+	JobCounter *counter = job->counter;
+	job->function(job->data, job->begin, job->end);
+	AtomicFetchAddU32(&counter->pending, (u32)-1);
+}
+
+static void JobSystem_Sleep(JobSystem *system) {
+#if _WIN32
+	WaitForSingleObject(system->work_available, INFINITE);
+#else
+	while (sem_wait(&system->work_available) != 0) {
+		// EINTR, try again
+	}
+#endif
+}
+
+static void JobSystem_WakeOne(JobSystem *system) {
+	// the job that was just pushed has to be visible before sleeping_count
+	// is read, see JobSystem_WorkerLoop
+	AtomicFence();
+	for (;;) {
+		u32 sleeping_count = AtomicLoadU32(&system->sleeping_count);
+		if (!sleeping_count) {
+			return;
+		}
+		if (AtomicCompareExchangeU32(&system->sleeping_count, sleeping_count, sleeping_count - 1)) {
+			break;
+		}
+	}
+#if _WIN32
+	ReleaseSemaphore(system->work_available, 1, 0);
+#else
+	sem_post(&system->work_available);
+#endif
+}
+
+static void JobSystem_WorkerLoop(JobSystem *system, i32 queue_index) {
+	for (;;) {
+		Job *job = JobSystem_FindJob(system, queue_index);
+		if (job) {
+			JobSystem_RunJob(job);
+			continue;
+		}
+		if (AtomicLoadU32(&system->stop)) {
+			break;
+		}
+
+		// announce the sleep first and look for work again after, so a job
+		// pushed in between either gets seen here or wakes this thread up
+		AtomicFetchAddU32(&system->sleeping_count, 1);
+		if (JobSystem_HasWork(system) || AtomicLoadU32(&system->stop)) {
+			// take the announcement back, unless a submitter already handed
+			// out a wakeup for it
+			b8 taken_back = 0;
+			for (;;) {
+				u32 sleeping_count = AtomicLoadU32(&system->sleeping_count);
+				if (!sleeping_count) {
+					break;
+				}
+				if (AtomicCompareExchangeU32(&system->sleeping_count, sleeping_count, sleeping_count - 1)) {
+					taken_back = 1;
+					break;
+				}
+			}
+			if (!taken_back) {
+				JobSystem_Sleep(system);
+			}
+			continue;
+		}
+		JobSystem_Sleep(system);
+	}
+}
+
+#if _WIN32
+static DWORD WINAPI JobSystem_Worker(LPVOID parameter) {
+#else
+static void *JobSystem_Worker(void *parameter) {
+#endif
+	JobWorker *worker = (JobWorker*)parameter;
+	gJobThread.system_id = worker->system->id;
+	gJobThread.queue_index = worker->queue_index;
+	gJobThread.random_state = 0x9E3779B9u * (u32)(worker->queue_index + 2);
+	JobSystem_WorkerLoop(worker->system, worker->queue_index);
+	return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////
+/// API
+///
+
+// Every job has to be finished
+void JobSystem_Stop(JobSystem *system) {
+	AtomicExchangeU32(&system->stop, 1);
+	for (i32 i = 0; i < system->worker_count; i++) {
+#if _WIN32
+		ReleaseSemaphore(system->work_available, 1, 0);
+#else
+		sem_post(&system->work_available);
+#endif
+	}
+	for (i32 i = 0; i < system->worker_count; i++) {
+#if _WIN32
+		WaitForSingleObject(system->workers[i].thread, INFINITE);
+		CloseHandle(system->workers[i].thread);
+#else
+		pthread_join(system->workers[i].thread, 0);
+#endif
+	}
+#if _WIN32
+	CloseHandle(system->work_available);
+#else
+	sem_destroy(&system->work_available);
+#endif
+	system->worker_count = 0;
+	// threads holding on to the old id look their queue up again
+	system->id = 0;
+}
+
+// worker_count can be 0, then every job runs on the threads that wait on it
+// RETURNS: 1 on success
+b8 JobSystem_Start(JobSystem *system, i32 worker_count) {
+	if (worker_count < 0) {
+		worker_count = 0;
+	} else if (worker_count > JOB_SYSTEM_MAX_WORKERS) {
+		worker_count = JOB_SYSTEM_MAX_WORKERS;
+	}
+
+	system->id = AtomicFetchAddU32(&gNextJobSystemId, 1) + 1;
+	system->worker_count = worker_count;
+	system->external_thread_count = 0;
+	system->sleeping_count = 0;
+	system->stop = 0;
+	for (i32 i = 0; i < JOB_SYSTEM_MAX_QUEUES; i++) {
+		system->queues[i].top = 0;
+		system->queues[i].bottom = 0;
+	}
+
+#if _WIN32
+	system->work_available = CreateSemaphoreA(0, 0, MAXLONG, 0);
+	if (!system->work_available) {
+		system->worker_count = 0;
+		return 0;
+	}
+#else
+	if (sem_init(&system->work_available, 0, 0) != 0) {
+		system->worker_count = 0;
+		return 0;
+	}
+#endif
+
+	// the queues are laid out before any worker can steal from them
+	AtomicFence();
+	i32 started_count = 0;
+	for (i32 i = 0; i < worker_count; i++) {
+		JobWorker *worker = system->workers + i;
+		worker->system = system;
+		worker->queue_index = i;
+#if _WIN32
+		worker->thread = CreateThread(0, 0, JobSystem_Worker, worker, 0, 0);
+		b8 started = worker->thread != 0;
+#else
+		b8 started = pthread_create(&worker->thread, 0, JobSystem_Worker, worker) == 0;
+#endif
+		if (!started) {
+			break;
+		}
+		started_count += 1;
+	}
+
+	if (started_count != worker_count) {
+		// queues of workers that never started would never be drained by
+		// their owner, so shut down the ones that did
+		system->worker_count = started_count;
+		JobSystem_Stop(system);
+		return 0;
+	}
+	return 1;
+}
+
+// job has to stay where it is until counter drops to zero, counter starts at zero
+void Job_Submit(JobSystem *system, Job *job, JobCounter *counter) {
+	job->counter = counter;
+	AtomicFetchAddU32(&counter->pending, 1);
+
+	i32 queue_index = JobSystem_ThreadQueue(system);
+	if (queue_index < 0 || !JobQueue_Push(&system->queues[queue_index], job)) {
+		JobSystem_RunJob(job);
+		return;
+	}
+	JobSystem_WakeOne(system);
+}
+
+// Runs jobs, any jobs, until every job submitted on counter is done
+void Job_Wait(JobSystem *system, JobCounter *counter) {
+	i32 queue_index = JobSystem_ThreadQueue(system);
+	i32 idle_spins = 0;
+	while (AtomicLoadU32(&counter->pending)) {
+		Job *job = JobSystem_FindJob(system, queue_index);
+		if (job) {
+			JobSystem_RunJob(job);
+			idle_spins = 0;
+		} else if (++idle_spins < 64) {
+			// the last jobs are running on other threads
+			_mm_pause();
+		} else {
+			Platform_YieldThread();
+		}
+	}
+}
+
+typedef struct {
+	ParallelForFunction *function;
+	void *data;
+} ParallelForJobData;
+
+static void ParallelFor_RunRange(void *data, i32 begin, i32 end) {
+	ParallelForJobData *job_data = (ParallelForJobData*)data;
+	for (i32 index = begin; index < end; index++) {
+		job_data->function(job_data->data, index);
+	}
+}
+
+// Calls function(data, begin, end) over [0, count) in ranges of at least
+// batch_size indices, in no particular order, and returns once they are done.
+// Can be called from inside a job.
+void ParallelForRange(JobSystem *system, i32 count, i32 batch_size, JobFunction *function, void *data) {
+	if (count <= 0) {
+		return;
+	}
+	if (batch_size < 1) {
+		batch_size = 1;
+	}
+	if (system->worker_count == 0) {
+		function(data, 0, count);
+		return;
+	}
+
+	i32 job_count = (count + batch_size - 1) / batch_size;
+	if (job_count > PARALLEL_FOR_MAX_JOBS) {
+		job_count = PARALLEL_FOR_MAX_JOBS;
+		batch_size = (count + job_count - 1) / job_count;
+		job_count = (count + batch_size - 1) / batch_size;
+	}
+
+	Job jobs[PARALLEL_FOR_MAX_JOBS];
+	JobCounter counter = {0};
+	for (i32 i = 0; i < job_count; i++) {
+		jobs[i].function = function;
+		jobs[i].data = data;
+		jobs[i].begin = i * batch_size;
+		jobs[i].end = jobs[i].begin + batch_size < count ? jobs[i].begin + batch_size : count;
+		Job_Submit(system, jobs + i, &counter);
+	}
+	Job_Wait(system, &counter);
+}
+
+// Calls function(data, i) for every i in [0, count), one index per job
+void ParallelFor(JobSystem *system, i32 count, ParallelForFunction *function, void *data) {
+	ParallelForJobData job_data = {0};
+	job_data.function = function;
+	job_data.data = data;
+	ParallelForRange(system, count, 1, ParallelFor_RunRange, &job_data);
+}
+
+#endif
@@ -0,0 +1,131 @@
+#ifndef ASTEROIDS_PROFILE_H
+#define ASTEROIDS_PROFILE_H
+
+#include "base.h"
+
+// Hot path timers.
+//
+// BEGIN_TIMED_BLOCK/END_TIMED_BLOCK read the time stamp counter around a
+// phase of the frame and add the elapsed cycles to that phase for the
+// current frame. Profile_EndFrame moves the frame into a ring buffer of the
+// last PROFILE_FRAME_COUNT frames.
+//
+// Blocks can be timed on any thread, the cycles are added atomically and
+// count towards whichever frame is being profiled when the block ends.
+//
+// Build with -DPROFILE=0 (/DPROFILE=0) to compile every timer out.
+
+#ifndef PROFILE
+#define PROFILE 1
+#endif
+
+#define PROFILE_FRAME_COUNT 128
+
+typedef enum {
+	TimedBlock_ShipTransform,
+	TimedBlock_MissileUpdate,
+	TimedBlock_ClearBackground,
+	TimedBlock_ShipDraw,
+	TimedBlock_MissileRaster,
+	TimedBlock_MeteorUpdate,
+	TimedBlock_MeteorDraw,
+	TimedBlock_MeteorBounce,
+	TimedBlock_Collision,
+	TimedBlock_HudText,
+	TimedBlock_RenderCommands,
+
+	TimedBlock_Count
+} TimedBlock;
+
+static char *TimedBlockNames[TimedBlock_Count] = {
+	"Ship Transform",
+	"Missile Update",
+	"Clear Background",
+	"Ship Draw",
+	"Missile Raster",
+	"Meteor Update",
+	"Meteor Draw",
+	"Meteor Bounce",
+	"Collision",
+	"HUD Text",
+	"Render Commands",
+};
+
+typedef struct {
+	u64 block_cycles[TimedBlock_Count];
+	u64 frame_cycles;
+	f32 frame_seconds;
+} ProfileFrame;
+
+typedef struct {
+	ProfileFrame frames[PROFILE_FRAME_COUNT];
+	i32 next_frame_index;
+	i32 frame_count; // saturates at PROFILE_FRAME_COUNT
+
+	volatile u64 current_block_cycles[TimedBlock_Count];
+	u64 current_begin_cycles;
+
+	// totals over every profiled frame, used for end of run reports and
+	// to convert cycles to seconds without calibrating the counter
+	u64 total_block_cycles[TimedBlock_Count];
+	u64 total_cycles;
+	f64 total_seconds;
+	u64 total_frames;
+} Profile;
+
+static Profile gProfile = {0};
+
+#if PROFILE
+
+#define BEGIN_TIMED_BLOCK(ID) u64 BlockBeginCycles_##ID = __rdtsc()
+#define END_TIMED_BLOCK(ID) AtomicAddU64(&gProfile.current_block_cycles[TimedBlock_##ID], __rdtsc() - BlockBeginCycles_##ID)
+
+void Profile_BeginFrame() {
+	gProfile.current_begin_cycles = __rdtsc();
+}
+
+// frame_seconds is the wall clock time the platform layer measured for the frame
+void Profile_EndFrame(f32 frame_seconds) {
+	ProfileFrame *frame = gProfile.frames + gProfile.next_frame_index;
+	frame->frame_cycles = __rdtsc() - gProfile.current_begin_cycles;
+	frame->frame_seconds = frame_seconds;
+
+	for (i32 i = 0; i < TimedBlock_Count; i++) {
+		frame->block_cycles[i] = AtomicExchangeU64(&gProfile.current_block_cycles[i], 0);
+		gProfile.total_block_cycles[i] += frame->block_cycles[i];
+	}
+	gProfile.total_cycles += frame->frame_cycles;
+	gProfile.total_seconds += frame_seconds;
+	gProfile.total_frames += 1;
+
+	gProfile.next_frame_index = (gProfile.next_frame_index + 1) % PROFILE_FRAME_COUNT;
+	if (gProfile.frame_count < PROFILE_FRAME_COUNT) {
+		gProfile.frame_count += 1;
+	}
+}
+
+#else
+
+#define BEGIN_TIMED_BLOCK(ID)
+#define END_TIMED_BLOCK(ID)
+
+#define Profile_BeginFrame()
+#define Profile_EndFrame(frame_seconds)
+
+#endif
+
+// RETURNS: 0 until a frame with a measured wall clock time has been profiled
+f64 Profile_SecondsPerCycle() {
+	if (gProfile.total_cycles == 0 || gProfile.total_seconds <= 0.0) {
+		return 0.0;
+	}
+	return gProfile.total_seconds / (f64)gProfile.total_cycles;
+}
+
+// i = 0 is the most recent frame
+ProfileFrame *Profile_GetFrame(i32 i) {
+	i32 index = (gProfile.next_frame_index - 1 - i + PROFILE_FRAME_COUNT) % PROFILE_FRAME_COUNT;
+	return gProfile.frames + index;
+}
+
+#endif